@@ -179,8 +179,7 @@ void app_main(void)
 
     wifi_init_sta();
 
-    // Add a delay to ensure the client has enough time to connect to the AP
-    vTaskDelay(10000 / portTICK_PERIOD_MS);
+    // udp_client_task waits for an IP by itself, no need to delay start-up
     xTaskCreate(udp_client_task, "udp_client", 4096, NULL, 5, NULL);
     xTaskCreate(button_task, "button_task", 4096, NULL, 5, NULL);
 
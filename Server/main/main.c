@@ -3,17 +3,45 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_random.h"
 #include "nvs_flash.h"
 #include "lwip/sockets.h"
 #include "lwip/netif.h"
 #include <string.h>
+#include <inttypes.h>
 //#include "lvgl/lvgl.h"
 #include "driver/gpio.h"
 
+#include "relay.h"
+#include "mixer.h"
+#include "packet.h"
+#include "hdr_comp.h"
+#include "replay.h"
+#include "cmac.h"
+#include "aes_batch.h"
+#include "chachapoly.h"
+#include "mbedtls/aes.h"
+
 #define EXAMPLE_ESP_WIFI_SSID "esp32_ap"
 #define EXAMPLE_ESP_WIFI_PASS "password"
-#define EXAMPLE_MAX_STA_CONN 4
+#define EXAMPLE_MAX_STA_CONN RELAY_MAX_STATIONS
 #define PORT 1234
+#define RELAY_LOG_PERIOD_MS 10000
+
+// Режим конференції: замість пересилання точка доступу декодує всіх, хто говорить,
+// і відправляє кожній станції суміш без її власного голосу
+//#define CONFERENCE_MODE
+#define CONFERENCE_ENCRYPTION           // Точка доступу вимагає шифрування спільним ключем
+//#define CONFERENCE_CHACHA20_POLY1305    // Як AUDIO_CHACHA20_POLY1305 у пристроях
+#define CONFERENCE_GROUP_ID 1
+#define CONFERENCE_NODE_ID 0xFFFE       // Ідентифікатор точки доступу в заголовках
+#define CONFERENCE_MAX_FRAMES 4         // Кадрів в одному пакеті від станції
+#define SAMPLE_RATE 44100
+#define FRAME_BYTES (MIXER_FRAME_SAMPLES * 2)
+
+#if MIXER_MAX_SOURCES < RELAY_MAX_STATIONS
+#error "Mixer needs a source per relay station"
+#endif
 
 #define BUTTON_GPIO GPIO_NUM_35
 
@@ -111,58 +139,517 @@ static void wifi_init_softap(void)
 }
 
 
-static void udp_server_task(void *pvParameters)
+static relay_t relay;
+
+#ifdef CONFERENCE_MODE
+static const uint8_t aes_key[16] = {
+    0x3d, 0xf2, 0x67, 0xf0, 0x34, 0xa9, 0xbc, 0x0b,
+    0x8e, 0xac, 0xe5, 0x8f, 0x12, 0x3c, 0x56, 0x78
+};
+
+static mixer_t mixer;
+static aes_batch_t aes_enc;
+static aes_batch_t aes_dec;
+static mbedtls_aes_context aes_mac;
+static cmac_t group_cmac;           // Підключі ключа автентифікації пораховано раз: теги CMAC і маяків
+static uint8_t aead_key[CHACHA_KEY_SIZE];   // Груповий ключ і похідний, як у пристроях
+
+static uint8_t conf_body[FRAME_BYTES * 2];
+static int16_t conf_pcm[CONFERENCE_MAX_FRAMES * MIXER_FRAME_SAMPLES];
+static int16_t conf_fec[CONFERENCE_MAX_FRAMES * MIXER_FRAME_SAMPLES];
+static int16_t mix_pcm[RELAY_MAX_STATIONS][MIXER_FRAME_SAMPLES];
+static uint8_t mix_packet[RELAY_MAX_STATIONS][PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE + FRAME_BYTES + PKT_AUDIO_MAC_SIZE];
+static uint16_t mix_seq[RELAY_MAX_STATIONS];
+static hdr_comp_tx_t mix_comp[RELAY_MAX_STATIONS];     // Стиснення заголовків суміші для кожної станції
+static hdr_comp_rx_t station_comp[RELAY_MAX_STATIONS]; // Контексти стиснутих заголовків від станцій
+static replay_table_t replays;      // Запуски і вікна повторів пристроїв, за вузлом, а не місцем станції
+static uint16_t station_node[RELAY_MAX_STATIONS];     // Пристрій, якому належить контекст заголовків
+static bool station_encrypt[RELAY_MAX_STATIONS];      // Станція вимагає шифрування (з маяка)
+static uint8_t beacon_reply_mask;   // Станції, що чекають на маяк точки доступу
+static uint32_t hub_boot_id;
+static uint16_t hub_beacon_seq;
+static uint32_t auth_failures;
+static uint32_t replay_drops;
+static uint32_t unknown_senders;    // Аудіо від пристроїв без автентифікованого маяка
+static uint32_t plain_rejected;
+
+// Відновлення повної частоти лінійною інтерполяцією, як у пристроях
+static void expand_frame(const int16_t *in, size_t length, uint8_t shift, int16_t *out)
 {
-    ESP_LOGE(TAG, "UDP OK");
-    char rx_buffer[128];
-    char addr_str[128];
-    int addr_family = AF_INET;
-    int ip_protocol = IPPROTO_IP;
-    
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(PORT);
-    
-    int sock = socket(addr_family, SOCK_DGRAM, ip_protocol);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-        vTaskDelete(NULL);
+    size_t step = (size_t)1 << shift;
+    for (size_t i = 0; i < length; i++) {
+        int32_t a = in[i];
+        int32_t b = (i + 1 < length) ? in[i + 1] : in[i];
+        for (size_t k = 0; k < step; k++) {
+            out[i * step + k] = (int16_t)(a + ((b - a) * (int32_t)k >> shift));
+        }
+    }
+}
+
+static void expand_frames(const uint8_t *body, const pkt_audio_desc_t *desc, int16_t *out)
+{
+    size_t frame_bytes = FRAME_BYTES >> desc->decim_shift;
+    for (int i = 0; i < desc->frames; i++) {
+        expand_frame((const int16_t *)(body + i * frame_bytes), frame_bytes / 2, desc->decim_shift,
+                     out + i * MIXER_FRAME_SAMPLES);
+    }
+}
+
+static void mac_block(void *ctx, const uint8_t in[CMAC_BLOCK_SIZE], uint8_t out[CMAC_BLOCK_SIZE])
+{
+    mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, in, out);
+}
+
+#ifdef CONFERENCE_CHACHA20_POLY1305
+// Nonce, як у пристроях: вузол, запуск, час і номер пакета
+static void audio_nonce(const pkt_header_t *hdr, uint32_t boot_id, uint8_t nonce[CHACHA_NONCE_SIZE])
+{
+    pkt_put_u16(&nonce[0], hdr->node);
+    pkt_put_u32(&nonce[2], boot_id);
+    pkt_put_u32(&nonce[6], hdr->timestamp);
+    pkt_put_u16(&nonce[10], hdr->seq);
+}
+
+// Тег Poly1305: префікс і хвіст - додаткові дані, кадри - шифротекст (audio_len байт)
+static void audio_mac(const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *desc,
+                      const uint8_t *data, size_t audio_len, size_t len, uint8_t tag[PKT_AUDIO_MAC_SIZE])
+{
+    uint8_t nonce[CHACHA_NONCE_SIZE];
+    uint8_t prefix[PKT_MAC_PREFIX_SIZE];
+    uint8_t full[POLY1305_TAG_SIZE];
+    chachapoly_t c;
+
+    audio_nonce(hdr, boot_id, nonce);
+    chachapoly_start(&c, aead_key, nonce);
+    chachapoly_aad(&c, prefix, pkt_write_mac_prefix(prefix, hdr, desc, boot_id));
+    if (desc->key == PKT_AUDIO_KEY_NONE) {
+        chachapoly_aad(&c, data, len);
+    } else {
+        chachapoly_aad(&c, data + audio_len, len - audio_len);
+        chachapoly_ct(&c, data, audio_len);
+    }
+    chachapoly_finish(&c, full);
+    memcpy(tag, full, PKT_AUDIO_MAC_SIZE);
+}
+#else
+// Тег аудіо пакета, як у пристроях: CMAC від канонічного префікса і всього, що після заголовка
+static void audio_mac(const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *desc,
+                      const uint8_t *data, size_t audio_len, size_t len, uint8_t tag[PKT_AUDIO_MAC_SIZE])
+{
+    uint8_t prefix[PKT_MAC_PREFIX_SIZE];
+    uint8_t full[CMAC_BLOCK_SIZE];
+
+    cmac_update(&group_cmac, prefix, pkt_write_mac_prefix(prefix, hdr, desc, boot_id));
+    cmac_update(&group_cmac, data, len);
+    cmac_finish(&group_cmac, full);
+    memcpy(tag, full, PKT_AUDIO_MAC_SIZE);
+}
+#endif
+
+static bool audio_mac_ok(const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *desc,
+                         const uint8_t *data, size_t audio_len, size_t len, const uint8_t *tag)
+{
+    uint8_t expected[PKT_AUDIO_MAC_SIZE];
+    uint8_t diff = 0;
+
+    audio_mac(hdr, boot_id, desc, data, audio_len, len, expected);
+    for (int i = 0; i < PKT_AUDIO_MAC_SIZE; i++) {
+        diff |= expected[i] ^ tag[i];
+    }
+    return diff == 0;
+}
+
+// Тег службового пакета, як у пристроях: CMAC груповим ключем і в режимі ChaCha20-Poly1305
+static void control_tag(const pkt_header_t *hdr, uint32_t boot_id, const uint8_t *payload, size_t len,
+                        uint8_t tag[PKT_CONTROL_MAC_SIZE])
+{
+    uint8_t prefix[PKT_CONTROL_PREFIX_SIZE];
+    uint8_t full[CMAC_BLOCK_SIZE];
+
+    cmac_update(&group_cmac, prefix, pkt_write_control_prefix(prefix, hdr, boot_id));
+    cmac_update(&group_cmac, payload, len);
+    cmac_finish(&group_cmac, full);
+    memcpy(tag, full, PKT_CONTROL_MAC_SIZE);
+}
+
+// Маяк станції: тег тим запуском, що в маяку, і вікно маяків пристрою. Лише
+// такий маяк заводить пристрою вікна повторів або скидає їх на новий запуск;
+// маяк запуску, що вже змінився, - записаний і відкидається
+static bool station_beacon_ok(const pkt_header_t *hdr, const uint8_t *data, size_t len,
+                              pkt_beacon_t *beacon, bool *restarted, uint32_t now_ms)
+{
+    uint8_t expected[PKT_CONTROL_MAC_SIZE];
+    uint8_t diff = 0;
+
+    if (len < PKT_BEACON_SIZE + PKT_CONTROL_MAC_SIZE || !pkt_read_beacon(data, len - PKT_CONTROL_MAC_SIZE, beacon)) {
+        return false;
+    }
+    len -= PKT_CONTROL_MAC_SIZE;
+    replay_boot_t boot = replay_table_check_boot(&replays, hdr->node, beacon->boot_id);
+    if (boot == REPLAY_BOOT_STALE) {
+        replay_drops++;
+        return false;
+    }
+    replay_node_t *sender = replay_table_find(&replays, hdr->node);
+    if (boot == REPLAY_BOOT_SAME && replay_check(&sender->beacon, hdr->seq, hdr->timestamp) != REPLAY_OK) {
+        replay_drops++;
+        return false;
+    }
+    control_tag(hdr, beacon->boot_id, data, len, expected);
+    for (int i = 0; i < PKT_CONTROL_MAC_SIZE; i++) {
+        diff |= expected[i] ^ data[len + i];
+    }
+    if (diff != 0) {
+        auth_failures++;
+        return false;
+    }
+    sender = replay_table_set_boot(&replays, hdr->node, beacon->boot_id, now_ms);
+    replay_accept(&sender->beacon, hdr->seq, hdr->timestamp);
+    *restarted = boot == REPLAY_BOOT_NEW;
+    return true;
+}
+
+// Станція перезапустилась або її місце зайняв інший пристрій: старий контекст заголовків не діє
+static void station_reset(int station, uint16_t node)
+{
+    hdr_comp_rx_init(&station_comp[station]);
+    station_node[station] = node;
+}
+
+// Аудіо від станції - у її джиттер-буфер
+static void conference_rx(void *ctx, int station, uint8_t *packet, size_t packet_len, uint32_t now_ms)
+{
+    pkt_header_t hdr;
+    pkt_audio_desc_t desc;
+    pkt_compact_t compact;
+    uint8_t *data;
+    size_t len;
+
+    if (pkt_read_compact(packet, packet_len, &compact)) {
+        if (!hdr_comp_rx_expand(&station_comp[station], &compact, now_ms, &hdr, &desc)) {
+            return;
+        }
+        data = packet + PKT_COMPACT_SIZE;
+        len = packet_len - PKT_COMPACT_SIZE;
+    } else if (pkt_read_header(packet, packet_len, &hdr)) {
+        data = packet + PKT_HEADER_SIZE;
+        len = packet_len - PKT_HEADER_SIZE;
+        if (hdr.type == PKT_TYPE_AUDIO) {
+            if (!pkt_read_audio_desc(data, len, &desc)) {
+                return;
+            }
+            data += PKT_AUDIO_DESC_SIZE;
+            len -= PKT_AUDIO_DESC_SIZE;
+        }
+    } else {
         return;
     }
-    
-    int err = bind(sock, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err < 0) {
-        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
-        close(sock);
-        vTaskDelete(NULL);
+    if (hdr.type == PKT_TYPE_BEACON) {
+        // Станції шукають співрозмовників маяками - відповідаємо за всю конференцію
+        pkt_beacon_t beacon;
+        bool restarted;
+        if (!station_beacon_ok(&hdr, data, len, &beacon, &restarted, now_ms)) {
+            return;
+        }
+        station_encrypt[station] = (beacon.caps & PKT_CAP_ENCRYPTED) != 0;
+        if (restarted) {
+            station_reset(station, hdr.node);
+        }
+        beacon_reply_mask |= (uint8_t)(1u << station);
+        return;
+    }
+    if (hdr.type != PKT_TYPE_AUDIO) {
+        return;
+    }
+    if (hdr.group != CONFERENCE_GROUP_ID && hdr.group != PKT_GROUP_ANY) {
+        return;
+    }
+    // Точка доступу знає лише груповий ключ: сеансові ключі станції їй не роздають
+    if (desc.frames > CONFERENCE_MAX_FRAMES ||
+        (desc.key != PKT_AUDIO_KEY_GROUP && desc.key != PKT_AUDIO_KEY_NONE)) {
         return;
     }
+#ifdef CONFERENCE_ENCRYPTION
+    // Станція ще не отримала наш маяк з вимогою шифрування
+    if (desc.key == PKT_AUDIO_KEY_NONE) {
+        plain_rejected++;
+        return;
+    }
+#endif
 
-    ESP_LOGI(TAG, "UDP server started");
+    size_t body_len = (FRAME_BYTES >> desc.decim_shift) * desc.frames;
+    size_t audio_len = body_len * (desc.fec ? 2 : 1);
+    if (audio_len > sizeof(conf_body) || len < audio_len + PKT_AUDIO_MAC_SIZE) {
+        return;
+    }
+    len -= PKT_AUDIO_MAC_SIZE;
 
-    while (1) {
-        ESP_LOGI(TAG, "Waiting for data");
-        struct sockaddr_in source_addr;
-        socklen_t socklen = sizeof(source_addr);
-        int len = recvfrom(sock, rx_buffer, sizeof(rx_buffer) - 1, 0, (struct sockaddr *)&source_addr, &socklen);
-        
-        if (len < 0) {
-            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
-            break;
+    // Повтор і підробка відкидаються до дешифрування і обробки звуку. Вікно - пристрою,
+    // а не місця станції: воно переживає і перепідключення, і зміну адреси
+    replay_node_t *sender = replay_table_find(&replays, hdr.node);
+    if (sender == NULL) {
+        unknown_senders++;
+        return;
+    }
+    if (replay_check(&sender->audio, hdr.seq, hdr.timestamp) != REPLAY_OK) {
+        replay_drops++;
+        return;
+    }
+    if (!audio_mac_ok(&hdr, sender->boot_id, &desc, data, audio_len, len, data + len)) {
+        auth_failures++;
+        return;
+    }
+    if (station_node[station] != hdr.node) {
+        station_reset(station, hdr.node);
+    }
+    replay_accept(&sender->audio, hdr.seq, hdr.timestamp);
+    sender->last_ms = now_ms;
+    hdr_comp_rx_update(&station_comp[station], &hdr, now_ms);
+
+    // Службові повідомлення в хвості пакета адресовані пристроям, не точці доступу
+    len = audio_len;
+
+    // Режим шифрування - з опису пакета
+    if (desc.key == PKT_AUDIO_KEY_NONE) {
+        memcpy(conf_body, data, len);
+    } else {
+#ifdef CONFERENCE_CHACHA20_POLY1305
+        uint8_t nonce[CHACHA_NONCE_SIZE];
+        audio_nonce(&hdr, sender->boot_id, nonce);
+        memcpy(conf_body, data, len);
+        chacha20_xor(aead_key, nonce, 1, conf_body, len);
+#else
+        aes_batch_crypt(&aes_dec, data, conf_body, len);
+#endif
+    }
+    expand_frames(conf_body, &desc, conf_pcm);
+    if (desc.fec) {
+        expand_frames(conf_body + body_len, &desc, conf_fec);
+    }
+    mixer_put_packet(&mixer, station, hdr.seq, desc.frames, conf_pcm, desc.fec ? conf_fec : NULL);
+}
+
+static void send_beacons(uint32_t now_ms)
+{
+    uint8_t buf[PKT_HEADER_SIZE + PKT_BEACON_SIZE + PKT_CONTROL_MAC_SIZE];
+    pkt_beacon_t beacon = {
+        .version = PKT_BEACON_VERSION,
+        .codec = PKT_CODEC_PCM16,
+#ifdef CONFERENCE_ENCRYPTION
+        .caps = PKT_CAP_AES | PKT_CAP_ENCRYPTED,
+#else
+        .caps = 0,
+#endif
+        .max_decim_shift = PKT_AUDIO_DECIM_MASK,
+        .rate_level = 0,
+        .sample_rate = SAMPLE_RATE,
+        .boot_id = hub_boot_id
+    };
+
+    if (beacon_reply_mask == 0) {
+        return;
+    }
+    // Один маяк усім, хто чекає: номер росте, щоб станції могли відкидати записані
+    pkt_header_t hdr = {
+        .type = PKT_TYPE_BEACON,
+        .group = CONFERENCE_GROUP_ID,
+        .node = CONFERENCE_NODE_ID,
+        .seq = hub_beacon_seq++,
+        .timestamp = now_ms
+    };
+    size_t len = pkt_write_header(buf, &hdr);
+    len += pkt_write_beacon(buf + len, &beacon);
+    control_tag(&hdr, hub_boot_id, buf + PKT_HEADER_SIZE, len - PKT_HEADER_SIZE, buf + len);
+    len += PKT_CONTROL_MAC_SIZE;
+
+    for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+        if (beacon_reply_mask & (1u << i)) {
+            relay_send(&relay, i, buf, len);
+        }
+    }
+    beacon_reply_mask = 0;
+}
+
+// Кадр суміші для кожної станції, викликається раз на період кадру
+static void conference_tick(uint32_t now_ms)
+{
+    send_beacons(now_ms);
+
+    if (mixer_tick(&mixer) == 0) {
+        return;
+    }
+
+    pkt_header_t hdr[RELAY_MAX_STATIONS];
+    pkt_audio_desc_t desc[RELAY_MAX_STATIONS];
+    size_t hdr_len[RELAY_MAX_STATIONS];
+    aes_batch_seg_t segs[RELAY_MAX_STATIONS];
+    uint8_t ready = 0;
+    int seg_count = 0;
+
+    for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+        if (!relay.stations[i].used || !mixer_output(&mixer, i, mix_pcm[i])) {
+            continue;
+        }
+        hdr[i] = (pkt_header_t){
+            .type = PKT_TYPE_AUDIO,
+            .group = CONFERENCE_GROUP_ID,
+            .node = CONFERENCE_NODE_ID,
+            .seq = mix_seq[i]++,
+            .timestamp = now_ms
+        };
+        desc[i] = (pkt_audio_desc_t){ .decim_shift = 0, .frames = 1, .fec = false };
+        // Шифрування, якщо його вимагає точка доступу або сама станція
+#ifdef CONFERENCE_ENCRYPTION
+        desc[i].key = PKT_AUDIO_KEY_GROUP;
+#else
+        desc[i].key = station_encrypt[i] ? PKT_AUDIO_KEY_GROUP : PKT_AUDIO_KEY_NONE;
+#endif
+        hdr_len[i] = hdr_comp_write(&mix_comp[i], mix_packet[i], &hdr[i], &desc[i]);
+        if (desc[i].key == PKT_AUDIO_KEY_NONE) {
+            memcpy(mix_packet[i] + hdr_len[i], mix_pcm[i], FRAME_BYTES);
         } else {
-            inet_ntoa_r(source_addr.sin_addr, addr_str, sizeof(addr_str) - 1);
-            rx_buffer[len] = 0; // Null-terminate whatever we received and treat it like a string
-            ESP_LOGI(TAG, "Received %d bytes from %s:", len, addr_str);
-            ESP_LOGI(TAG, "%s", rx_buffer);
+#ifdef CONFERENCE_CHACHA20_POLY1305
+            uint8_t nonce[CHACHA_NONCE_SIZE];
+            audio_nonce(&hdr[i], hub_boot_id, nonce);
+            memcpy(mix_packet[i] + hdr_len[i], mix_pcm[i], FRAME_BYTES);
+            chacha20_xor(aead_key, nonce, 1, mix_packet[i] + hdr_len[i], FRAME_BYTES);
+#else
+            segs[seg_count++] = (aes_batch_seg_t){
+                .in = (const uint8_t *)mix_pcm[i], .out = mix_packet[i] + hdr_len[i], .len = FRAME_BYTES
+            };
+#endif
         }
+        ready |= (uint8_t)(1u << i);
+    }
+
+    // Суміші всіх станцій - одним викликом шифрування
+    if (seg_count > 0) {
+        aes_batch_run(&aes_enc, segs, seg_count);
+    }
+
+    for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+        if (!(ready & (1u << i))) {
+            continue;
+        }
+        size_t len = hdr_len[i] + FRAME_BYTES;
+        audio_mac(&hdr[i], hub_boot_id, &desc[i], mix_packet[i] + hdr_len[i], FRAME_BYTES, FRAME_BYTES,
+                  mix_packet[i] + len);
+        len += PKT_AUDIO_MAC_SIZE;
+        relay_send(&relay, i, mix_packet[i], len);
+    }
+}
+
+static void conference_init(void)
+{
+    mixer_init(&mixer);
+    for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+        hdr_comp_tx_init(&mix_comp[i]);
+        hdr_comp_rx_init(&station_comp[i]);
+    }
+    aes_batch_init(&aes_enc);
+    aes_batch_init(&aes_dec);
+    aes_batch_setkey(&aes_enc, aes_key, AES_BATCH_ENCRYPT);
+    aes_batch_setkey(&aes_dec, aes_key, AES_BATCH_DECRYPT);
+
+    // Ключ автентифікації виводиться з групового ключа так само, як у пристроях
+    static const uint8_t mac_label[16] = "WT audio MAC key";
+    uint8_t mac_key[16];
+    mbedtls_aes_init(&aes_mac);
+    aes_batch_crypt(&aes_enc, mac_label, mac_key, sizeof(mac_label));
+    mbedtls_aes_setkey_enc(&aes_mac, mac_key, 128);
+#ifdef CONFERENCE_CHACHA20_POLY1305
+    memcpy(aead_key, aes_key, sizeof(aes_key));
+    memcpy(aead_key + sizeof(aes_key), mac_key, sizeof(mac_key));
+#endif
+    cmac_init(&group_cmac, mac_block, &aes_mac);
+    memset(mac_key, 0, sizeof(mac_key));
+    replay_table_init(&replays);
+    hub_boot_id = esp_random() | 1;
+    relay_set_rx(&relay, conference_rx, NULL);
+}
+#endif
+
+// Ретрансляція аудіо між станціями точки доступу
+static void udp_server_task(void *pvParameters)
+{
+    if (relay_init(&relay, PORT) < 0) {
+        ESP_LOGE(TAG, "Unable to create relay socket: errno %d", errno);
+        vTaskDelete(NULL);
+        return;
     }
 
-    if (sock != -1) {
-        ESP_LOGE(TAG, "Shutting down socket and restarting...");
-        shutdown(sock, 0);
-        close(sock);
+    ESP_LOGI(TAG, "UDP relay started on port %d", PORT);
+
+#ifdef CONFERENCE_MODE
+    conference_init();
+    ESP_LOGI(TAG, "Conference mixing enabled");
+
+    // Моменти кадрів рахуються від початку, щоб похибка округлення не накопичувалась
+    uint32_t tick_base_ms = relay_now_ms();
+    uint32_t tick_count = 0;
+    uint32_t next_tick_ms = tick_base_ms;
+#endif
+
+    uint32_t last_log_ms = relay_now_ms();
+    int last_stations = 0;
+    while (relay.running) {
+        int wait_ms = RELAY_LOG_PERIOD_MS;
+#ifdef CONFERENCE_MODE
+        int32_t left = (int32_t)(next_tick_ms - relay_now_ms());
+        wait_ms = left < 0 ? 0 : left;
+#endif
+        if (relay_poll(&relay, wait_ms) < 0) {
+            ESP_LOGE(TAG, "select failed: errno %d", errno);
+            break;
+        }
+
+#ifdef CONFERENCE_MODE
+        uint32_t tick_now = relay_now_ms();
+        if ((int32_t)(tick_now - next_tick_ms) >= 0) {
+            conference_tick(tick_now);
+            tick_count++;
+            next_tick_ms = tick_base_ms + (uint32_t)((uint64_t)tick_count * MIXER_FRAME_SAMPLES * 1000 / SAMPLE_RATE);
+            // Задача надовго відстала - пропущені кадри не наздоганяємо
+            if ((int32_t)(tick_now - next_tick_ms) > 0) {
+                tick_base_ms = tick_now;
+                tick_count = 0;
+                next_tick_ms = tick_now;
+            }
+        }
+#endif
+
+        if (relay.station_count != last_stations) {
+            last_stations = relay.station_count;
+            ESP_LOGI(TAG, "Relay stations: %d", last_stations);
+        }
+
+        uint32_t now = relay_now_ms();
+        if ((uint32_t)(now - last_log_ms) >= RELAY_LOG_PERIOD_MS) {
+            last_log_ms = now;
+            ESP_LOGI(TAG, "Relay: rx %" PRIu32 ", forwarded %" PRIu32 ", errors %" PRIu32
+                     ", overflows %" PRIu32 ", rejected %" PRIu32,
+                     relay.rx_packets, relay.forwarded, relay.tx_errors,
+                     relay.pool_overflows, relay.rejected);
+#ifdef CONFERENCE_MODE
+            for (int i = 0; i < MIXER_MAX_SOURCES; i++) {
+                const mixer_source_t *src = &mixer.src[i];
+                if (src->frames_in > 0) {
+                    ESP_LOGI(TAG, "Source %d: frames %" PRIu32 ", late %" PRIu32 ", concealed %" PRIu32 ", resyncs %" PRIu32,
+                             i, src->frames_in, src->late, src->concealed, src->resyncs);
+                }
+            }
+            ESP_LOGI(TAG, "Mixer: limiter %" PRId32 "/32768, clipped frames %" PRIu32, mixer.limiter_q15, mixer.clipped);
+            if (auth_failures > 0 || replay_drops > 0 || unknown_senders > 0 || plain_rejected > 0) {
+                ESP_LOGW(TAG, "Rejected packets: %" PRIu32 " failed authentication, %" PRIu32 " replayed (%" PRIu32 " old boots), "
+                         "%" PRIu32 " from unknown senders, %" PRIu32 " plaintext",
+                         auth_failures, replay_drops, replays.stale_boots, unknown_senders, plain_rejected);
+            }
+#endif
+        }
     }
+
+    ESP_LOGE(TAG, "Shutting down relay socket");
+    relay_close(&relay);
     vTaskDelete(NULL);
 }
 
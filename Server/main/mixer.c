@@ -0,0 +1,168 @@
+#include <string.h>
+
+#include "mixer.h"
+
+void mixer_init(mixer_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    for (int i = 0; i < MIXER_MAX_SOURCES; i++) {
+        m->src[i].gain_q8 = MIXER_GAIN_UNITY;
+    }
+    m->limiter_q15 = MIXER_LIMITER_UNITY;
+}
+
+void mixer_set_gain(mixer_t *m, int src, int32_t gain_q8)
+{
+    if (src >= 0 && src < MIXER_MAX_SOURCES) {
+        m->src[src].gain_q8 = gain_q8;
+    }
+}
+
+static void put_frame(mixer_source_t *s, uint32_t idx, const int16_t *pcm)
+{
+    // Запізнілий кадр - його місце в суміші вже пройдено
+    if ((int32_t)(idx - s->play_idx) < 0) {
+        s->late++;
+        return;
+    }
+    // Джерело втекло вперед (пачка пакетів або різниця тактових частот)
+    if ((int32_t)(idx - s->play_idx) >= MIXER_JB_FRAMES) {
+        s->play_idx = idx - MIXER_JB_PREFILL;
+        s->resyncs++;
+    }
+
+    mixer_slot_t *slot = &s->slots[idx % MIXER_JB_FRAMES];
+    slot->valid = true;
+    slot->idx = idx;
+    memcpy(slot->pcm, pcm, sizeof(slot->pcm));
+    s->frames_in++;
+}
+
+void mixer_put_packet(mixer_t *m, int src, uint16_t seq, uint8_t frames, const int16_t *pcm, const int16_t *fec)
+{
+    if (src < 0 || src >= MIXER_MAX_SOURCES || frames == 0) {
+        return;
+    }
+    mixer_source_t *s = &m->src[src];
+
+    if (!s->active) {
+        // Новий потік: відтворення почнеться через MIXER_JB_PREFILL кадрів
+        int32_t gain = s->gain_q8;
+        memset(s, 0, sizeof(*s));
+        s->gain_q8 = gain;
+        s->active = true;
+        s->last_seq = seq - 1;
+        s->next_idx = MIXER_JB_PREFILL;
+        s->play_idx = 0;
+    }
+
+    int16_t delta = (int16_t)(seq - s->last_seq);
+    if (delta <= 0) {
+        s->late++;
+        return;
+    }
+
+    // Втрачені пакети вважаються такого ж розміру, як цей
+    uint32_t idx = s->next_idx + (uint32_t)(delta - 1) * frames;
+    if (fec && delta == 2) {
+        for (int i = 0; i < frames; i++) {
+            put_frame(s, idx - frames + i, fec + i * MIXER_FRAME_SAMPLES);
+        }
+    }
+    for (int i = 0; i < frames; i++) {
+        put_frame(s, idx + i, pcm + i * MIXER_FRAME_SAMPLES);
+    }
+
+    s->last_seq = seq;
+    s->next_idx = idx + frames;
+    s->idle_ticks = 0;
+}
+
+int mixer_tick(mixer_t *m)
+{
+    int32_t peak = 0;
+
+    memset(m->sum, 0, sizeof(m->sum));
+    m->contributors = 0;
+    m->ticks++;
+
+    for (int i = 0; i < MIXER_MAX_SOURCES; i++) {
+        mixer_source_t *s = &m->src[i];
+        s->contributing = false;
+        if (!s->active) {
+            continue;
+        }
+
+        mixer_slot_t *slot = &s->slots[s->play_idx % MIXER_JB_FRAMES];
+        bool have = slot->valid && slot->idx == s->play_idx;
+        s->play_idx++;
+        if (!have) {
+            // Кадр не прийшов вчасно - джерело мовчить у цьому кадрі
+            s->concealed++;
+            if (++s->idle_ticks >= MIXER_IDLE_TICKS) {
+                s->active = false;
+            }
+            continue;
+        }
+        slot->valid = false;
+
+        for (int k = 0; k < MIXER_FRAME_SAMPLES; k++) {
+            int32_t v = (slot->pcm[k] * s->gain_q8) >> 8;
+            s->cur[k] = v;
+            m->sum[k] += v;
+        }
+        s->contributing = true;
+        m->contributors++;
+    }
+
+    for (int k = 0; k < MIXER_FRAME_SAMPLES; k++) {
+        int32_t a = m->sum[k] < 0 ? -m->sum[k] : m->sum[k];
+        if (a > peak) {
+            peak = a;
+        }
+    }
+
+    // Обмежувач: миттєве зниження до рівня без перевантаження, повільне відновлення
+    int32_t target = MIXER_LIMITER_UNITY;
+    if (peak > INT16_MAX) {
+        target = (int32_t)(((int64_t)INT16_MAX << 15) / peak);
+        m->clipped++;
+    }
+    if (target < m->limiter_q15) {
+        m->limiter_q15 = target;
+    } else {
+        m->limiter_q15 += (MIXER_LIMITER_UNITY - m->limiter_q15) >> 3;
+        if (m->limiter_q15 > target) {
+            m->limiter_q15 = target;
+        }
+    }
+    return m->contributors;
+}
+
+static inline int16_t saturate16(int32_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+bool mixer_output(const mixer_t *m, int exclude, int16_t *out)
+{
+    // Без власного голосу: загальна сума мінус внесок учасника, O(N) замість O(N^2)
+    bool own = exclude >= 0 && exclude < MIXER_MAX_SOURCES && m->src[exclude].contributing;
+    if (m->contributors - (own ? 1 : 0) == 0) {
+        return false;
+    }
+
+    const int32_t *cur = own ? m->src[exclude].cur : NULL;
+    int32_t lim = m->limiter_q15;
+    for (int k = 0; k < MIXER_FRAME_SAMPLES; k++) {
+        int32_t v = m->sum[k] - (cur ? cur[k] : 0);
+        out[k] = saturate16((int32_t)(((int64_t)v * lim) >> 15));
+    }
+    return true;
+}
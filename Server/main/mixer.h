@@ -0,0 +1,68 @@
+#ifndef MAIN_MIXER_H_
+#define MAIN_MIXER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Мікшер конференції: по джиттер-буферу на кожне джерело, суміш у цілих числах
+// з обмежувачем рівня і окрема суміш для кожного учасника без його власного голосу.
+// mixer_tick викликається раз на кадр, після нього mixer_output для кожного учасника.
+
+#define MIXER_MAX_SOURCES 4
+#define MIXER_FRAME_SAMPLES 512         // Кадр повної частоти, як у пристроїв
+#define MIXER_JB_FRAMES 8               // Глибина джиттер-буфера, кадрів
+#define MIXER_JB_PREFILL 2              // Затримка відтворення після першого кадру
+#define MIXER_IDLE_TICKS 16             // Стільки кадрів без даних - джерело неактивне
+#define MIXER_GAIN_UNITY 256            // Підсилення джерела, Q8
+#define MIXER_LIMITER_UNITY 32768       // Підсилення обмежувача, Q15
+
+typedef struct {
+    bool valid;
+    uint32_t idx;                       // Номер кадру в потоці джерела
+    int16_t pcm[MIXER_FRAME_SAMPLES];
+} mixer_slot_t;
+
+typedef struct {
+    bool active;
+    uint16_t last_seq;
+    uint32_t next_idx;                  // Номер кадру після останнього отриманого пакета
+    uint32_t play_idx;                  // Номер наступного кадру для суміші
+    uint32_t idle_ticks;
+    int32_t gain_q8;
+    mixer_slot_t slots[MIXER_JB_FRAMES];
+
+    // Внесок у поточну суміш з урахуванням підсилення
+    bool contributing;
+    int32_t cur[MIXER_FRAME_SAMPLES];
+
+    // Лічильники
+    uint32_t frames_in;
+    uint32_t late;
+    uint32_t concealed;
+    uint32_t resyncs;
+} mixer_source_t;
+
+typedef struct {
+    mixer_source_t src[MIXER_MAX_SOURCES];
+    int32_t sum[MIXER_FRAME_SAMPLES];
+    int contributors;
+    int32_t limiter_q15;
+    uint32_t ticks;
+    uint32_t clipped;                   // Кадри, де спрацював обмежувач
+} mixer_t;
+
+void mixer_init(mixer_t *m);
+void mixer_set_gain(mixer_t *m, int src, int32_t gain_q8);
+
+// Кадри пакета джерела з номером seq (повна частота, frames * MIXER_FRAME_SAMPLES).
+// fec - кадри попереднього пакета або NULL
+void mixer_put_packet(mixer_t *m, int src, uint16_t seq, uint8_t frames, const int16_t *pcm, const int16_t *fec);
+
+// Забирає по кадру з кожного джерела і рахує загальну суміш. Повертає кількість джерел у ній
+int mixer_tick(mixer_t *m);
+
+// Суміш усіх джерел, крім exclude (-1 - всі). false, якщо в ній нікого не чути
+bool mixer_output(const mixer_t *m, int exclude, int16_t *out);
+
+#endif /* MAIN_MIXER_H_ */
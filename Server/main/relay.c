@@ -0,0 +1,270 @@
+#include <string.h>
+#include <errno.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#else
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+
+#include "relay.h"
+
+uint32_t relay_now_ms(void)
+{
+#ifdef ESP_PLATFORM
+    return (uint32_t)(esp_timer_get_time() / 1000);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+#endif
+}
+
+int relay_init(relay_t *r, uint16_t port)
+{
+    memset(r, 0, sizeof(*r));
+
+    r->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (r->sock < 0) {
+        return -1;
+    }
+
+    struct sockaddr_in bind_addr;
+    memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(port);
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(r->sock, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+        int err = errno;
+        close(r->sock);
+        r->sock = -1;
+        errno = err;
+        return -1;
+    }
+
+    // Неблокуючий режим: повільний адресат не повинен зупиняти прийом
+    int flags = fcntl(r->sock, F_GETFL, 0);
+    fcntl(r->sock, F_SETFL, flags | O_NONBLOCK);
+
+    r->last_expire_ms = relay_now_ms();
+    r->running = true;
+    return 0;
+}
+
+void relay_close(relay_t *r)
+{
+    if (r->sock >= 0) {
+        close(r->sock);
+        r->sock = -1;
+    }
+    r->running = false;
+}
+
+void relay_set_rx(relay_t *r, relay_rx_cb_t cb, void *ctx)
+{
+    r->on_rx = cb;
+    r->rx_ctx = ctx;
+}
+
+// Пошук станції за адресою і портом, реєстрація нової. -1, якщо таблиця заповнена
+static int station_lookup(relay_t *r, const struct sockaddr_in *from, uint32_t now)
+{
+    int free_slot = -1;
+
+    for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+        relay_station_t *st = &r->stations[i];
+        if (!st->used) {
+            if (free_slot < 0) {
+                free_slot = i;
+            }
+            continue;
+        }
+        if (st->addr.sin_addr.s_addr == from->sin_addr.s_addr && st->addr.sin_port == from->sin_port) {
+            st->last_seen_ms = now;
+            return i;
+        }
+    }
+    if (free_slot < 0) {
+        return -1;
+    }
+
+    relay_station_t *st = &r->stations[free_slot];
+    memset(st, 0, sizeof(*st));
+    st->used = true;
+    st->addr = *from;
+    st->last_seen_ms = now;
+    r->station_count++;
+    return free_slot;
+}
+
+static void expire_stations(relay_t *r, uint32_t now)
+{
+    for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+        relay_station_t *st = &r->stations[i];
+        if (!st->used || (uint32_t)(now - st->last_seen_ms) <= RELAY_STATION_TIMEOUT_MS) {
+            continue;
+        }
+        st->used = false;
+        r->station_count--;
+        // Невідправлене цій станції вже нікому не потрібне
+        for (int j = 0; j < RELAY_POOL_SIZE; j++) {
+            r->pool[j].pending &= (uint8_t)~(1u << i);
+        }
+    }
+}
+
+// Відправка голови черги всім адресатам, поки сокет приймає
+static void flush_pool(relay_t *r, uint32_t now)
+{
+    if (r->tx_backoff) {
+        if ((int32_t)(now - r->tx_retry_ms) < 0) {
+            return;
+        }
+        r->tx_backoff = false;
+    }
+
+    while (r->pool_count > 0) {
+        relay_buf_t *b = &r->pool[r->pool_head];
+        for (int i = 0; i < RELAY_MAX_STATIONS && b->pending; i++) {
+            if (!(b->pending & (1u << i))) {
+                continue;
+            }
+            relay_station_t *st = &r->stations[i];
+            int err = sendto(r->sock, b->data, b->len, 0, (struct sockaddr *)&st->addr, sizeof(st->addr));
+            if (err < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOMEM || errno == ENOBUFS) {
+                    // Решта адресатів отримає датаграму після паузи
+                    r->tx_backoff = true;
+                    r->tx_retry_ms = now + RELAY_TX_RETRY_MS;
+                    return;
+                }
+                r->tx_errors++;
+            } else {
+                st->tx_packets++;
+                r->forwarded++;
+            }
+            b->pending &= (uint8_t)~(1u << i);
+        }
+        r->pool_head = (r->pool_head + 1) % RELAY_POOL_SIZE;
+        r->pool_count--;
+    }
+}
+
+static void receive_all(relay_t *r, uint32_t now)
+{
+    while (1) {
+        // Прийом одразу в хвіст черги. Якщо пул вичерпано, хвіст збігається з головою
+        // і найстаріша датаграма витісняється лише тоді, коли нова справді надійшла
+        relay_buf_t *b = &r->pool[(r->pool_head + r->pool_count) % RELAY_POOL_SIZE];
+        struct sockaddr_in from;
+        socklen_t socklen = sizeof(from);
+        int len = recvfrom(r->sock, b->data, sizeof(b->data), 0, (struct sockaddr *)&from, &socklen);
+        if (len < 0) {
+            break;
+        }
+        if (r->pool_count == RELAY_POOL_SIZE) {
+            r->pool_head = (r->pool_head + 1) % RELAY_POOL_SIZE;
+            r->pool_count--;
+            r->pool_overflows++;
+        }
+        r->rx_packets++;
+
+        int src = station_lookup(r, &from, now);
+        if (src < 0) {
+            r->rejected++;
+            continue;
+        }
+        r->stations[src].rx_packets++;
+
+        if (r->on_rx) {
+            r->on_rx(r->rx_ctx, src, b->data, (size_t)len, now);
+            continue;
+        }
+
+        uint8_t mask = 0;
+        for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+            if (i != src && r->stations[i].used) {
+                mask |= (uint8_t)(1u << i);
+            }
+        }
+        if (mask == 0) {
+            continue; // Поки що нікому пересилати
+        }
+        b->len = (uint16_t)len;
+        b->pending = mask;
+        r->pool_count++;
+
+        // Пересилаємо одразу, пул накопичується лише коли стек не встигає
+        flush_pool(r, now);
+    }
+}
+
+bool relay_send(relay_t *r, int station, const uint8_t *data, size_t len)
+{
+    if (station < 0 || station >= RELAY_MAX_STATIONS || !r->stations[station].used || len > RELAY_MAX_DATAGRAM) {
+        return false;
+    }
+    if (r->pool_count == RELAY_POOL_SIZE) {
+        r->pool_head = (r->pool_head + 1) % RELAY_POOL_SIZE;
+        r->pool_count--;
+        r->pool_overflows++;
+    }
+
+    relay_buf_t *b = &r->pool[(r->pool_head + r->pool_count) % RELAY_POOL_SIZE];
+    memcpy(b->data, data, len);
+    b->len = (uint16_t)len;
+    b->pending = (uint8_t)(1u << station);
+    r->pool_count++;
+
+    flush_pool(r, relay_now_ms());
+    return true;
+}
+
+int relay_poll(relay_t *r, int max_wait_ms)
+{
+    int wait = max_wait_ms;
+    if (r->pool_count > 0 && r->tx_backoff) {
+        int32_t left = (int32_t)(r->tx_retry_ms - relay_now_ms());
+        wait = left < 0 ? 0 : left;
+    }
+
+    fd_set readfds;
+    fd_set writefds;
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    FD_SET(r->sock, &readfds);
+    bool want_write = r->pool_count > 0 && !r->tx_backoff;
+    if (want_write) {
+        FD_SET(r->sock, &writefds);
+    }
+
+    struct timeval tv;
+    struct timeval *ptv = NULL;
+    if (wait >= 0) {
+        tv.tv_sec = wait / 1000;
+        tv.tv_usec = (wait % 1000) * 1000;
+        ptv = &tv;
+    }
+
+    int n = select(r->sock + 1, &readfds, want_write ? &writefds : NULL, NULL, ptv);
+    if (n < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    uint32_t now = relay_now_ms();
+    if (n > 0 && FD_ISSET(r->sock, &readfds)) {
+        receive_all(r, now);
+    }
+    flush_pool(r, now);
+
+    if ((uint32_t)(now - r->last_expire_ms) >= 1000) {
+        r->last_expire_ms = now;
+        expire_stations(r, now);
+    }
+    return 0;
+}
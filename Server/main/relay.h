@@ -0,0 +1,87 @@
+#ifndef MAIN_RELAY_H_
+#define MAIN_RELAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef ESP_PLATFORM
+#include "lwip/sockets.h"
+#else
+#include <netinet/in.h>
+#endif
+
+// Ретранслятор точки доступу: кожна датаграма від зареєстрованої станції
+// пересилається без розбору всім іншим станціям.
+// Станція реєструється першою датаграмою і видаляється після тиші.
+// Датаграми приймаються одразу в буфери фіксованого пулу і чекають там,
+// поки не будуть відправлені всім адресатам - жодних виділень пам'яті на пакет.
+
+#define RELAY_MAX_STATIONS 4            // Не більше, ніж станцій на точці доступу
+#define RELAY_POOL_SIZE 8               // Датаграм в очікуванні відправки
+#define RELAY_MAX_DATAGRAM 1280
+#define RELAY_STATION_TIMEOUT_MS 10000
+#define RELAY_TX_RETRY_MS 2
+
+// Обробник датаграм станцій замість пересилання (режим конференції).
+// data вказує на вільний буфер пулу: дійсний лише під час виклику, relay_send в обробнику не викликати
+typedef void (*relay_rx_cb_t)(void *ctx, int station, uint8_t *data, size_t len, uint32_t now_ms);
+
+typedef struct {
+    bool used;
+    struct sockaddr_in addr;
+    uint32_t last_seen_ms;
+    uint32_t rx_packets;
+    uint32_t tx_packets;
+} relay_station_t;
+
+typedef struct {
+    uint8_t data[RELAY_MAX_DATAGRAM];
+    uint16_t len;
+    uint8_t pending;                    // Біти станцій, яким ще треба відправити
+} relay_buf_t;
+
+typedef struct {
+    int sock;
+    bool running;
+
+    relay_rx_cb_t on_rx;
+    void *rx_ctx;
+
+    relay_station_t stations[RELAY_MAX_STATIONS];
+    int station_count;
+
+    // Пул буферів як кільцева черга: голова відправляється першою
+    relay_buf_t pool[RELAY_POOL_SIZE];
+    int pool_head;
+    int pool_count;
+    bool tx_backoff;
+    uint32_t tx_retry_ms;
+
+    uint32_t last_expire_ms;
+
+    // Лічильники
+    uint32_t rx_packets;
+    uint32_t forwarded;
+    uint32_t tx_errors;
+    uint32_t pool_overflows;            // Витіснено невідправлених датаграм
+    uint32_t rejected;                  // Датаграми від станцій понад RELAY_MAX_STATIONS
+} relay_t;
+
+uint32_t relay_now_ms(void);
+
+// Повертає 0 або -1 (errno)
+int relay_init(relay_t *r, uint16_t port);
+void relay_close(relay_t *r);
+
+// Після встановлення обробника датаграми передаються йому, а не пересилаються
+void relay_set_rx(relay_t *r, relay_rx_cb_t cb, void *ctx);
+
+// Відправка датаграми одній станції через пул буферів. false, якщо станції немає
+bool relay_send(relay_t *r, int station, const uint8_t *data, size_t len);
+
+// Одна ітерація: очікування до max_wait_ms (-1 - без обмеження), прийом,
+// пересилання і видалення неактивних станцій. Повертає -1 при помилці сокету
+int relay_poll(relay_t *r, int max_wait_ms);
+
+#endif /* MAIN_RELAY_H_ */
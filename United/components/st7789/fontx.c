@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <inttypes.h>
 #include <string.h>
@@ -20,18 +21,87 @@ void AddFontx(FontxFile *fx, const char *path)
 	fx->opened = false;
 }
 
-// フォント構造体を初期化
+// フォント構造体を初期化し、ANKフォントをRAMに読み込む
 void InitFontx(FontxFile *fxs, const char *f0, const char *f1)
 {
 	AddFontx(&fxs[0], f0);
 	AddFontx(&fxs[1], f1);
+	for(int i=0;i<2;i++) {
+		if (fxs[i].path[0] == 0) continue;
+		LoadFontx(&fxs[i]);
+	}
+}
+
+// ビルド時に埋め込んだフォントを名前(拡張子なしのファイル名)で探す
+const FontxEmbedded *FindFontxEmbedded(const char *name)
+{
+	for(int i=0;i<FontxEmbeddedCount;i++) {
+		if (strcmp(FontxEmbeddedFonts[i].name, name) == 0) return &FontxEmbeddedFonts[i];
+	}
+	return NULL;
+}
+
+// メモリ上のフォントを構造体に保存
+void AddFontxMem(FontxFile *fx, const char *name, const uint8_t *data, size_t size)
+{
+	memset(fx, 0, sizeof(FontxFile));
+	fx->path = name;
+	fx->data = data;
+	fx->size = size;
+}
+
+// 埋め込みフォントで構造体を初期化。グリフ表はフラッシュ上のまま使う
+void InitFontxMem(FontxFile *fxs, const char *f0, const char *f1)
+{
+	const char *names[2] = { f0, f1 };
+	for(int i=0;i<2;i++) {
+		const FontxEmbedded *fe = names[i][0] ? FindFontxEmbedded(names[i]) : NULL;
+		if (fe) {
+			AddFontxMem(&fxs[i], fe->name, fe->data, fe->size);
+			LoadFontx(&fxs[i]);
+		} else {
+			// ファイルを探しに行かないよう、OPEN済みの無効フォントにする
+			AddFontx(&fxs[i], names[i]);
+			fxs[i].opened = true;
+			if (names[i][0]) printf("Fontx:%s not embedded.\n",names[i]);
+		}
+	}
+}
+
+// ヘッダ(18バイト)を解析
+static bool ParseFontx(FontxFile *fx, const uint8_t *buf)
+{
+	if(FontxDebug) {
+		for(int i=0;i<18;i++) {
+			printf("buf[%d]=0x%x\n",i,buf[i]);
+		}
+	}
+	memcpy(fx->fxname, &buf[6], 8);
+	fx->w = buf[14];
+	fx->h = buf[15];
+	fx->is_ank = (buf[16] == 0);
+	fx->bc = buf[17];
+	fx->fsz = (fx->w + 7)/8 * fx->h;
+	if(fx->fsz > FontxGlyphBufSize){
+		printf("Fontx:%s is too big font size.\n",fx->path);
+		return false;
+	}
+	return true;
 }
 
 // フォントファイルをOPEN
 bool OpenFontx(FontxFile *fx)
 {
 	FILE *f;
-	if(!fx->opened){
+	if(!fx->opened && fx->data){
+		// メモリ上のフォント
+		fx->opened = true;
+		fx->valid = fx->size >= 18 && ParseFontx(fx, fx->data);
+		if (fx->valid && fx->is_ank && fx->size < 17 + (size_t)FontxAnkGlyphs * fx->fsz) {
+			printf("Fontx:%s is truncated.\n",fx->path);
+			fx->valid = false;
+		}
+	} else if(!fx->opened){
 		if(FontxDebug)printf("[openFont]fx->path=[%s]\n",fx->path);
 		f = fopen(fx->path, "r");
 		if(FontxDebug)printf("[openFont]fopen=%p\n",f);
@@ -42,27 +112,14 @@ bool OpenFontx(FontxFile *fx)
 		}
 		fx->opened = true;
 		fx->file = f;
-		char buf[18];
+		uint8_t buf[18];
 		if (fread(buf, 1, sizeof(buf), fx->file) != sizeof(buf)) {
 			fx->valid = false;
 			printf("Fontx:%s not FONTX format.\n",fx->path);
 			fclose(fx->file);
 			return fx->valid ;
 		}
-
-		if(FontxDebug) {
-			for(int i=0;i<sizeof(buf);i++) {
-				printf("buf[%d]=0x%x\n",i,buf[i]);
-			}
-		}
-		memcpy(fx->fxname, &buf[6], 8);
-		fx->w = buf[14];
-		fx->h = buf[15];
-		fx->is_ank = (buf[16] == 0);
-		fx->bc = buf[17];
-		fx->fsz = (fx->w + 7)/8 * fx->h;
-		if(fx->fsz > FontxGlyphBufSize){
-			printf("Fontx:%s is too big font size.\n",fx->path);
+		if(!ParseFontx(fx, buf)){
 			fx->valid = false;
 			fclose(fx->file);
 			return fx->valid ;
@@ -72,15 +129,61 @@ bool OpenFontx(FontxFile *fx)
 	return fx->valid;
 }
 
+// ANKフォントのグリフ表をRAMに読み込む。表が大きすぎればLRUキャッシュを用意する
+// メモリ上のフォントは読み込まず、その場の表を使う
+bool LoadFontx(FontxFile *fx)
+{
+	if (!OpenFontx(fx)) return false;
+	if (!fx->is_ank) return true;
+	if (fx->table || fx->cache) return true;
+	if (fx->data) {
+		fx->table = fx->data + 17;
+		return true;
+	}
+
+	size_t size = (size_t)FontxAnkGlyphs * fx->fsz;
+	if (size <= FontxTableMax) {
+		uint8_t *table = malloc(size);
+		if (table == NULL) {
+			printf("Fontx:%s no memory for glyph table.\n",fx->path);
+		} else if (fseek(fx->file, 17, SEEK_SET) || fread(table, 1, size, fx->file) != size) {
+			printf("Fontx:%s glyph table read failed.\n",fx->path);
+			free(table);
+		} else {
+			// 以降ファイルは不要
+			fx->table = table;
+			CloseFontx(fx);
+			return true;
+		}
+	}
+	if (FontxCacheSlots > 0) {
+		fx->cache = calloc(FontxCacheSlots, sizeof(FontxCacheEntry));
+	}
+	return true;
+}
+
 // フォントファイルをCLOSE
 void CloseFontx(FontxFile *fx)
 {
 	if(fx->opened){
-		fclose(fx->file);
+		if (fx->file) fclose(fx->file);
+		fx->file = NULL;
 		fx->opened = false;
 	}
 }
 
+// グリフ表・キャッシュを解放し、ファイルをCLOSE
+void FreeFontx(FontxFile *fxs)
+{
+	for(int i=0;i<2;i++) {
+		CloseFontx(&fxs[i]);
+		if (!fxs[i].data) free((void *)fxs[i].table);
+		fxs[i].table = NULL;
+		free(fxs[i].cache);
+		fxs[i].cache = NULL;
+	}
+}
+
 // フォント構造体の表示
 void DumpFontx(FontxFile *fxs)
 {
@@ -94,6 +197,8 @@ void DumpFontx(FontxFile *fxs)
 		printf("fxs[%d]->h=%d\n",i,fxs[i].h);
 		printf("fxs[%d]->fsz=%d\n",i,fxs[i].fsz);
 		printf("fxs[%d]->bc=%d\n",i,fxs[i].bc);
+		printf("fxs[%d]->table=%p cache=%p\n",i,fxs[i].table,fxs[i].cache);
+		printf("fxs[%d]->hits=%"PRIu32" reads=%"PRIu32"\n",i,fxs[i].hits,fxs[i].reads);
 	}
 }
 
@@ -197,36 +302,80 @@ uint8_t getFortHeight(FontxFile *fx) {
 
 */
 
+// ファイルから1文字読む
+static bool ReadFontx(FontxFile *fx, uint8_t ascii, uint8_t *pGlyph)
+{
+	uint32_t offset;
+
+	if(!OpenFontx(fx)) return false;
+	offset = 17 + ascii * fx->fsz;
+	if(FontxDebug)printf("[GetFontx]offset=%"PRIu32"\n",offset);
+	if(fseek(fx->file, offset, SEEK_SET)) {
+		printf("Fontx:seek(%"PRIu32") failed.\n",offset);
+		return false;
+	}
+	if(fread(pGlyph, 1, fx->fsz, fx->file) != fx->fsz) {
+		printf("Fontx:fread failed.\n");
+		return false;
+	}
+	fx->reads++;
+	return true;
+}
+
+// LRUキャッシュから1文字。無ければ最も古いスロットに読み込む
+static bool CachedFontx(FontxFile *fx, uint8_t ascii, uint8_t *pGlyph)
+{
+	FontxCacheEntry *victim = &fx->cache[0];
+
+	fx->stamp++;
+	for(int i=0; i<FontxCacheSlots; i++) {
+		FontxCacheEntry *e = &fx->cache[i];
+		if (e->used && e->code == ascii) {
+			e->stamp = fx->stamp;
+			fx->hits++;
+			memcpy(pGlyph, e->glyph, fx->fsz);
+			return true;
+		}
+		if (!e->used) {
+			victim = e;
+		} else if (victim->used && e->stamp < victim->stamp) {
+			victim = e;
+		}
+	}
+	if (!ReadFontx(fx, ascii, victim->glyph)) return false;
+	victim->used = true;
+	victim->code = ascii;
+	victim->stamp = fx->stamp;
+	memcpy(pGlyph, victim->glyph, fx->fsz);
+	return true;
+}
+
 bool GetFontx(FontxFile *fxs, uint8_t ascii , uint8_t *pGlyph, uint8_t *pw, uint8_t *ph)
 {
-  
 	int i;
-	uint32_t offset;
+	bool rc;
 
 	if(FontxDebug)printf("[GetFontx]ascii=0x%x\n",ascii);
 	for(i=0; i<2; i++){
-	//for(i=0; i<1; i++){
-		if(!OpenFontx(&fxs[i])) continue;
-		if(FontxDebug)printf("[GetFontx]openFontxFile[%d] ok\n",i);
-	
-		//if(ascii < 0xFF){
-			if(fxs[i].is_ank){
-				if(FontxDebug)printf("[GetFontx]fxs.is_ank fxs.fsz=%d\n",fxs[i].fsz);
-				offset = 17 + ascii * fxs[i].fsz;
-				if(FontxDebug)printf("[GetFontx]offset=%"PRIu32"\n",offset);
-				if(fseek(fxs[i].file, offset, SEEK_SET)) {
-					printf("Fontx:seek(%"PRIu32") failed.\n",offset);
-					return false;
-				}
-				if(fread(pGlyph, 1, fxs[i].fsz, fxs[i].file) != fxs[i].fsz) {
-					printf("Fontx:fread failed.\n");
-					return false;
-				}
-				if(pw) *pw = fxs[i].w;
-				if(ph) *ph = fxs[i].h;
-				return true;
+		if (fxs[i].table) {
+			// RAM上の表から。ファイルには触れない
+			memcpy(pGlyph, fxs[i].table + ascii * fxs[i].fsz, fxs[i].fsz);
+			rc = true;
+		} else {
+			if(!OpenFontx(&fxs[i])) continue;
+			if(FontxDebug)printf("[GetFontx]openFontxFile[%d] ok\n",i);
+			if(!fxs[i].is_ank) continue;
+			if(FontxDebug)printf("[GetFontx]fxs.is_ank fxs.fsz=%d\n",fxs[i].fsz);
+			if (fxs[i].cache) {
+				rc = CachedFontx(&fxs[i], ascii, pGlyph);
+			} else {
+				rc = ReadFontx(&fxs[i], ascii, pGlyph);
 			}
-		//}
+		}
+		if (!rc) return false;
+		if(pw) *pw = fxs[i].w;
+		if(ph) *ph = fxs[i].h;
+		return true;
 	}
 	return false;
 }
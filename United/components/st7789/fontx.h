@@ -2,6 +2,29 @@
 #define MAIN_FONTX_H_
 #define FontxGlyphBufSize (32*32/8)
 
+// ANKフォントは256文字。表全体がFontxTableMax以下ならInitFontxでRAMに読み込む
+#define FontxAnkGlyphs 256
+#define FontxTableMax (256*32)
+// 表が大きいフォントはLRUキャッシュ(FontxCacheSlots文字)。0ならファイルから毎回読む
+#define FontxCacheSlots 64
+
+typedef struct {
+	bool used;
+	uint8_t code;
+	uint32_t stamp;
+	uint8_t glyph[FontxGlyphBufSize];
+} FontxCacheEntry;
+
+// ビルド時に埋め込んだFONTXファイル(fontx2c.pyが生成するfontx_embedded.c)
+typedef struct {
+	const char *name;
+	const uint8_t *data;		// フラッシュ上(rodata)
+	uint32_t size;
+} FontxEmbedded;
+
+extern const FontxEmbedded FontxEmbeddedFonts[];
+extern const int FontxEmbeddedCount;
+
 typedef struct {
 	const char *path;
 	char  fxname[10];
@@ -13,12 +36,24 @@ typedef struct {
 	uint16_t fsz;
 	uint8_t bc;
 	FILE *file;
+	const uint8_t *data;		// メモリ上のフォント(NULLならpathのファイル)
+	size_t size;
+	const uint8_t *table;		// グリフ表(FontxAnkGlyphs*fsz)。RAMまたはdata内
+	FontxCacheEntry *cache;		// LRUキャッシュ(FontxCacheSlots)
+	uint32_t stamp;
+	uint32_t hits;
+	uint32_t reads;				// ファイルからの読み込み回数
 } FontxFile;
 
 void AaddFontx(FontxFile *fx, const char *path);
 void InitFontx(FontxFile *fxs, const char *f0, const char *f1);
+const FontxEmbedded *FindFontxEmbedded(const char *name);
+void AddFontxMem(FontxFile *fx, const char *name, const uint8_t *data, size_t size);
+void InitFontxMem(FontxFile *fxs, const char *f0, const char *f1);
 bool OpenFontx(FontxFile *fx);
+bool LoadFontx(FontxFile *fx);
 void CloseFontx(FontxFile *fx);
+void FreeFontx(FontxFile *fxs);
 void DumpFontx(FontxFile *fxs);
 uint8_t getFortWidth(FontxFile *fx);
 uint8_t getFortHeight(FontxFile *fx);
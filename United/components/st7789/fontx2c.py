@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+#
+# Convert FONTX2 files into const C arrays (flash rodata) for fontx.c.
+#
+# usage: fontx2c.py OUTPUT.c [FONT.FNT ...]
+#
+# Each font is registered in FontxEmbeddedFonts under its file name without
+# the extension, e.g. ILGH16XB.FNT -> "ILGH16XB" for InitFontxMem().
+# With no fonts the table is empty and InitFontxMem() reports it.
+
+import os
+import re
+import sys
+
+
+def check(path, data):
+    if len(data) < 18 or data[0:6] != b'FONTX2':
+        sys.exit('%s: not FONTX2 format' % path)
+    w, h, code = data[14], data[15], data[16]
+    fsz = (w + 7) // 8 * h
+    if fsz > 32 * 32 // 8:
+        sys.exit('%s: %dx%d is too big' % (path, w, h))
+    if code == 0 and len(data) < 17 + 256 * fsz:
+        sys.exit('%s: truncated ANK font' % path)
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit('usage: fontx2c.py OUTPUT.c [FONT.FNT ...]')
+    out = sys.argv[1]
+    fonts = []
+    for path in sorted(sys.argv[2:]):
+        with open(path, 'rb') as f:
+            data = f.read()
+        check(path, data)
+        name = os.path.splitext(os.path.basename(path))[0]
+        ident = 'fontx_' + re.sub(r'\W', '_', name)
+        fonts.append((path, name, ident, data))
+
+    lines = ['// Generated by fontx2c.py - do not edit',
+             '#include <stdio.h>',
+             '#include <stdint.h>',
+             '#include <stdbool.h>',
+             '#include "fontx.h"',
+             '']
+    for path, name, ident, data in fonts:
+        lines.append('// %s' % os.path.basename(path))
+        lines.append('static const uint8_t %s[%d] = {' % (ident, len(data)))
+        for i in range(0, len(data), 16):
+            lines.append('\t' + ' '.join('0x%02x,' % b for b in data[i:i + 16]))
+        lines.append('};')
+        lines.append('')
+    lines.append('const FontxEmbedded FontxEmbeddedFonts[] = {')
+    for path, name, ident, data in fonts:
+        lines.append('\t{ "%s", %s, sizeof(%s) },' % (name, ident, ident))
+    if not fonts:
+        lines.append('\t{ "", NULL, 0 },')
+    lines.append('};')
+    lines.append('const int FontxEmbeddedCount = %d;' % len(fonts))
+    text = '\n'.join(lines) + '\n'
+
+    # Rewrite only on change, so an unchanged font does not rebuild the component
+    try:
+        with open(out) as f:
+            if f.read() == text:
+                return
+    except OSError:
+        pass
+    with open(out, 'w') as f:
+        f.write(text)
+
+
+if __name__ == '__main__':
+    main()
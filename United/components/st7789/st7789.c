@@ -8,6 +8,8 @@
 #include <driver/spi_master.h>
 #include <driver/gpio.h>
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
 
 #include "st7789.h"
 
@@ -44,6 +46,15 @@ static const int SPI_Data_Mode = 1;
 
 int clock_speed_hz = SPI_DEFAULT_FREQUENCY;
 
+// D/C level travels with a queued transaction and is set just before it goes on the wire
+#define LCD_DC_VALID 0x100
+
+static void IRAM_ATTR spi_master_pre_cb(spi_transaction_t *t)
+{
+	uint32_t user = (uint32_t)(uintptr_t)t->user;
+	if (user & LCD_DC_VALID) gpio_set_level((user >> 1) & 0x7F, user & 1);
+}
+
 void spi_clock_speed(int speed) {
     ESP_LOGI(TAG, "SPI clock speed=%d MHz", speed/1000000);
     clock_speed_hz = speed;
@@ -112,6 +123,7 @@ void spi_master_init(TFT_t * dev, int16_t GPIO_MOSI, int16_t GPIO_SCLK, int16_t
 	//devcfg.mode = 2;
 	devcfg.mode = 3;
 	devcfg.flags = SPI_DEVICE_NO_DUMMY;
+	devcfg.pre_cb = spi_master_pre_cb;
 
 	if ( GPIO_CS >= 0 ) {
 		devcfg.spics_io_num = GPIO_CS;
@@ -126,6 +138,119 @@ void spi_master_init(TFT_t * dev, int16_t GPIO_MOSI, int16_t GPIO_SCLK, int16_t
 	dev->_dc = GPIO_DC;
 	dev->_bl = GPIO_BL;
 	dev->_SPIHandle = handle;
+
+	// Queued mode is switched on by lcdInit after the init sequence
+	dev->_async = false;
+	dev->_trans_head = 0;
+	dev->_trans_count = 0;
+	dev->_chunk_next = 0;
+	dev->_bus_waits = 0;
+	for (int i=0;i<2;i++) {
+		dev->_chunk[i] = NULL;
+		dev->_chunk_busy[i] = 0;
+	}
+#if CONFIG_ASYNC_SPI
+	dev->_chunk[0] = heap_caps_malloc(LCD_CHUNK_SIZE, MALLOC_CAP_DMA);
+	dev->_chunk[1] = heap_caps_malloc(LCD_CHUNK_SIZE, MALLOC_CAP_DMA);
+	if (dev->_chunk[0] == NULL || dev->_chunk[1] == NULL) {
+		ESP_LOGE(TAG, "DMA chunk alloc fail, blocking SPI");
+	}
+#endif
+}
+
+// Take back the oldest queued transaction (they complete in order)
+static void spi_master_reclaim(TFT_t * dev)
+{
+	spi_transaction_t *t;
+	esp_err_t ret = spi_device_get_trans_result(dev->_SPIHandle, &t, portMAX_DELAY);
+	assert(ret==ESP_OK);
+	int8_t chunk = dev->_trans_chunk[dev->_trans_head];
+	if (chunk >= 0) dev->_chunk_busy[chunk]--;
+	dev->_trans_head = (dev->_trans_head + 1) % LCD_QUEUE_SIZE;
+	dev->_trans_count--;
+}
+
+// Wait until every queued transaction is on the wire
+void spi_master_wait(TFT_t * dev)
+{
+	while (dev->_trans_count > 0) spi_master_reclaim(dev);
+}
+
+// Queue one transaction. Up to 4 bytes are copied into it, longer data must stay
+// valid until reclaimed (a chunk buffer)
+static void spi_master_queue(TFT_t * dev, int dc, const uint8_t* Data, size_t DataLength, int8_t chunk)
+{
+	if (dev->_trans_count == LCD_QUEUE_SIZE) {
+		dev->_bus_waits++;
+		spi_master_reclaim(dev);
+	}
+	int slot = (dev->_trans_head + dev->_trans_count) % LCD_QUEUE_SIZE;
+	spi_transaction_t *t = &dev->_trans[slot];
+	memset(t, 0, sizeof(spi_transaction_t));
+	t->length = DataLength * 8;
+	t->user = (void *)(uintptr_t)(LCD_DC_VALID | (dev->_dc << 1) | dc);
+	if (DataLength <= 4) {
+		t->flags = SPI_TRANS_USE_TXDATA;
+		memcpy(t->tx_data, Data, DataLength);
+		chunk = -1;
+	} else {
+		t->tx_buffer = Data;
+	}
+	dev->_trans_chunk[slot] = chunk;
+	if (chunk >= 0) dev->_chunk_busy[chunk]++;
+	dev->_trans_count++;
+	esp_err_t ret = spi_device_queue_trans(dev->_SPIHandle, t, portMAX_DELAY);
+	assert(ret==ESP_OK);
+}
+
+// Next free chunk buffer. While it is filled, the other one is on the wire
+static uint8_t *spi_master_chunk(TFT_t * dev, int8_t *index)
+{
+	int8_t k = dev->_chunk_next;
+	dev->_chunk_next ^= 1;
+	if (dev->_chunk_busy[k]) dev->_bus_waits++;
+	while (dev->_chunk_busy[k]) spi_master_reclaim(dev);
+	*index = k;
+	return dev->_chunk[k];
+}
+
+// Command or data bytes, blocking or queued
+static bool spi_master_write_dc(TFT_t * dev, int dc, const uint8_t* Data, size_t DataLength)
+{
+	if (!dev->_async) {
+		gpio_set_level( dev->_dc, dc );
+		return spi_master_write_byte( dev->_SPIHandle, Data, DataLength );
+	}
+	if (DataLength <= 4) {
+		if (DataLength > 0) spi_master_queue(dev, dc, Data, DataLength, -1);
+		return true;
+	}
+	while (DataLength > 0) {
+		int8_t k;
+		uint8_t *buf = spi_master_chunk(dev, &k);
+		size_t n = (DataLength > LCD_CHUNK_SIZE) ? LCD_CHUNK_SIZE : DataLength;
+		memcpy(buf, Data, n);
+		spi_master_queue(dev, dc, buf, n, k);
+		Data += n;
+		DataLength -= n;
+	}
+	return true;
+}
+
+// Same color count times, rendered chunk by chunk into the double buffer
+static void spi_master_fill(TFT_t * dev, uint16_t color, uint32_t count)
+{
+	while (count > 0) {
+		int8_t k;
+		uint8_t *buf = spi_master_chunk(dev, &k);
+		uint32_t n = (count > LCD_CHUNK_SIZE/2) ? LCD_CHUNK_SIZE/2 : count;
+		for (uint32_t i=0;i<n;i++) {
+			buf[i*2] = (color >> 8) & 0xFF;
+			buf[i*2+1] = color & 0xFF;
+		}
+		spi_master_queue(dev, SPI_Data_Mode, buf, n*2, k);
+		count -= n;
+	}
 }
 
 bool spi_master_write_byte(spi_device_handle_t SPIHandle, const uint8_t* Data, size_t DataLength)
@@ -152,16 +277,14 @@ bool spi_master_write_command(TFT_t * dev, uint8_t cmd)
 {
 	static uint8_t Byte = 0;
 	Byte = cmd;
-	gpio_set_level( dev->_dc, SPI_Command_Mode );
-	return spi_master_write_byte( dev->_SPIHandle, &Byte, 1 );
+	return spi_master_write_dc( dev, SPI_Command_Mode, &Byte, 1 );
 }
 
 bool spi_master_write_data_byte(TFT_t * dev, uint8_t data)
 {
 	static uint8_t Byte = 0;
 	Byte = data;
-	gpio_set_level( dev->_dc, SPI_Data_Mode );
-	return spi_master_write_byte( dev->_SPIHandle, &Byte, 1 );
+	return spi_master_write_dc( dev, SPI_Data_Mode, &Byte, 1 );
 }
 
 
@@ -170,8 +293,7 @@ bool spi_master_write_data_word(TFT_t * dev, uint16_t data)
 	static uint8_t Byte[2];
 	Byte[0] = (data >> 8) & 0xFF;
 	Byte[1] = data & 0xFF;
-	gpio_set_level( dev->_dc, SPI_Data_Mode );
-	return spi_master_write_byte( dev->_SPIHandle, Byte, 2);
+	return spi_master_write_dc( dev, SPI_Data_Mode, Byte, 2);
 }
 
 bool spi_master_write_addr(TFT_t * dev, uint16_t addr1, uint16_t addr2)
@@ -181,12 +303,15 @@ bool spi_master_write_addr(TFT_t * dev, uint16_t addr1, uint16_t addr2)
 	Byte[1] = addr1 & 0xFF;
 	Byte[2] = (addr2 >> 8) & 0xFF;
 	Byte[3] = addr2 & 0xFF;
-	gpio_set_level( dev->_dc, SPI_Data_Mode );
-	return spi_master_write_byte( dev->_SPIHandle, Byte, 4);
+	return spi_master_write_dc( dev, SPI_Data_Mode, Byte, 4);
 }
 
 bool spi_master_write_color(TFT_t * dev, uint16_t color, uint16_t size)
 {
+	if (dev->_async) {
+		spi_master_fill(dev, color, size);
+		return true;
+	}
 	static uint8_t Byte[1024];
 	int index = 0;
 	for(int i=0;i<size;i++) {
@@ -201,13 +326,30 @@ bool spi_master_write_color(TFT_t * dev, uint16_t color, uint16_t size)
 bool spi_master_write_colors(TFT_t * dev, uint16_t * colors, uint16_t size)
 {
 	static uint8_t Byte[1024];
-	int index = 0;
-	for(int i=0;i<size;i++) {
-		Byte[index++] = (colors[i] >> 8) & 0xFF;
-		Byte[index++] = colors[i] & 0xFF;
+	uint8_t *buf = Byte;
+	uint16_t max = sizeof(Byte)/2;
+	int8_t k = -1;
+	while (size > 0) {
+		if (dev->_async) {
+			buf = spi_master_chunk(dev, &k);
+			max = LCD_CHUNK_SIZE/2;
+		}
+		uint16_t n = (size > max) ? max : size;
+		int index = 0;
+		for(int i=0;i<n;i++) {
+			buf[index++] = (colors[i] >> 8) & 0xFF;
+			buf[index++] = colors[i] & 0xFF;
+		}
+		if (dev->_async) {
+			spi_master_queue(dev, SPI_Data_Mode, buf, n*2, k);
+		} else {
+			gpio_set_level( dev->_dc, SPI_Data_Mode );
+			spi_master_write_byte( dev->_SPIHandle, buf, n*2);
+		}
+		colors += n;
+		size -= n;
 	}
-	gpio_set_level( dev->_dc, SPI_Data_Mode );
-	return spi_master_write_byte( dev->_SPIHandle, Byte, size*2);
+	return true;
 }
 
 void delayMS(int ms) {
@@ -266,6 +408,9 @@ void lcdInit(TFT_t * dev, int width, int height, int offsetx, int offsety)
 		gpio_set_level( dev->_bl, 1 );
 	}
 
+	// From here on transactions are queued (init sequence above needs its delays)
+	dev->_async = dev->_chunk[0] != NULL && dev->_chunk[1] != NULL;
+
 	dev->_use_frame_buffer = false;
 #if CONFIG_FRAME_BUFFER
 	dev->_frame_buffer = heap_caps_malloc(sizeof(uint16_t)*width*height, MALLOC_CAP_DMA);
@@ -371,9 +516,13 @@ void lcdDrawFillRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_
 		spi_master_write_command(dev, 0x2B);	// set Page(y) address
 		spi_master_write_addr(dev, _y1, _y2);
 		spi_master_write_command(dev, 0x2C);	// Memory Write
-		for(int i=_x1;i<=_x2;i++){
-			uint16_t size = _y2-_y1+1;
-			spi_master_write_color(dev, color, size);
+		if (dev->_async) {
+			spi_master_fill(dev, color, (uint32_t)(_x2-_x1+1) * (_y2-_y1+1));
+		} else {
+			for(int i=_x1;i<=_x2;i++){
+				uint16_t size = _y2-_y1+1;
+				spi_master_write_color(dev, color, size);
+			}
 		}
 	}
 }
@@ -735,6 +884,51 @@ void lcdDrawFillArrow(TFT_t * dev, uint16_t x0,uint16_t y0,uint16_t x1,uint16_t
 }
 
 
+// Expand glyph into one window and send it as a single RAMWR burst
+// Window is x0..x1, y0..y1 (same box as font fill)
+// Direction 0/2: pw x ph, 180 degrees for 2. Direction 1/3: ph x pw, rotated 90 degrees
+static uint8_t _glyph_burst[32*32*2];
+
+static void lcdBlitGlyph(TFT_t * dev, const uint8_t *fonts, uint8_t pw, uint8_t ph, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color) {
+	uint16_t ww = x1 - x0 + 1;
+	uint16_t bg = dev->_font_fill_color;
+	int stride = (pw + 7) / 8;
+
+	for(int h=0;h<ph;h++) {
+		bool underline = dev->_font_underline && h >= ph-2;
+		for(int c=0;c<pw;c++) {
+			uint16_t px = bg;
+			if (fonts[h*stride + c/8] & (0x80 >> (c % 8))) px = color;
+			if (underline) px = dev->_font_underline_color;
+
+			int bx, by;
+			if (dev->_font_direction == 0) {
+				bx = c;
+				by = h;
+			} else if (dev->_font_direction == 2) {
+				bx = (pw-1) - c;
+				by = (ph-1) - h;
+			} else if (dev->_font_direction == 1) {
+				bx = (ph-1) - h;
+				by = c;
+			} else {
+				bx = h;
+				by = (pw-1) - c;
+			}
+			int index = (by*ww + bx) * 2;
+			_glyph_burst[index] = (px >> 8) & 0xFF;
+			_glyph_burst[index+1] = px & 0xFF;
+		}
+	}
+
+	spi_master_write_command(dev, 0x2A);	// set column(x) address
+	spi_master_write_addr(dev, x0 + dev->_offsetx, x1 + dev->_offsetx);
+	spi_master_write_command(dev, 0x2B);	// set Page(y) address
+	spi_master_write_addr(dev, y0 + dev->_offsety, y1 + dev->_offsety);
+	spi_master_write_command(dev, 0x2C);	// Memory Write
+	spi_master_write_dc( dev, SPI_Data_Mode, _glyph_burst, pw*ph*2);
+}
+
 // Draw ASCII character
 // x:X coordinate
 // y:Y coordinate
@@ -828,6 +1022,14 @@ int lcdDrawChar(TFT_t * dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t asc
 		y1	= y;
 	}
 
+	// With font fill every pixel of the box is known: one window per character
+	// instead of one window per pixel. Without fill (transparent) or off screen - per pixel
+	if (dev->_font_fill && !dev->_use_frame_buffer && x0 <= x1 && y0 <= y1 && x1 < dev->_width && y1 < dev->_height) {
+		lcdBlitGlyph(dev, fonts, pw, ph, x0, y0, x1, y1, color);
+		if (next < 0) next = 0;
+		return next;
+	}
+
 	if (dev->_font_fill) lcdDrawFillRect(dev, x0, y0, x1, y1, dev->_font_fill_color);
 
 	int bits;
@@ -1068,7 +1270,10 @@ void lcdWrapArround(TFT_t * dev, SCROLL_TYPE_t scroll, int start, int end) {
 // Draw Frame Buffer
 void lcdDrawFinish(TFT_t *dev)
 {
-	if (dev->_use_frame_buffer == false) return;
+	if (dev->_use_frame_buffer == false) {
+		spi_master_wait(dev);
+		return;
+	}
 
 	spi_master_write_command(dev, 0x2A); // set column(x) address
 	spi_master_write_addr(dev, dev->_offsetx, dev->_offsetx+dev->_width-1);
@@ -1086,5 +1291,6 @@ void lcdDrawFinish(TFT_t *dev)
 		size -= bs;
 		image += bs;
 	}
+	spi_master_wait(dev);
 	return;
 }
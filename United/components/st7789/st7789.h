@@ -16,6 +16,10 @@
 #define CYAN   rgb565(  0, 156, 209) // 0x04FA
 #define PURPLE rgb565(128,   0, 128) // 0x8010
 
+// Queued SPI (CONFIG_ASYNC_SPI)
+#define LCD_QUEUE_SIZE 7
+#define LCD_CHUNK_SIZE 4000 // bytes per DMA chunk, two chunks
+
 typedef enum {DIRECTION0, DIRECTION90, DIRECTION180, DIRECTION270} DIRECTION;
 
 typedef enum {
@@ -40,6 +44,15 @@ typedef struct {
 	spi_device_handle_t _SPIHandle;
 	bool _use_frame_buffer;
 	uint16_t *_frame_buffer;
+	bool _async;
+	spi_transaction_t _trans[LCD_QUEUE_SIZE];
+	int8_t _trans_chunk[LCD_QUEUE_SIZE];	// chunk read by the transaction, -1:none
+	uint8_t _trans_head;
+	uint8_t _trans_count;
+	uint8_t *_chunk[2];
+	uint8_t _chunk_busy[2];					// queued transactions reading the chunk
+	uint8_t _chunk_next;
+	uint32_t _bus_waits;					// CPU waited for the bus
 } TFT_t;
 
 void spi_clock_speed(int speed);
@@ -51,6 +64,7 @@ bool spi_master_write_data_word(TFT_t * dev, uint16_t data);
 bool spi_master_write_addr(TFT_t * dev, uint16_t addr1, uint16_t addr2);
 bool spi_master_write_color(TFT_t * dev, uint16_t color, uint16_t size);
 bool spi_master_write_colors(TFT_t * dev, uint16_t * colors, uint16_t size);
+void spi_master_wait(TFT_t * dev);
 
 void delayMS(int ms);
 void lcdInit(TFT_t * dev, int width, int height, int offsetx, int offsety);
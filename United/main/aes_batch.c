@@ -0,0 +1,80 @@
+#include <string.h>
+
+#include "aes_batch.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#if defined(CONFIG_MBEDTLS_HARDWARE_AES) && defined(CONFIG_IDF_TARGET_ESP32)
+#include "aes/esp_aes.h"
+#include "hal/aes_hal.h"
+#define AES_BATCH_HW 1
+#endif
+#endif
+
+void aes_batch_init(aes_batch_t *b)
+{
+    memset(b, 0, sizeof(*b));
+    mbedtls_aes_init(&b->sw);
+}
+
+void aes_batch_free(aes_batch_t *b)
+{
+    mbedtls_aes_free(&b->sw);
+    memset(b->key, 0, sizeof(b->key));
+    b->key_valid = false;
+}
+
+void aes_batch_setkey(aes_batch_t *b, const uint8_t key[AES_BATCH_KEY_SIZE], int mode)
+{
+    if (b->key_valid && b->mode == mode && memcmp(b->key, key, AES_BATCH_KEY_SIZE) == 0) {
+        return;
+    }
+    memcpy(b->key, key, AES_BATCH_KEY_SIZE);
+    b->mode = mode;
+    b->key_valid = true;
+    b->key_loads++;
+#ifndef AES_BATCH_HW
+    if (mode == AES_BATCH_ENCRYPT) {
+        mbedtls_aes_setkey_enc(&b->sw, key, AES_BATCH_KEY_SIZE * 8);
+    } else {
+        mbedtls_aes_setkey_dec(&b->sw, key, AES_BATCH_KEY_SIZE * 8);
+    }
+#endif
+}
+
+bool aes_batch_run(aes_batch_t *b, const aes_batch_seg_t *segs, int count)
+{
+    size_t blocks = 0;
+
+    if (!b->key_valid) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (segs[i].len % AES_BATCH_BLOCK != 0) {
+            return false;
+        }
+        blocks += segs[i].len / AES_BATCH_BLOCK;
+    }
+
+#ifdef AES_BATCH_HW
+    // Блок AES захоплюється на весь виклик: ключ завантажується один раз
+    esp_aes_acquire_hardware();
+    aes_hal_setkey(b->key, AES_BATCH_KEY_SIZE, b->mode);
+    for (int i = 0; i < count; i++) {
+        for (size_t off = 0; off < segs[i].len; off += AES_BATCH_BLOCK) {
+            aes_hal_transform_block(segs[i].in + off, segs[i].out + off);
+        }
+    }
+    esp_aes_release_hardware();
+#else
+    for (int i = 0; i < count; i++) {
+        for (size_t off = 0; off < segs[i].len; off += AES_BATCH_BLOCK) {
+            mbedtls_aes_crypt_ecb(&b->sw, b->mode, segs[i].in + off, segs[i].out + off);
+        }
+    }
+#endif
+
+    b->batches++;
+    b->blocks += blocks;
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef MAIN_AES_BATCH_H_
+#define MAIN_AES_BATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mbedtls/aes.h"
+
+// Пакетне шифрування AES-128-ECB: кілька фрагментів (кадри і копія FEC,
+// суміші для всіх станцій) одним викликом.
+//
+// На ESP32 апаратний блок AES захоплюється і отримує ключ один раз на весь
+// виклик, далі блоки йдуть підряд через регістри. Окремий mbedtls_aes_crypt_ecb
+// робить це на кожен блок. DMA для AES в ESP32 немає, тож шифрування однаково
+// займає ядро, що його викликало. Без апаратного AES і на хості - програмний
+// mbedTLS з тим самим результатом; розклад ключа рахується лише при зміні ключа.
+
+#define AES_BATCH_BLOCK 16
+#define AES_BATCH_KEY_SIZE 16
+
+#define AES_BATCH_ENCRYPT MBEDTLS_AES_ENCRYPT
+#define AES_BATCH_DECRYPT MBEDTLS_AES_DECRYPT
+
+// Фрагмент: довжина кратна AES_BATCH_BLOCK, in і out можуть збігатися
+typedef struct {
+    const uint8_t *in;
+    uint8_t *out;
+    size_t len;
+} aes_batch_seg_t;
+
+typedef struct {
+    bool key_valid;
+    int mode;                   // AES_BATCH_ENCRYPT або AES_BATCH_DECRYPT
+    uint8_t key[AES_BATCH_KEY_SIZE];
+    mbedtls_aes_context sw;     // Програмний шлях
+
+    // Лічильники
+    uint32_t batches;
+    uint32_t blocks;
+    uint32_t key_loads;         // Змін ключа
+} aes_batch_t;
+
+void aes_batch_init(aes_batch_t *b);
+void aes_batch_free(aes_batch_t *b);
+
+// Ключ і напрямок для наступних викликів. Той самий ключ повторно - без роботи
+void aes_batch_setkey(aes_batch_t *b, const uint8_t key[AES_BATCH_KEY_SIZE], int mode);
+
+// Усі фрагменти поточним ключем. false - довжина не кратна блоку, нічого не зроблено
+bool aes_batch_run(aes_batch_t *b, const aes_batch_seg_t *segs, int count);
+
+// Один фрагмент
+static inline bool aes_batch_crypt(aes_batch_t *b, const uint8_t *in, uint8_t *out, size_t len)
+{
+    aes_batch_seg_t seg = { .in = in, .out = out, .len = len };
+    return aes_batch_run(b, &seg, 1);
+}
+
+#endif /* MAIN_AES_BATCH_H_ */
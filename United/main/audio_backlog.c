@@ -0,0 +1,54 @@
+#include <string.h>
+
+#include "audio_backlog.h"
+
+void audio_backlog_init(audio_backlog_t *b)
+{
+    memset(b, 0, sizeof(*b));
+}
+
+static int slot(const audio_backlog_t *b, int i)
+{
+    return (b->head + i) % AUDIO_BACKLOG_FRAMES;
+}
+
+uint8_t *audio_backlog_push(audio_backlog_t *b, uint32_t capture_ms)
+{
+    if (b->count == AUDIO_BACKLOG_FRAMES) {
+        b->head = slot(b, 1);
+        b->count--;
+        b->overwritten++;
+    }
+    int tail = slot(b, b->count);
+    b->capture_ms[tail] = capture_ms;
+    b->count++;
+    b->stored++;
+    return b->frames[tail];
+}
+
+int audio_backlog_expire(audio_backlog_t *b, uint32_t now_ms, uint32_t max_age_ms)
+{
+    int removed = 0;
+    while (b->count > 0 && (uint32_t)(now_ms - b->capture_ms[b->head]) > max_age_ms) {
+        b->head = slot(b, 1);
+        b->count--;
+        removed++;
+    }
+    b->expired += removed;
+    return removed;
+}
+
+const uint8_t *audio_backlog_peek(const audio_backlog_t *b, int i)
+{
+    return b->frames[slot(b, i)];
+}
+
+void audio_backlog_pop(audio_backlog_t *b, int n)
+{
+    if (n > b->count) {
+        n = b->count;
+    }
+    b->head = slot(b, n);
+    b->count -= n;
+    b->sent += n;
+}
@@ -0,0 +1,49 @@
+#ifndef MAIN_AUDIO_BACKLOG_H_
+#define MAIN_AUDIO_BACKLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Кільцевий буфер кадрів, захоплених під час перерви зв'язку.
+// Кадри зберігаються проріджені вчетверо (як на найнижчому рівні якості),
+// тож ~300 мс звуку займають менше 7 КБ. Коли буфер повний, найстаріший
+// кадр витісняється: розмір буфера обмежує і пам'ять, і зайву затримку,
+// яку отримає слухач після відновлення.
+
+#define AUDIO_BACKLOG_FRAMES 26         // ~300 мс при кадрі 11.6 мс
+#define AUDIO_BACKLOG_DECIM_SHIFT 2
+#define AUDIO_BACKLOG_FRAME_BYTES 256   // Кадр 1024 байти після проріджування
+
+typedef struct {
+    uint8_t frames[AUDIO_BACKLOG_FRAMES][AUDIO_BACKLOG_FRAME_BYTES];
+    uint32_t capture_ms[AUDIO_BACKLOG_FRAMES];
+    uint8_t head;               // Найстаріший кадр
+    uint8_t count;
+
+    // Лічильники
+    uint32_t stored;
+    uint32_t sent;
+    uint32_t overwritten;       // Витіснені новішими
+    uint32_t expired;           // Застаріли до відновлення зв'язку
+} audio_backlog_t;
+
+void audio_backlog_init(audio_backlog_t *b);
+
+// Місце під новий кадр у кінці черги, за потреби витісняє найстаріший
+uint8_t *audio_backlog_push(audio_backlog_t *b, uint32_t capture_ms);
+
+// Відкидає кадри, захоплені раніше ніж max_age_ms тому. Повертає кількість відкинутих
+int audio_backlog_expire(audio_backlog_t *b, uint32_t now_ms, uint32_t max_age_ms);
+
+// i-й від початку кадр, i < count
+const uint8_t *audio_backlog_peek(const audio_backlog_t *b, int i);
+
+// Видалення n кадрів з початку черги після відправки
+void audio_backlog_pop(audio_backlog_t *b, int n);
+
+static inline bool audio_backlog_empty(const audio_backlog_t *b)
+{
+    return b->count == 0;
+}
+
+#endif /* MAIN_AUDIO_BACKLOG_H_ */
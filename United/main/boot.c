@@ -0,0 +1,86 @@
+#include <inttypes.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "boot.h"
+
+static const char *TAG = "Boot";
+
+typedef struct {
+    const char *stage;
+    uint32_t ms;
+} boot_event_t;
+
+static EventGroupHandle_t boot_group;
+static boot_event_t timeline[BOOT_TIMELINE_MAX];
+static int timeline_count = 0;
+static bool timeline_logged = false;
+static portMUX_TYPE timeline_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void boot_init(void)
+{
+    boot_group = xEventGroupCreate();
+}
+
+static void log_timeline(void)
+{
+    boot_event_t copy[BOOT_TIMELINE_MAX];
+    int count;
+
+    taskENTER_CRITICAL(&timeline_lock);
+    count = timeline_count;
+    for (int i = 0; i < count; i++) {
+        copy[i] = timeline[i];
+    }
+    taskEXIT_CRITICAL(&timeline_lock);
+
+    ESP_LOGI(TAG, "Ready for PTT after %" PRIu32 " ms:", copy[count - 1].ms);
+    for (int i = 0; i < count; i++) {
+        uint32_t delta = i > 0 ? copy[i].ms - copy[i - 1].ms : copy[i].ms;
+        ESP_LOGI(TAG, "  %6" PRIu32 " ms (+%4" PRIu32 ") %s", copy[i].ms, delta, copy[i].stage);
+    }
+}
+
+void boot_mark(const char *stage)
+{
+    uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    taskENTER_CRITICAL(&timeline_lock);
+    if (timeline_count < BOOT_TIMELINE_MAX) {
+        timeline[timeline_count].stage = stage;
+        timeline[timeline_count].ms = ms;
+        timeline_count++;
+    }
+    taskEXIT_CRITICAL(&timeline_lock);
+
+    ESP_LOGI(TAG, "+%" PRIu32 " ms: %s", ms, stage);
+}
+
+void boot_signal(EventBits_t bits, const char *stage)
+{
+    EventBits_t before = xEventGroupGetBits(boot_group);
+    if ((before & bits) == bits) {
+        return; // Вже готово, повторні події (перепідключення) хронологію не змінюють
+    }
+
+    boot_mark(stage);
+    EventBits_t now = xEventGroupSetBits(boot_group, bits);
+
+    bool log = false;
+    taskENTER_CRITICAL(&timeline_lock);
+    if ((now & BOOT_PTT_READY) == BOOT_PTT_READY && !timeline_logged) {
+        timeline_logged = true;
+        log = true;
+    }
+    taskEXIT_CRITICAL(&timeline_lock);
+    if (log) {
+        log_timeline();
+    }
+}
+
+bool boot_wait(EventBits_t bits, TickType_t timeout)
+{
+    EventBits_t got = xEventGroupWaitBits(boot_group, bits, pdFALSE, pdTRUE, timeout);
+    return (got & bits) == bits;
+}
@@ -0,0 +1,32 @@
+#ifndef MAIN_BOOT_H_
+#define MAIN_BOOT_H_
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+// Готовність підсистем під час старту. Кожна задача чекає лише на ті біти,
+// від яких залежить, замість фіксованої затримки в app_main.
+// Етапи запам'ятовуються в хронології, яка виводиться, щойно пристрій готовий до PTT.
+
+#define BOOT_NETIF_UP       (1 << 0)    // Є IP адреса (або точка доступу запущена)
+#define BOOT_PEER_KNOWN     (1 << 1)    // Відомо, кому передавати аудіо
+#define BOOT_I2S_READY      (1 << 2)    // Мікрофон і динамік увімкнено
+#define BOOT_DISPLAY_READY  (1 << 3)
+#define BOOT_PTT_READY      (BOOT_NETIF_UP | BOOT_PEER_KNOWN | BOOT_I2S_READY)
+
+#define BOOT_TIMELINE_MAX 16
+
+void boot_init(void);
+
+// Етап завантаження в хронологію (без зміни бітів)
+void boot_mark(const char *stage);
+
+// Підсистема готова: встановлює біти і додає етап у хронологію
+void boot_signal(EventBits_t bits, const char *stage);
+
+// Очікування всіх бітів. Повертає true, якщо дочекались до тайм-ауту
+bool boot_wait(EventBits_t bits, TickType_t timeout);
+
+#endif /* MAIN_BOOT_H_ */
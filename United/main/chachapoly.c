@@ -0,0 +1,347 @@
+#include <string.h>
+
+#include "chachapoly.h"
+
+static inline uint32_t load32_le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32_le(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void store64_le(uint8_t *p, uint64_t v)
+{
+    store32_le(p, (uint32_t)v);
+    store32_le(p + 4, (uint32_t)(v >> 32));
+}
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER(a, b, c, d)                     \
+    a += b; d ^= a; d = ROTL32(d, 16);          \
+    c += d; b ^= c; b = ROTL32(b, 12);          \
+    a += b; d ^= a; d = ROTL32(d, 8);           \
+    c += d; b ^= c; b = ROTL32(b, 7)
+
+// Один блок ключового потоку. Стан - окремі змінні, не масив: інакше
+// компілятор тримає його в пам'яті і кожне обертання йде через load/store
+static void chacha20_block(const uint32_t in[16], uint8_t out[CHACHA_BLOCK_SIZE])
+{
+    uint32_t x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3];
+    uint32_t x4 = in[4], x5 = in[5], x6 = in[6], x7 = in[7];
+    uint32_t x8 = in[8], x9 = in[9], x10 = in[10], x11 = in[11];
+    uint32_t x12 = in[12], x13 = in[13], x14 = in[14], x15 = in[15];
+
+    for (int i = 0; i < 10; i++) {
+        QUARTER(x0, x4, x8, x12);
+        QUARTER(x1, x5, x9, x13);
+        QUARTER(x2, x6, x10, x14);
+        QUARTER(x3, x7, x11, x15);
+        QUARTER(x0, x5, x10, x15);
+        QUARTER(x1, x6, x11, x12);
+        QUARTER(x2, x7, x8, x13);
+        QUARTER(x3, x4, x9, x14);
+    }
+
+    store32_le(out + 0, x0 + in[0]);
+    store32_le(out + 4, x1 + in[1]);
+    store32_le(out + 8, x2 + in[2]);
+    store32_le(out + 12, x3 + in[3]);
+    store32_le(out + 16, x4 + in[4]);
+    store32_le(out + 20, x5 + in[5]);
+    store32_le(out + 24, x6 + in[6]);
+    store32_le(out + 28, x7 + in[7]);
+    store32_le(out + 32, x8 + in[8]);
+    store32_le(out + 36, x9 + in[9]);
+    store32_le(out + 40, x10 + in[10]);
+    store32_le(out + 44, x11 + in[11]);
+    store32_le(out + 48, x12 + in[12]);
+    store32_le(out + 52, x13 + in[13]);
+    store32_le(out + 56, x14 + in[14]);
+    store32_le(out + 60, x15 + in[15]);
+}
+
+static void chacha20_init(uint32_t state[16], const uint8_t key[CHACHA_KEY_SIZE],
+                          const uint8_t nonce[CHACHA_NONCE_SIZE], uint32_t counter)
+{
+    state[0] = 0x61707865;  // "expand 32-byte k"
+    state[1] = 0x3320646e;
+    state[2] = 0x79622d32;
+    state[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) {
+        state[4 + i] = load32_le(key + i * 4);
+    }
+    state[12] = counter;
+    state[13] = load32_le(nonce);
+    state[14] = load32_le(nonce + 4);
+    state[15] = load32_le(nonce + 8);
+}
+
+void chacha20_xor(const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE],
+                  uint32_t counter, uint8_t *buf, size_t len)
+{
+    uint32_t state[16];
+    uint8_t ks[CHACHA_BLOCK_SIZE];
+
+    chacha20_init(state, key, nonce, counter);
+    while (len > 0) {
+        size_t n = len < CHACHA_BLOCK_SIZE ? len : CHACHA_BLOCK_SIZE;
+        chacha20_block(state, ks);
+        for (size_t i = 0; i < n; i++) {
+            buf[i] ^= ks[i];
+        }
+        state[12]++;
+        buf += n;
+        len -= n;
+    }
+    memset(ks, 0, sizeof(ks));
+    memset(state, 0, sizeof(state));
+}
+
+void poly1305_init(poly1305_t *p, const uint8_t key[32])
+{
+    // r з обнуленими за RFC 8439 бітами, у 26-бітних розрядах
+    p->r[0] = load32_le(key + 0) & 0x3ffffff;
+    p->r[1] = (load32_le(key + 3) >> 2) & 0x3ffff03;
+    p->r[2] = (load32_le(key + 6) >> 4) & 0x3ffc0ff;
+    p->r[3] = (load32_le(key + 9) >> 6) & 0x3f03fff;
+    p->r[4] = (load32_le(key + 12) >> 8) & 0x00fffff;
+    memset(p->h, 0, sizeof(p->h));
+    for (int i = 0; i < 4; i++) {
+        p->pad[i] = load32_le(key + 16 + i * 4);
+    }
+    p->buf_len = 0;
+}
+
+// h = (h + m) * r mod 2^130 - 5 для кожного 16-байтового блоку
+static void poly1305_blocks(poly1305_t *p, const uint8_t *m, size_t len, uint32_t hibit)
+{
+    const uint32_t r0 = p->r[0], r1 = p->r[1], r2 = p->r[2], r3 = p->r[3], r4 = p->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2], h3 = p->h[3], h4 = p->h[4];
+
+    while (len >= 16) {
+        h0 += load32_le(m + 0) & 0x3ffffff;
+        h1 += (load32_le(m + 3) >> 2) & 0x3ffffff;
+        h2 += (load32_le(m + 6) >> 4) & 0x3ffffff;
+        h3 += (load32_le(m + 9) >> 6) & 0x3ffffff;
+        h4 += (load32_le(m + 12) >> 8) | hibit;
+
+        uint64_t d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        uint64_t d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        uint64_t d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        uint64_t d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 + (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        uint64_t d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 + (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+        uint32_t c = (uint32_t)(d0 >> 26);
+        h0 = (uint32_t)d0 & 0x3ffffff;
+        d1 += c;
+        c = (uint32_t)(d1 >> 26);
+        h1 = (uint32_t)d1 & 0x3ffffff;
+        d2 += c;
+        c = (uint32_t)(d2 >> 26);
+        h2 = (uint32_t)d2 & 0x3ffffff;
+        d3 += c;
+        c = (uint32_t)(d3 >> 26);
+        h3 = (uint32_t)d3 & 0x3ffffff;
+        d4 += c;
+        c = (uint32_t)(d4 >> 26);
+        h4 = (uint32_t)d4 & 0x3ffffff;
+        h0 += c * 5;
+        c = h0 >> 26;
+        h0 &= 0x3ffffff;
+        h1 += c;
+
+        m += 16;
+        len -= 16;
+    }
+
+    p->h[0] = h0;
+    p->h[1] = h1;
+    p->h[2] = h2;
+    p->h[3] = h3;
+    p->h[4] = h4;
+}
+
+void poly1305_update(poly1305_t *p, const uint8_t *data, size_t len)
+{
+    if (p->buf_len > 0) {
+        size_t n = 16 - p->buf_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(p->buf + p->buf_len, data, n);
+        p->buf_len += n;
+        data += n;
+        len -= n;
+        if (p->buf_len < 16) {
+            return;
+        }
+        poly1305_blocks(p, p->buf, 16, 1u << 24);
+        p->buf_len = 0;
+    }
+    size_t full = len & ~(size_t)15;
+    poly1305_blocks(p, data, full, 1u << 24);
+    memcpy(p->buf, data + full, len - full);
+    p->buf_len = len - full;
+}
+
+void poly1305_finish(poly1305_t *p, uint8_t tag[POLY1305_TAG_SIZE])
+{
+    if (p->buf_len > 0) {
+        p->buf[p->buf_len] = 1;
+        memset(p->buf + p->buf_len + 1, 0, 16 - p->buf_len - 1);
+        poly1305_blocks(p, p->buf, 16, 0);
+    }
+
+    uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2], h3 = p->h[3], h4 = p->h[4];
+    uint32_t c;
+
+    // Повне перенесення
+    c = h1 >> 26;
+    h1 &= 0x3ffffff;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= 0x3ffffff;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= 0x3ffffff;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= 0x3ffffff;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= 0x3ffffff;
+    h1 += c;
+
+    // g = h - p; якщо g >= 0, результат g (вибір без розгалужень)
+    uint32_t g0 = h0 + 5;
+    c = g0 >> 26;
+    g0 &= 0x3ffffff;
+    uint32_t g1 = h1 + c;
+    c = g1 >> 26;
+    g1 &= 0x3ffffff;
+    uint32_t g2 = h2 + c;
+    c = g2 >> 26;
+    g2 &= 0x3ffffff;
+    uint32_t g3 = h3 + c;
+    c = g3 >> 26;
+    g3 &= 0x3ffffff;
+    uint32_t g4 = h4 + c - (1u << 26);
+
+    uint32_t mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // h + s mod 2^128
+    uint32_t w0 = h0 | (h1 << 26);
+    uint32_t w1 = (h1 >> 6) | (h2 << 20);
+    uint32_t w2 = (h2 >> 12) | (h3 << 14);
+    uint32_t w3 = (h3 >> 18) | (h4 << 8);
+    uint64_t f = (uint64_t)w0 + p->pad[0];
+    store32_le(tag + 0, (uint32_t)f);
+    f = (uint64_t)w1 + p->pad[1] + (f >> 32);
+    store32_le(tag + 4, (uint32_t)f);
+    f = (uint64_t)w2 + p->pad[2] + (f >> 32);
+    store32_le(tag + 8, (uint32_t)f);
+    f = (uint64_t)w3 + p->pad[3] + (f >> 32);
+    store32_le(tag + 12, (uint32_t)f);
+
+    memset(p, 0, sizeof(*p));
+}
+
+static void poly1305_pad16(poly1305_t *p, uint64_t len)
+{
+    static const uint8_t zero[16] = { 0 };
+
+    if (len % 16 != 0) {
+        poly1305_update(p, zero, 16 - len % 16);
+    }
+}
+
+void chachapoly_start(chachapoly_t *c, const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE])
+{
+    uint8_t poly_key[CHACHA_BLOCK_SIZE] = { 0 };
+
+    // Ключ Poly1305 - перші 32 байти блоку 0, кадри шифруються з блоку 1
+    chacha20_xor(key, nonce, 0, poly_key, sizeof(poly_key));
+    poly1305_init(&c->mac, poly_key);
+    memset(poly_key, 0, sizeof(poly_key));
+    c->aad_len = 0;
+    c->ct_len = 0;
+    c->in_ct = false;
+}
+
+void chachapoly_aad(chachapoly_t *c, const uint8_t *data, size_t len)
+{
+    poly1305_update(&c->mac, data, len);
+    c->aad_len += len;
+}
+
+void chachapoly_ct(chachapoly_t *c, const uint8_t *data, size_t len)
+{
+    if (!c->in_ct) {
+        poly1305_pad16(&c->mac, c->aad_len);
+        c->in_ct = true;
+    }
+    poly1305_update(&c->mac, data, len);
+    c->ct_len += len;
+}
+
+void chachapoly_finish(chachapoly_t *c, uint8_t tag[POLY1305_TAG_SIZE])
+{
+    uint8_t lens[16];
+
+    if (!c->in_ct) {
+        poly1305_pad16(&c->mac, c->aad_len);
+    }
+    poly1305_pad16(&c->mac, c->ct_len);
+    store64_le(lens, c->aad_len);
+    store64_le(lens + 8, c->ct_len);
+    poly1305_update(&c->mac, lens, sizeof(lens));
+    poly1305_finish(&c->mac, tag);
+}
+
+void chachapoly_encrypt_inplace(const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE],
+                                const uint8_t *aad, size_t aad_len, uint8_t *buf, size_t len,
+                                uint8_t tag[POLY1305_TAG_SIZE])
+{
+    chachapoly_t c;
+
+    chacha20_xor(key, nonce, 1, buf, len);
+    chachapoly_start(&c, key, nonce);
+    chachapoly_aad(&c, aad, aad_len);
+    chachapoly_ct(&c, buf, len);
+    chachapoly_finish(&c, tag);
+}
+
+bool chachapoly_decrypt_inplace(const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE],
+                                const uint8_t *aad, size_t aad_len, uint8_t *buf, size_t len,
+                                const uint8_t tag[POLY1305_TAG_SIZE])
+{
+    chachapoly_t c;
+    uint8_t expected[POLY1305_TAG_SIZE];
+    uint8_t diff = 0;
+
+    chachapoly_start(&c, key, nonce);
+    chachapoly_aad(&c, aad, aad_len);
+    chachapoly_ct(&c, buf, len);
+    chachapoly_finish(&c, expected);
+    for (int i = 0; i < POLY1305_TAG_SIZE; i++) {
+        diff |= expected[i] ^ tag[i];
+    }
+    if (diff != 0) {
+        return false;
+    }
+    chacha20_xor(key, nonce, 1, buf, len);
+    return true;
+}
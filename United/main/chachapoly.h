@@ -0,0 +1,61 @@
+#ifndef MAIN_CHACHAPOLY_H_
+#define MAIN_CHACHAPOLY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ChaCha20-Poly1305 (RFC 8439) - програмна альтернатива AES для аудіо, коли
+// апаратний блок AES зайнятий або його немає. Лише додавання, XOR і
+// обертання 32-бітних слів: стан ChaCha20 - 16 локальних змінних, які на
+// Xtensa вміщаються у вікно регістрів (обертання - одна інструкція SRC),
+// Poly1305 - п'ять 26-бітних розрядів з множенням 32x32->64.
+//
+// Шифрування на місці. Тег можна перевірити окремо від дешифрування
+// (chachapoly_start/aad/ct/finish), щоб підроблений пакет не дешифрувати.
+
+#define CHACHA_KEY_SIZE 32
+#define CHACHA_NONCE_SIZE 12
+#define CHACHA_BLOCK_SIZE 64
+#define POLY1305_TAG_SIZE 16
+
+// Ключовий потік з блоку counter, XOR з buf на місці
+void chacha20_xor(const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE],
+                  uint32_t counter, uint8_t *buf, size_t len);
+
+typedef struct {
+    uint32_t r[5];
+    uint32_t h[5];
+    uint32_t pad[4];
+    uint8_t buf[16];
+    size_t buf_len;
+} poly1305_t;
+
+void poly1305_init(poly1305_t *p, const uint8_t key[32]);
+void poly1305_update(poly1305_t *p, const uint8_t *data, size_t len);
+void poly1305_finish(poly1305_t *p, uint8_t tag[POLY1305_TAG_SIZE]);
+
+// Тег AEAD по частинах: спершу всі додаткові дані (aad), потім шифротекст (ct)
+typedef struct {
+    poly1305_t mac;
+    uint64_t aad_len;
+    uint64_t ct_len;
+    bool in_ct;                 // Додаткові дані закінчились і доповнені
+} chachapoly_t;
+
+void chachapoly_start(chachapoly_t *c, const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE]);
+void chachapoly_aad(chachapoly_t *c, const uint8_t *data, size_t len);
+void chachapoly_ct(chachapoly_t *c, const uint8_t *data, size_t len);
+void chachapoly_finish(chachapoly_t *c, uint8_t tag[POLY1305_TAG_SIZE]);
+
+// Шифрування buf на місці і тег
+void chachapoly_encrypt_inplace(const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE],
+                                const uint8_t *aad, size_t aad_len, uint8_t *buf, size_t len,
+                                uint8_t tag[POLY1305_TAG_SIZE]);
+
+// Перевірка тегу (за сталий час), і лише тоді дешифрування buf на місці
+bool chachapoly_decrypt_inplace(const uint8_t key[CHACHA_KEY_SIZE], const uint8_t nonce[CHACHA_NONCE_SIZE],
+                                const uint8_t *aad, size_t aad_len, uint8_t *buf, size_t len,
+                                const uint8_t tag[POLY1305_TAG_SIZE]);
+
+#endif /* MAIN_CHACHAPOLY_H_ */
@@ -0,0 +1,55 @@
+#include <string.h>
+
+#include "channel.h"
+
+void channel_init(channel_set_t *cs, uint8_t tx, uint8_t priority, uint32_t fixed)
+{
+    memset(cs, 0, sizeof(*cs));
+    cs->tx = tx;
+    cs->priority = priority;
+    cs->fixed = fixed & ~1u; // Канал 0 - службові пакети, не підписка
+    cs->subscribed = cs->fixed;
+    channel_subscribe(cs, tx, true);
+    channel_subscribe(cs, priority, true);
+}
+
+void channel_subscribe(channel_set_t *cs, uint8_t ch, bool on)
+{
+    if (ch == 0 || ch > CHANNEL_MAX) {
+        return;
+    }
+    if (on) {
+        cs->subscribed |= 1u << ch;
+    } else if (ch != cs->tx && ch != cs->priority && !((cs->fixed >> ch) & 1)) {
+        cs->subscribed &= ~(1u << ch);
+    }
+}
+
+void channel_set_tx(channel_set_t *cs, uint8_t tx)
+{
+    uint8_t old = cs->tx;
+
+    cs->tx = tx;
+    channel_subscribe(cs, tx, true);
+    channel_subscribe(cs, old, false);
+}
+
+bool channel_accept_audio(channel_set_t *cs, uint8_t ch, uint32_t now_ms)
+{
+    if (!channel_subscribed(cs, ch)) {
+        cs->unsubscribed++;
+        return false;
+    }
+
+    bool idle = cs->active == 0 || (uint32_t)(now_ms - cs->active_ms) > CHANNEL_HOLD_MS;
+    if (!idle && ch != cs->active) {
+        if (ch != cs->priority) {
+            cs->busy++;
+            return false;
+        }
+        cs->preemptions++;
+    }
+    cs->active = ch;
+    cs->active_ms = now_ms;
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef MAIN_CHANNEL_H_
+#define MAIN_CHANNEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Розмовні канали. Ідентифікатор каналу - байт GROUP заголовка пакета (1..31,
+// 0 - службові пакети для всіх). Приймач тримає бітову маску підписок, тож
+// рішення про чужий канал - одна перевірка біта ще до дешифрування.
+//
+// Відтворюється один канал за раз: перший почутий тримає динамік, доки аудіо
+// на ньому не замовкне на CHANNEL_HOLD_MS. Пріоритетний канал (екстрений
+// виклик) перебиває будь-який інший одразу. Чиста логіка без мережі.
+
+#define CHANNEL_MAX 31
+#define CHANNEL_HOLD_MS 300
+
+typedef struct {
+    uint32_t subscribed;        // Біт на канал
+    uint32_t fixed;             // Підписки, які не знімаються зі зміною каналу
+    uint8_t tx;                 // Канал, на якому говоримо
+    uint8_t priority;           // Пріоритетний канал, 0 - немає
+    uint8_t active;             // Канал, що зараз відтворюється, 0 - жоден
+    uint32_t active_ms;         // Останній відтворений пакет активного каналу
+
+    // Лічильники
+    uint32_t unsubscribed;      // Пакети каналів без підписки
+    uint32_t busy;              // Аудіо, відкинуте через зайнятий динамік
+    uint32_t preemptions;
+} channel_set_t;
+
+// fixed - канали, які слухаємо завжди (біт на канал). Підписка на tx і priority вмикається теж
+void channel_init(channel_set_t *cs, uint8_t tx, uint8_t priority, uint32_t fixed);
+
+void channel_subscribe(channel_set_t *cs, uint8_t ch, bool on);
+
+// Зміна власного каналу. Підписка на попередній знімається, якщо він не серед fixed
+void channel_set_tx(channel_set_t *cs, uint8_t tx);
+
+static inline bool channel_subscribed(const channel_set_t *cs, uint8_t ch)
+{
+    return ch <= CHANNEL_MAX && (cs->subscribed >> ch) & 1;
+}
+
+// Рішення для аудіо пакета каналу ch: true - відтворювати
+bool channel_accept_audio(channel_set_t *cs, uint8_t ch, uint32_t now_ms);
+
+#endif /* MAIN_CHANNEL_H_ */
@@ -0,0 +1,74 @@
+#include <string.h>
+
+#include "cmac.h"
+
+// Множення на x у GF(2^128)
+static void double_block(uint8_t out[CMAC_BLOCK_SIZE], const uint8_t in[CMAC_BLOCK_SIZE])
+{
+    uint8_t carry = in[0] >> 7;
+
+    for (int i = 0; i < CMAC_BLOCK_SIZE - 1; i++) {
+        out[i] = (uint8_t)((in[i] << 1) | (in[i + 1] >> 7));
+    }
+    out[CMAC_BLOCK_SIZE - 1] = (uint8_t)((in[CMAC_BLOCK_SIZE - 1] << 1) ^ (carry ? 0x87 : 0));
+}
+
+static void xor_block(uint8_t *dst, const uint8_t *src)
+{
+    for (int i = 0; i < CMAC_BLOCK_SIZE; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+void cmac_init(cmac_t *c, cmac_cipher_t cipher, void *ctx)
+{
+    uint8_t l[CMAC_BLOCK_SIZE] = { 0 };
+
+    c->cipher = cipher;
+    c->ctx = ctx;
+    cipher(ctx, l, l);
+    double_block(c->k1, l);
+    double_block(c->k2, c->k1);
+    memset(l, 0, sizeof(l));
+    cmac_start(c);
+}
+
+void cmac_start(cmac_t *c)
+{
+    memset(c->x, 0, CMAC_BLOCK_SIZE);
+    c->buf_len = 0;
+}
+
+void cmac_update(cmac_t *c, const uint8_t *data, size_t len)
+{
+    // Останній блок чекає в buf до cmac_finish: лише він маскується підключем
+    while (len > 0) {
+        if (c->buf_len == CMAC_BLOCK_SIZE) {
+            xor_block(c->x, c->buf);
+            c->cipher(c->ctx, c->x, c->x);
+            c->buf_len = 0;
+        }
+        size_t n = CMAC_BLOCK_SIZE - c->buf_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(c->buf + c->buf_len, data, n);
+        c->buf_len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void cmac_finish(cmac_t *c, uint8_t tag[CMAC_BLOCK_SIZE])
+{
+    if (c->buf_len == CMAC_BLOCK_SIZE) {
+        xor_block(c->buf, c->k1);
+    } else {
+        c->buf[c->buf_len] = 0x80;
+        memset(c->buf + c->buf_len + 1, 0, CMAC_BLOCK_SIZE - c->buf_len - 1);
+        xor_block(c->buf, c->k2);
+    }
+    xor_block(c->x, c->buf);
+    c->cipher(c->ctx, c->x, tag);
+    cmac_start(c);
+}
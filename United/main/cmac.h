@@ -0,0 +1,32 @@
+#ifndef MAIN_CMAC_H_
+#define MAIN_CMAC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// AES-CMAC (RFC 4493) поверх зовнішнього блочного шифру, щоб не залежати від
+// конкретної бібліотеки: на пристрої - mbedTLS, на хості - будь-яка реалізація AES.
+
+#define CMAC_BLOCK_SIZE 16
+
+// Шифрування одного блоку ключем автентифікації
+typedef void (*cmac_cipher_t)(void *ctx, const uint8_t in[CMAC_BLOCK_SIZE], uint8_t out[CMAC_BLOCK_SIZE]);
+
+typedef struct {
+    cmac_cipher_t cipher;
+    void *ctx;
+    uint8_t k1[CMAC_BLOCK_SIZE];
+    uint8_t k2[CMAC_BLOCK_SIZE];
+    uint8_t x[CMAC_BLOCK_SIZE];     // Поточне значення ланцюжка
+    uint8_t buf[CMAC_BLOCK_SIZE];   // Неповний (або останній повний) блок
+    size_t buf_len;
+} cmac_t;
+
+// Підключи для ключа: один виклик шифру. Після неї можна рахувати скільки завгодно тегів
+void cmac_init(cmac_t *c, cmac_cipher_t cipher, void *ctx);
+
+void cmac_start(cmac_t *c);
+void cmac_update(cmac_t *c, const uint8_t *data, size_t len);
+void cmac_finish(cmac_t *c, uint8_t tag[CMAC_BLOCK_SIZE]);
+
+#endif /* MAIN_CMAC_H_ */
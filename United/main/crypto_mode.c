@@ -0,0 +1,49 @@
+#include <string.h>
+
+#include "crypto_mode.h"
+
+void crypto_mode_init(crypto_mode_t *m, bool local)
+{
+    memset(m, 0, sizeof(*m));
+    m->local = local;
+}
+
+bool crypto_mode_set_local(crypto_mode_t *m, bool local)
+{
+    if (m->local == local) {
+        return false;
+    }
+    bool was = crypto_mode_tx_encrypted(m);
+    m->local = local;
+    if (crypto_mode_tx_encrypted(m) != was) {
+        m->tx_switches++;
+    }
+    return true;
+}
+
+void crypto_mode_set_peers(crypto_mode_t *m, bool required)
+{
+    bool was = crypto_mode_tx_encrypted(m);
+
+    m->peer_required = required;
+    if (crypto_mode_tx_encrypted(m) != was) {
+        m->tx_switches++;
+    }
+}
+
+bool crypto_mode_rx_accept(crypto_mode_t *m, bool encrypted)
+{
+    if (!encrypted && m->local) {
+        m->plain_rejected++;
+        return false;
+    }
+    return true;
+}
+
+crypto_status_t crypto_mode_status(const crypto_mode_t *m)
+{
+    if (m->local) {
+        return CRYPTO_STATUS_ON;
+    }
+    return m->peer_required ? CRYPTO_STATUS_ON_PEER : CRYPTO_STATUS_OFF;
+}
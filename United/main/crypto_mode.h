@@ -0,0 +1,52 @@
+#ifndef MAIN_CRYPTO_MODE_H_
+#define MAIN_CRYPTO_MODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Узгодження шифрування між пристроями.
+//
+// Кнопка задає лише бажання цього пристрою, воно йде в маяках
+// (PKT_CAP_ENCRYPTED). Передача шифрується, якщо цього хоче сам пристрій або
+// хоч один відомий співрозмовник: безпечніший режим перемагає, тож обидві
+// сторони сходяться до одного режиму за один маяк. Режим кожного пакета
+// записаний у ньому самому (PKT_AUDIO_KEY_NONE - відкритий текст), і приймач
+// дешифрує за пакетом, а не за власним прапорцем, тож перемикання посеред
+// потоку не дає шуму. Відкритий звук, коли пристрій сам вимагає шифрування,
+// не відтворюється.
+
+typedef enum {
+    CRYPTO_STATUS_OFF = 0,
+    CRYPTO_STATUS_ON,           // Увімкнено на цьому пристрої
+    CRYPTO_STATUS_ON_PEER,      // Вимкнено тут, але його вимагає співрозмовник
+} crypto_status_t;
+
+typedef struct {
+    bool local;                 // Бажання цього пристрою
+    bool peer_required;         // Хоч один відомий пристрій вимагає шифрування
+
+    // Лічильники
+    uint32_t tx_switches;       // Зміни режиму передачі
+    uint32_t plain_rejected;    // Відкритий звук, відкинутий через власну вимогу
+} crypto_mode_t;
+
+void crypto_mode_init(crypto_mode_t *m, bool local);
+
+// Натискання кнопки. Повертає true, якщо бажання змінилось - час для маяка
+bool crypto_mode_set_local(crypto_mode_t *m, bool local);
+
+// Підсумок маяків усіх відомих пристроїв
+void crypto_mode_set_peers(crypto_mode_t *m, bool required);
+
+// Чи шифрувати наступний пакет
+static inline bool crypto_mode_tx_encrypted(const crypto_mode_t *m)
+{
+    return m->local || m->peer_required;
+}
+
+// Автентифікований аудіо пакет у режимі encrypted: чи відтворювати його
+bool crypto_mode_rx_accept(crypto_mode_t *m, bool encrypted);
+
+crypto_status_t crypto_mode_status(const crypto_mode_t *m);
+
+#endif /* MAIN_CRYPTO_MODE_H_ */
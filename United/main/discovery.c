@@ -0,0 +1,83 @@
+#include <string.h>
+
+#include "discovery.h"
+
+void discovery_init(discovery_t *d, net_engine_t *net, peer_table_t *peers,
+                    const struct sockaddr_in *dest, uint8_t group, uint16_t node)
+{
+    memset(d, 0, sizeof(*d));
+    d->net = net;
+    d->peers = peers;
+    d->dest = *dest;
+    d->group = group;
+    d->node = node;
+    d->local.version = PKT_BEACON_VERSION;
+    d->local.codec = PKT_CODEC_PCM16;
+    d->kick = true;
+}
+
+void discovery_set_seal(discovery_t *d, discovery_seal_t seal, void *ctx)
+{
+    d->seal = seal;
+    d->seal_ctx = ctx;
+}
+
+void discovery_kick(discovery_t *d)
+{
+    d->kick = true;
+}
+
+static void send_beacon(discovery_t *d, const struct sockaddr_in *dest, uint32_t now_ms)
+{
+    uint8_t buf[PKT_HEADER_SIZE + PKT_BEACON_SIZE + PKT_CONTROL_MAC_SIZE];
+
+    pkt_header_t hdr = {
+        .type = PKT_TYPE_BEACON,
+        .group = d->group,
+        .node = d->node,
+        .seq = d->seq++,
+        .timestamp = now_ms
+    };
+    size_t len = pkt_write_header(buf, &hdr);
+    len += pkt_write_beacon(buf + len, &d->local);
+    if (d->seal) {
+        len = d->seal(d->seal_ctx, buf, len);
+    }
+    if (net_engine_send(d->net, buf, len, dest)) {
+        d->beacons_sent++;
+    }
+}
+
+int discovery_tick(discovery_t *d, uint32_t now_ms)
+{
+    if (d->kick || (uint32_t)(now_ms - d->last_beacon_ms) >= DISCOVERY_BEACON_PERIOD_MS) {
+        d->kick = false;
+        d->last_beacon_ms = now_ms;
+        send_beacon(d, &d->dest, now_ms);
+    }
+
+    int removed = peer_table_expire(d->peers, now_ms, PEER_TIMEOUT_MS);
+    d->expired += removed;
+    return removed;
+}
+
+bool discovery_on_beacon(discovery_t *d, peer_t *peer, const pkt_beacon_t *b, uint32_t now_ms)
+{
+    bool is_new = !peer->info_valid;
+
+    d->beacons_received++;
+    if (!is_new && b->boot_id != 0 && b->boot_id != peer->info.boot_id) {
+        // Ключі і контекст заголовків почались з нуля. Вікна повторів скидає replay_table_set_boot
+        peer_table_reset(peer);
+        d->restarted++;
+        is_new = true;
+    }
+    peer->info = *b;
+    peer->info_valid = true;
+    if (is_new) {
+        // Відповідь лише новому пристрою: обмін завершується за один RTT і не зациклюється
+        d->discovered++;
+        send_beacon(d, &peer->addr, now_ms);
+    }
+    return is_new;
+}
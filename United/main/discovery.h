@@ -0,0 +1,60 @@
+#ifndef MAIN_DISCOVERY_H_
+#define MAIN_DISCOVERY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "net_engine.h"
+#include "peer_table.h"
+
+// Виявлення пристроїв маяками присутності.
+// Маяк розсилається на широкомовну (або multicast) адресу раз на
+// DISCOVERY_BEACON_PERIOD_MS і одразу після підключення до мережі (discovery_kick).
+// Новий пристрій отримує у відповідь адресний маяк, тож обидві сторони
+// дізнаються одна про одну за один обмін, не чекаючи наступного періоду.
+
+#define DISCOVERY_BEACON_PERIOD_MS 1000
+
+// Дописує тег автентифікації до готового маяка buf довжини len. Повертає нову довжину
+typedef size_t (*discovery_seal_t)(void *ctx, uint8_t *buf, size_t len);
+
+typedef struct {
+    net_engine_t *net;
+    peer_table_t *peers;
+    struct sockaddr_in dest;
+    uint8_t group;
+    uint16_t node;
+    uint16_t seq;
+    discovery_seal_t seal;
+    void *seal_ctx;
+
+    pkt_beacon_t local;         // Власні можливості, оновлюються власником
+    volatile bool kick;
+    uint32_t last_beacon_ms;
+
+    // Лічильники
+    uint32_t beacons_sent;
+    uint32_t beacons_received;
+    uint32_t discovered;
+    uint32_t restarted;
+    uint32_t expired;
+} discovery_t;
+
+void discovery_init(discovery_t *d, net_engine_t *net, peer_table_t *peers,
+                    const struct sockaddr_in *dest, uint8_t group, uint16_t node);
+
+// Тег для маяків: мережа ключа не знає, пакет автентифікує власник
+void discovery_set_seal(discovery_t *d, discovery_seal_t seal, void *ctx);
+
+// Позачерговий маяк (можна викликати з іншої задачі)
+void discovery_kick(discovery_t *d);
+
+// Періодичний маяк і видалення пристроїв, яких давно не чути. Повертає кількість видалених
+int discovery_tick(discovery_t *d, uint32_t now_ms);
+
+// Автентифікований і свіжий маяк від peer. Повертає true, якщо пристрій щойно
+// виявлено або він перезапустився (змінився ідентифікатор запуску) - тоді стан
+// потоку від нього скинуто
+bool discovery_on_beacon(discovery_t *d, peer_t *peer, const pkt_beacon_t *b, uint32_t now_ms);
+
+#endif /* MAIN_DISCOVERY_H_ */
@@ -0,0 +1,217 @@
+#include <string.h>
+
+#include "floor_ctl.h"
+
+void floor_ctl_init(floor_ctl_t *fc, uint16_t self, uint8_t priority)
+{
+    memset(fc, 0, sizeof(*fc));
+    fc->self = self;
+    fc->priority = priority;
+    fc->state = FLOOR_IDLE;
+}
+
+static void emit(floor_ctl_t *fc, uint8_t op, uint8_t priority, uint16_t target, uint16_t holder)
+{
+    if (fc->out_count == FLOOR_OUT_MAX) {
+        // Найстаріше повідомлення вже неактуальне
+        memmove(&fc->out[0], &fc->out[1], sizeof(fc->out[0]) * (FLOOR_OUT_MAX - 1));
+        fc->out_count--;
+    }
+    pkt_floor_t *m = &fc->out[fc->out_count++];
+    m->op = op;
+    m->priority = priority;
+    m->target = target;
+    m->holder = holder;
+}
+
+bool floor_ctl_pop(floor_ctl_t *fc, pkt_floor_t *msg)
+{
+    if (fc->out_count == 0) {
+        return false;
+    }
+    *msg = fc->out[0];
+    fc->out_count--;
+    memmove(&fc->out[0], &fc->out[1], sizeof(fc->out[0]) * fc->out_count);
+    return true;
+}
+
+static void enter(floor_ctl_t *fc, floor_state_t state, uint32_t now_ms)
+{
+    fc->state = state;
+    fc->state_ms = now_ms;
+    fc->activity_ms = now_ms;
+}
+
+static void set_taken(floor_ctl_t *fc, uint16_t holder, uint8_t priority, uint32_t now_ms)
+{
+    fc->holder = holder;
+    fc->holder_priority = priority;
+    enter(fc, FLOOR_TAKEN, now_ms);
+}
+
+// Згода від пристрою from. Повторний GRANT (дубль пакета або відповідь
+// на повторний запит) не рахується вдруге. false, якщо from уже погодився
+static bool add_granter(floor_ctl_t *fc, uint16_t from)
+{
+    for (int i = 0; i < fc->grants; i++) {
+        if (fc->granters[i] == from) {
+            return false;
+        }
+    }
+    if (fc->grants == FLOOR_GRANTERS_MAX) {
+        return false;
+    }
+    fc->granters[fc->grants++] = from;
+    return true;
+}
+
+// Запит слова, якщо PTT натиснуто і зараз це можливо
+static void try_request(floor_ctl_t *fc, uint32_t now_ms, int peers)
+{
+    if (!fc->want || fc->state == FLOOR_REQUESTING || fc->state == FLOOR_GRANTED) {
+        return;
+    }
+    if (fc->state == FLOOR_TAKEN && fc->priority <= fc->holder_priority) {
+        return; // Чекаємо, поки власник звільнить слово
+    }
+    if (peers <= 0) {
+        enter(fc, FLOOR_GRANTED, now_ms);
+        return;
+    }
+    fc->grants_needed = peers;
+    fc->grants = 0;
+    enter(fc, FLOOR_REQUESTING, now_ms);
+    emit(fc, PKT_FLOOR_REQUEST, fc->priority, 0, fc->self);
+}
+
+// Чи має запит from з пріоритетом priority перевагу над нашим
+static bool beats_self(const floor_ctl_t *fc, uint16_t from, uint8_t priority)
+{
+    return priority > fc->priority || (priority == fc->priority && from < fc->self);
+}
+
+void floor_ctl_press(floor_ctl_t *fc, uint32_t now_ms, int peers)
+{
+    fc->want = true;
+    try_request(fc, now_ms, peers);
+}
+
+void floor_ctl_release(floor_ctl_t *fc, uint32_t now_ms)
+{
+    fc->want = false;
+    if (fc->state == FLOOR_GRANTED || fc->state == FLOOR_REQUESTING) {
+        emit(fc, PKT_FLOOR_RELEASE, fc->priority, 0, fc->self);
+        enter(fc, FLOOR_IDLE, now_ms);
+    }
+}
+
+static void on_request(floor_ctl_t *fc, uint16_t from, uint8_t priority, uint32_t now_ms)
+{
+    switch (fc->state) {
+    case FLOOR_IDLE:
+        emit(fc, PKT_FLOOR_GRANT, priority, from, from);
+        set_taken(fc, from, priority, now_ms);
+        break;
+
+    case FLOOR_REQUESTING:
+        if (beats_self(fc, from, priority)) {
+            fc->collisions++;
+            emit(fc, PKT_FLOOR_GRANT, priority, from, from);
+            set_taken(fc, from, priority, now_ms);
+        } else {
+            emit(fc, PKT_FLOOR_DENY, fc->priority, from, fc->self);
+        }
+        break;
+
+    case FLOOR_GRANTED:
+        if (priority > fc->priority) {
+            fc->preemptions++;
+            emit(fc, PKT_FLOOR_GRANT, priority, from, from);
+            set_taken(fc, from, priority, now_ms);
+        } else {
+            emit(fc, PKT_FLOOR_DENY, fc->priority, from, fc->self);
+        }
+        break;
+
+    case FLOOR_TAKEN:
+        if (from == fc->holder || priority > fc->holder_priority) {
+            emit(fc, PKT_FLOOR_GRANT, priority, from, from);
+            set_taken(fc, from, priority, now_ms);
+        } else {
+            emit(fc, PKT_FLOOR_DENY, fc->holder_priority, from, fc->holder);
+        }
+        break;
+    }
+}
+
+void floor_ctl_on_msg(floor_ctl_t *fc, uint16_t from, const pkt_floor_t *msg, uint32_t now_ms, int peers)
+{
+    switch (msg->op) {
+    case PKT_FLOOR_REQUEST:
+        on_request(fc, from, msg->priority, now_ms);
+        break;
+
+    case PKT_FLOOR_GRANT:
+        if (msg->target != fc->self || fc->state != FLOOR_REQUESTING) {
+            break;
+        }
+        if (add_granter(fc, from) && fc->grants >= fc->grants_needed) {
+            enter(fc, FLOOR_GRANTED, now_ms);
+        }
+        break;
+
+    case PKT_FLOOR_DENY:
+        if (msg->target != fc->self || fc->state != FLOOR_REQUESTING) {
+            break;
+        }
+        set_taken(fc, msg->holder, msg->priority, now_ms);
+        break;
+
+    case PKT_FLOOR_RELEASE:
+        if (fc->state == FLOOR_TAKEN && fc->holder == from) {
+            enter(fc, FLOOR_IDLE, now_ms);
+            try_request(fc, now_ms, peers);
+        }
+        break;
+    }
+}
+
+void floor_ctl_on_audio(floor_ctl_t *fc, uint16_t from, uint32_t now_ms)
+{
+    switch (fc->state) {
+    case FLOOR_IDLE:
+    case FLOOR_REQUESTING:
+        // Пристрій говорить, хоча запиту ми не бачили
+        set_taken(fc, from, 0, now_ms);
+        break;
+    case FLOOR_TAKEN:
+        if (fc->holder == from) {
+            fc->activity_ms = now_ms;
+        }
+        break;
+    case FLOOR_GRANTED:
+        break;
+    }
+}
+
+void floor_ctl_tick(floor_ctl_t *fc, uint32_t now_ms, int peers)
+{
+    switch (fc->state) {
+    case FLOOR_REQUESTING:
+        if ((uint32_t)(now_ms - fc->state_ms) >= FLOOR_GRANT_TIMEOUT_MS) {
+            // Ніхто не заперечив - відповіді могли загубитися
+            fc->optimistic++;
+            enter(fc, FLOOR_GRANTED, now_ms);
+        }
+        break;
+    case FLOOR_TAKEN:
+        if ((uint32_t)(now_ms - fc->activity_ms) >= FLOOR_IDLE_TIMEOUT_MS) {
+            fc->stuck_releases++;
+            enter(fc, FLOOR_IDLE, now_ms);
+        }
+        break;
+    default:
+        break;
+    }
+    try_request(fc, now_ms, peers);
+}
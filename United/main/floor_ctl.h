@@ -0,0 +1,75 @@
+#ifndef MAIN_FLOOR_CTL_H_
+#define MAIN_FLOOR_CTL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "packet.h"
+
+// Розподіл права голосу в напівдуплексі без центрального арбітра.
+// Натискання PTT розсилає REQUEST; кожен пристрій відповідає GRANT або DENY.
+// Слово надається, щойно відповіли всі відомі пристрої (один RTT), або
+// оптимістично через FLOOR_GRANT_TIMEOUT_MS, якщо ніхто не заперечив.
+// Одночасні запити: перемагає вищий пріоритет, при рівних - менший номер вузла.
+// Вищий пріоритет відбирає слово у поточного власника.
+// Власник, якого не чути FLOOR_IDLE_TIMEOUT_MS, втрачає слово.
+// Модуль не працює з мережею: вихідні повідомлення забираються floor_ctl_pop.
+
+#define FLOOR_GRANT_TIMEOUT_MS 150
+#define FLOOR_IDLE_TIMEOUT_MS 1000
+#define FLOOR_OUT_MAX 4
+#define FLOOR_GRANTERS_MAX 16       // Більше, ніж пристроїв у таблиці сусідів
+
+typedef enum {
+    FLOOR_IDLE,                 // Слово вільне
+    FLOOR_REQUESTING,           // Чекаємо відповідей на запит
+    FLOOR_GRANTED,              // Слово наше
+    FLOOR_TAKEN,                // Говорить інший пристрій
+} floor_state_t;
+
+typedef struct {
+    uint16_t self;
+    uint8_t priority;
+
+    floor_state_t state;
+    bool want;                  // PTT натиснуто
+    uint16_t holder;
+    uint8_t holder_priority;
+    uint32_t state_ms;          // Час входу в поточний стан
+    uint32_t activity_ms;       // Остання активність власника слова
+    int grants_needed;
+    int grants;                 // Кількість різних пристроїв, що дали згоду
+    uint16_t granters[FLOOR_GRANTERS_MAX];
+
+    pkt_floor_t out[FLOOR_OUT_MAX];
+    int out_count;
+
+    // Лічильники
+    uint32_t collisions;        // Програні одночасні запити
+    uint32_t preemptions;       // Слово відібрано вищим пріоритетом
+    uint32_t optimistic;        // Надано без відповідей усіх пристроїв
+    uint32_t stuck_releases;    // Звільнено через мовчання власника
+} floor_ctl_t;
+
+void floor_ctl_init(floor_ctl_t *fc, uint16_t self, uint8_t priority);
+
+// PTT натиснуто / відпущено. peers - кількість відомих пристроїв, від яких чекаємо згоди
+void floor_ctl_press(floor_ctl_t *fc, uint32_t now_ms, int peers);
+void floor_ctl_release(floor_ctl_t *fc, uint32_t now_ms);
+
+void floor_ctl_on_msg(floor_ctl_t *fc, uint16_t from, const pkt_floor_t *msg, uint32_t now_ms, int peers);
+// Аудіо від пристрою - ознака того, що він говорить
+void floor_ctl_on_audio(floor_ctl_t *fc, uint16_t from, uint32_t now_ms);
+
+// Тайм-аути, викликається періодично
+void floor_ctl_tick(floor_ctl_t *fc, uint32_t now_ms, int peers);
+
+// Наступне повідомлення для відправки всім пристроям. false, якщо черга порожня
+bool floor_ctl_pop(floor_ctl_t *fc, pkt_floor_t *msg);
+
+static inline bool floor_ctl_can_talk(const floor_ctl_t *fc)
+{
+    return fc->state == FLOOR_GRANTED;
+}
+
+#endif /* MAIN_FLOOR_CTL_H_ */
@@ -0,0 +1,57 @@
+#include <string.h>
+
+#include "forwarder.h"
+#include "packet.h"
+
+void forwarder_init(forwarder_t *fw, uint8_t max_hops)
+{
+    memset(fw, 0, sizeof(*fw));
+    fw->max_hops = max_hops;
+}
+
+// Мультиплікативний хеш (Кнут): старші біти добутку - індекс комірки
+static unsigned cache_index(uint8_t type, uint16_t node, uint16_t seq)
+{
+    uint32_t key = ((uint32_t)node << 16 | seq) ^ ((uint32_t)type << 27);
+    uint32_t h = key * 2654435761u;
+    return h >> (32 - FORWARDER_CACHE_BITS);
+}
+
+bool forwarder_accept(forwarder_t *fw, uint8_t *packet, size_t len, uint32_t now_ms)
+{
+    pkt_header_t hdr;
+
+    pkt_compact_t compact;
+
+    if (pkt_read_compact(packet, len, &compact)) {
+        // Стиснутий аудіо заголовок: номер пакета лише молодшим байтом,
+        // тож ключ доповнюємо молодшим байтом мітки часу
+        hdr.type = PKT_TYPE_AUDIO | 0x80;
+        hdr.node = compact.node;
+        hdr.seq = (uint16_t)(compact.seq_lo | (compact.ts_lo << 8));
+        hdr.hops = compact.hops;
+    } else if (!pkt_read_header(packet, len, &hdr)) {
+        fw->malformed++;
+        return false;
+    }
+    if (hdr.hops >= fw->max_hops) {
+        fw->hop_limited++;
+        return false;
+    }
+
+    forwarder_entry_t *e = &fw->cache[cache_index(hdr.type, hdr.node, hdr.seq)];
+    if (e->used && e->type == hdr.type && e->node == hdr.node && e->seq == hdr.seq &&
+        (uint32_t)(now_ms - e->seen_ms) <= FORWARDER_WINDOW_MS) {
+        fw->duplicates++;
+        return false;
+    }
+    e->used = true;
+    e->type = hdr.type;
+    e->node = hdr.node;
+    e->seq = hdr.seq;
+    e->seen_ms = now_ms;
+
+    packet[PKT_HOPS_OFFSET] = hdr.hops + 1;
+    fw->forwarded++;
+    return true;
+}
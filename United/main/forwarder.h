@@ -0,0 +1,46 @@
+#ifndef MAIN_FORWARDER_H_
+#define MAIN_FORWARDER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Рішення ретранслятора: пересилати пакет далі чи ні. Чиста логіка без мережі.
+//
+// Петлі між кількома ретрансляторами розриває кеш нещодавно пересланих пакетів
+// (вузол, тип, номер), а лічильник переходів у заголовку обмежує, як далеко
+// пакет може піти. Кеш прямого відображення: одна комірка на хеш ключа, без
+// пошуку. Колізія лише витісняє старий запис - у гіршому разі дублікат
+// пересилається ще раз і зупиняється на ліміті переходів.
+
+#define FORWARDER_CACHE_BITS 6
+#define FORWARDER_CACHE_SIZE (1 << FORWARDER_CACHE_BITS)
+#define FORWARDER_WINDOW_MS 2000    // Скільки пам'ятаємо пересланий пакет
+#define FORWARDER_MAX_HOPS 3
+
+typedef struct {
+    bool used;
+    uint8_t type;
+    uint16_t node;
+    uint16_t seq;
+    uint32_t seen_ms;
+} forwarder_entry_t;
+
+typedef struct {
+    forwarder_entry_t cache[FORWARDER_CACHE_SIZE];
+    uint8_t max_hops;
+
+    // Лічильники
+    uint32_t forwarded;
+    uint32_t duplicates;
+    uint32_t hop_limited;
+    uint32_t malformed;
+} forwarder_t;
+
+void forwarder_init(forwarder_t *fw, uint8_t max_hops);
+
+// Перевірка прийнятого пакета. Якщо його треба переслати, збільшує лічильник
+// переходів прямо в packet і повертає true
+bool forwarder_accept(forwarder_t *fw, uint8_t *packet, size_t len, uint32_t now_ms);
+
+#endif /* MAIN_FORWARDER_H_ */
@@ -0,0 +1,77 @@
+#include <string.h>
+
+#include "hdr_comp.h"
+
+void hdr_comp_tx_init(hdr_comp_tx_t *tx)
+{
+    memset(tx, 0, sizeof(*tx));
+}
+
+size_t hdr_comp_write(hdr_comp_tx_t *tx, uint8_t *buf, const pkt_header_t *h, const pkt_audio_desc_t *d)
+{
+    // Після паузи контекст приймача міг застаріти - оновлюємо його з запасом.
+    // Понад PKT_COMPACT_MAX_FRAMES кадрів не вміщується в поле DESC
+    bool full = !tx->valid ||
+                tx->since_refresh + 1 >= HDR_COMP_REFRESH_PACKETS ||
+                (uint32_t)(h->timestamp - tx->timestamp) > HDR_COMP_CONTEXT_TIMEOUT_MS / 2 ||
+                d->frames > PKT_COMPACT_MAX_FRAMES;
+
+    tx->valid = true;
+    tx->seq = h->seq;
+    tx->timestamp = h->timestamp;
+
+    if (full) {
+        tx->since_refresh = 0;
+        tx->full_sent++;
+        size_t len = pkt_write_header(buf, h);
+        return len + pkt_write_audio_desc(buf + len, d);
+    }
+
+    pkt_compact_t c = {
+        .desc = *d,
+        .group = h->group,
+        .hops = h->hops,
+        .node = h->node,
+        .seq_lo = (uint8_t)h->seq,
+        .ts_lo = (uint16_t)h->timestamp
+    };
+    tx->since_refresh++;
+    tx->compact_sent++;
+    return pkt_write_compact(buf, &c);
+}
+
+void hdr_comp_rx_init(hdr_comp_rx_t *rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+void hdr_comp_rx_update(hdr_comp_rx_t *rx, const pkt_header_t *h, uint32_t now_ms)
+{
+    bool stale = rx->valid && (uint32_t)(now_ms - rx->updated_ms) > HDR_COMP_CONTEXT_TIMEOUT_MS;
+
+    if (!rx->valid || stale || (int16_t)(h->seq - rx->seq) > 0) {
+        rx->seq = h->seq;
+        rx->timestamp = h->timestamp;
+    }
+    rx->valid = true;
+    rx->updated_ms = now_ms;
+}
+
+bool hdr_comp_rx_expand(hdr_comp_rx_t *rx, const pkt_compact_t *c, uint32_t now_ms,
+                        pkt_header_t *h, pkt_audio_desc_t *d)
+{
+    if (!rx->valid || (uint32_t)(now_ms - rx->updated_ms) > HDR_COMP_CONTEXT_TIMEOUT_MS) {
+        rx->no_context++;
+        return false;
+    }
+
+    // Найближче до попереднього значення з такими молодшими байтами
+    h->type = PKT_TYPE_AUDIO;
+    h->group = c->group;
+    h->hops = c->hops;
+    h->node = c->node;
+    h->seq = (uint16_t)(rx->seq + (int8_t)(uint8_t)(c->seq_lo - (uint8_t)rx->seq));
+    h->timestamp = rx->timestamp + (int16_t)(uint16_t)(c->ts_lo - (uint16_t)rx->timestamp);
+    *d = c->desc;
+    return true;
+}
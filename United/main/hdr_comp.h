@@ -0,0 +1,65 @@
+#ifndef MAIN_HDR_COMP_H_
+#define MAIN_HDR_COMP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "packet.h"
+
+// Стиснення заголовків аудіо потоку: 9 байт замість 12 + 2.
+//
+// Номер пакета і мітка часу йдуть молодшими байтами, приймач відновлює їх
+// відносно попереднього прийнятого пакета цього відправника: номер - у вікні
+// +-128 пакетів, час - +-32 с. Кожен пакет декодується незалежно, тож втрати
+// контексту не ламають. Кожен HDR_COMP_REFRESH_PACKETS-й пакет і перший після
+// паузи йдуть з повним заголовком, щоб приймач, який щойно приєднався або
+// довго не чув потоку, відновив контекст.
+
+#define HDR_COMP_REFRESH_PACKETS 16
+#define HDR_COMP_CONTEXT_TIMEOUT_MS 1000 // Контекст приймача старіший за це вже не довіряється
+
+typedef struct {
+    bool valid;
+    uint16_t seq;
+    uint32_t timestamp;
+    uint8_t since_refresh;
+
+    // Лічильники
+    uint32_t full_sent;
+    uint32_t compact_sent;
+} hdr_comp_tx_t;
+
+typedef struct {
+    bool valid;
+    uint16_t seq;
+    uint32_t timestamp;
+    uint32_t updated_ms;
+
+    uint32_t no_context;        // Стиснуті пакети, які нема з чим зіставити
+} hdr_comp_rx_t;
+
+void hdr_comp_tx_init(hdr_comp_tx_t *tx);
+
+// Наступний пакет піде з повним заголовком (новий адресат тощо)
+static inline void hdr_comp_tx_refresh(hdr_comp_tx_t *tx)
+{
+    tx->valid = false;
+}
+
+// Запис заголовка аудіо пакета з описом: повного або стиснутого.
+// h->type має бути PKT_TYPE_AUDIO. Повертає кількість записаних байтів
+size_t hdr_comp_write(hdr_comp_tx_t *tx, uint8_t *buf, const pkt_header_t *h, const pkt_audio_desc_t *d);
+
+void hdr_comp_rx_init(hdr_comp_rx_t *rx);
+
+// Заголовок автентифікованого аудіо пакета (повний або відновлений) - оновлення контексту.
+// Запізнілий пакет контекст назад не відкочує
+void hdr_comp_rx_update(hdr_comp_rx_t *rx, const pkt_header_t *h, uint32_t now_ms);
+
+// Відновлення повного заголовка і опису зі стиснутого, контекст не змінюється
+// (пакет ще не автентифіковано). Повертає false, якщо контексту немає або він застарів
+bool hdr_comp_rx_expand(hdr_comp_rx_t *rx, const pkt_compact_t *c, uint32_t now_ms,
+                        pkt_header_t *h, pkt_audio_desc_t *d);
+
+#endif /* MAIN_HDR_COMP_H_ */
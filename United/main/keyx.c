@@ -0,0 +1,108 @@
+#include <string.h>
+
+#include "keyx.h"
+
+void keyx_tx_init(keyx_tx_t *tx)
+{
+    memset(tx, 0, sizeof(*tx));
+}
+
+bool keyx_tx_rekey_due(const keyx_tx_t *tx, uint32_t now_ms)
+{
+    if (tx->next.valid) {
+        return false;
+    }
+    return !tx->cur.valid || (uint32_t)(now_ms - tx->cur_since_ms) >= KEYX_REKEY_PERIOD_MS;
+}
+
+void keyx_tx_prepare(keyx_tx_t *tx, const uint8_t key[KEYX_KEY_SIZE], const uint8_t mac_key[KEYX_KEY_SIZE])
+{
+    tx->next.valid = true;
+    tx->next.id = tx->cur.valid ? (uint8_t)(tx->cur.id + 1) : 0;
+    memcpy(tx->next.key, key, KEYX_KEY_SIZE);
+    memcpy(tx->next.mac_key, mac_key, KEYX_KEY_SIZE);
+    tx->switch_ready = false;
+}
+
+void keyx_tx_update(keyx_tx_t *tx, bool capable, bool has_cur, bool has_next)
+{
+    tx->active = capable && tx->cur.valid && has_cur;
+    tx->switch_ready = capable && tx->next.valid && has_next;
+}
+
+const keyx_key_t *keyx_tx_packet_key(keyx_tx_t *tx, uint16_t seq, uint32_t now_ms)
+{
+    if (tx->switch_ready) {
+        tx->cur = tx->next;
+        memset(&tx->next, 0, sizeof(tx->next));
+        tx->switch_ready = false;
+        tx->active = true;
+        tx->cur_since_ms = now_ms;
+        tx->switch_seq = seq;
+        tx->rekeys++;
+    }
+    return tx->active ? &tx->cur : NULL;
+}
+
+void keyx_peer_init(keyx_peer_t *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+bool keyx_peer_set_pub(keyx_peer_t *p, const uint8_t pub[X25519_KEY_SIZE])
+{
+    if (p->pub_valid && memcmp(p->pub, pub, X25519_KEY_SIZE) == 0) {
+        return false;
+    }
+    keyx_peer_init(p);
+    p->pub_valid = true;
+    memcpy(p->pub, pub, X25519_KEY_SIZE);
+    return true;
+}
+
+void keyx_peer_install(keyx_peer_t *p, uint8_t id, const uint8_t key[KEYX_KEY_SIZE],
+                       const uint8_t mac_key[KEYX_KEY_SIZE])
+{
+    if ((p->cur.valid && p->cur.id == id) || (p->next.valid && p->next.id == id)) {
+        return; // Повтор, ACK загубився
+    }
+    // Наступний ключ роздається лише після переходу на попередній
+    if (p->next.valid) {
+        p->cur = p->next;
+        p->switches++;
+    }
+    p->next.valid = true;
+    p->next.id = id;
+    memcpy(p->next.key, key, KEYX_KEY_SIZE);
+    memcpy(p->next.mac_key, mac_key, KEYX_KEY_SIZE);
+}
+
+const keyx_key_t *keyx_peer_lookup(keyx_peer_t *p, uint8_t code)
+{
+    uint8_t phase = code == PKT_AUDIO_KEY_PHASE1;
+
+    if (code != PKT_AUDIO_KEY_PHASE0 && code != PKT_AUDIO_KEY_PHASE1) {
+        p->unknown_key++;
+        return NULL;
+    }
+    if (p->cur.valid && (p->cur.id & 1) == phase) {
+        return &p->cur;
+    }
+    if (p->next.valid && (p->next.id & 1) == phase) {
+        return &p->next;
+    }
+    p->unknown_key++;
+    return NULL;
+}
+
+const keyx_key_t *keyx_peer_confirm(keyx_peer_t *p, const keyx_key_t *k, uint16_t seq)
+{
+    if (k != &p->next) {
+        return k;
+    }
+    p->cur = p->next;
+    memset(&p->next, 0, sizeof(p->next));
+    p->switch_seq = seq;
+    p->switches++;
+    return &p->cur;
+}
@@ -0,0 +1,123 @@
+#ifndef MAIN_KEYX_H_
+#define MAIN_KEYX_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "packet.h"
+#include "x25519.h"
+
+// Сеансові ключі замість спільного вбудованого ключа.
+//
+// Кожна пара пристроїв після виявлення обмінюється відкритими ключами X25519
+// (HELLO) і виводить парний ключ. Аудіо йде одне на всіх (широкомовно), тому
+// шифрується не парним ключем, а власним ключем відправника: відправник
+// розсилає його кожному, загорнутим у парний ключ (SENDER), і отримує ACK.
+//
+// Ключ відправника змінюється раз на KEYX_REKEY_PERIOD_MS. Новий ключ спершу
+// роздається, а вмикається лише тоді, коли всі його підтвердили - з початку
+// наступного пакета. У пакеті йде фаза ключа (молодший біт номера), тож
+// приймач перемикається на новий ключ рівно з першого пакета під ним, без
+// домовленостей про номер і без пропущених кадрів. Поки хтось ще не має
+// ключа відправника або не вміє обмінюватись ключами, аудіо шифрується
+// груповим ключем.
+//
+// Множення X25519 робить фонова задача; тут - лише стан і рішення, без мережі
+// і без шифрування.
+
+#define KEYX_KEY_SIZE 16
+#define KEYX_REKEY_PERIOD_MS 60000  // Не більше 6 хвилин: номери пакетів не встигають обернутись
+#define KEYX_RETRY_MS 250           // Повтор HELLO і SENDER, на які немає відповіді
+
+typedef struct {
+    bool valid;
+    uint8_t id;
+    uint8_t key[KEYX_KEY_SIZE];
+    uint8_t mac_key[KEYX_KEY_SIZE];     // Похідний ключ автентифікації пакетів
+} keyx_key_t;
+
+// Власний ключ відправника
+typedef struct {
+    keyx_key_t cur;             // Ключ, яким шифруємо, якщо active
+    keyx_key_t next;            // Роздається, чекає підтверджень
+    bool active;                // cur мають усі пристрої
+    bool switch_ready;          // next мають усі: перехід з наступного пакета
+    uint32_t cur_since_ms;
+    uint16_t switch_seq;        // Номер першого пакета під cur
+
+    // Лічильники
+    uint32_t rekeys;
+} keyx_tx_t;
+
+// Обмін з одним пристроєм і його ключі відправника
+typedef struct {
+    bool pub_valid;
+    uint8_t pub[X25519_KEY_SIZE];
+    bool pair_valid;
+    uint8_t pair_key[KEYX_KEY_SIZE];  // Загортає ключі відправника
+    uint8_t acked_mask;         // Фази, для яких є підтвердження
+    uint8_t acked[2];           // Останні підтверджені ним наші ключі, за фазою
+    uint32_t sent_ms;           // Останнє HELLO або SENDER йому
+
+    keyx_key_t cur;
+    keyx_key_t next;
+    uint16_t switch_seq;        // Номер першого пакета, прийнятого під cur
+
+    // Лічильники
+    uint32_t switches;
+    uint32_t unknown_key;       // Аудіо з фазою, для якої ключа немає
+} keyx_peer_t;
+
+// Код ключа для опису аудіо пакета
+static inline uint8_t keyx_key_code(const keyx_key_t *k)
+{
+    return (k->id & 1) ? PKT_AUDIO_KEY_PHASE1 : PKT_AUDIO_KEY_PHASE0;
+}
+
+void keyx_tx_init(keyx_tx_t *tx);
+
+// Час для нового ключа відправника: першого ще немає або поточний відслужив
+bool keyx_tx_rekey_due(const keyx_tx_t *tx, uint32_t now_ms);
+
+// Новий ключ (випадкові байти) і похідний від нього ключ автентифікації стають next з наступним номером
+void keyx_tx_prepare(keyx_tx_t *tx, const uint8_t key[KEYX_KEY_SIZE], const uint8_t mac_key[KEYX_KEY_SIZE]);
+
+// Підсумок по всіх пристроях: capable - усі вміють обмін ключами,
+// has_cur і has_next - усі підтвердили відповідний ключ
+void keyx_tx_update(keyx_tx_t *tx, bool capable, bool has_cur, bool has_next);
+
+// Ключ для пакета seq. Перемикання на next відбувається тут, між пакетами.
+// NULL - шифрувати груповим ключем
+const keyx_key_t *keyx_tx_packet_key(keyx_tx_t *tx, uint16_t seq, uint32_t now_ms);
+
+void keyx_peer_init(keyx_peer_t *p);
+
+// Відкритий ключ з HELLO. Повертає true, якщо він новий або змінився
+// (пристрій перезавантажився): стан обміну скинуто, потрібен парний ключ
+bool keyx_peer_set_pub(keyx_peer_t *p, const uint8_t pub[X25519_KEY_SIZE]);
+
+// Пристрій підтвердив наш ключ id
+static inline void keyx_peer_ack(keyx_peer_t *p, uint8_t id)
+{
+    p->acked[id & 1] = id;
+    p->acked_mask |= 1 << (id & 1);
+}
+
+static inline bool keyx_peer_has(const keyx_peer_t *p, const keyx_key_t *k)
+{
+    return k->valid && ((p->acked_mask >> (k->id & 1)) & 1) && p->acked[k->id & 1] == k->id;
+}
+
+// Розгорнутий і перевірений ключ відправника з SENDER
+void keyx_peer_install(keyx_peer_t *p, uint8_t id, const uint8_t key[KEYX_KEY_SIZE],
+                       const uint8_t mac_key[KEYX_KEY_SIZE]);
+
+// Ключ для аудіо пакета з кодом code (PKT_AUDIO_KEY_PHASE*): cur або next
+// відповідної фази. Стан не змінюється, пакет ще не автентифіковано. NULL - такого ключа немає
+const keyx_key_t *keyx_peer_lookup(keyx_peer_t *p, uint8_t code);
+
+// Пакет seq автентифіковано ключем k. Перший такий пакет під next переводить приймач на нього.
+// Повертає, де тепер лежить k
+const keyx_key_t *keyx_peer_confirm(keyx_peer_t *p, const keyx_key_t *k, uint16_t seq);
+
+#endif /* MAIN_KEYX_H_ */
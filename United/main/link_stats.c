@@ -0,0 +1,147 @@
+#include <string.h>
+
+#include "link_stats.h"
+
+void link_stats_init(link_stats_t *ls)
+{
+    memset(ls, 0, sizeof(*ls));
+}
+
+static void reset_sequence(link_stats_t *ls, uint16_t seq)
+{
+    ls->seq_init = true;
+    ls->max_seq = seq;
+    ls->cycles = 0;
+    ls->base_seq = seq;
+    ls->received = 0;
+    ls->expected_prior = 0;
+    ls->received_prior = 0;
+    ls->transit_init = false;
+    ls->jitter_q4 = 0;
+}
+
+static uint32_t ext_max_seq(const link_stats_t *ls)
+{
+    return ls->cycles + ls->max_seq;
+}
+
+static uint32_t cumulative_lost(const link_stats_t *ls)
+{
+    uint32_t expected = ext_max_seq(ls) - ls->base_seq + 1;
+    // Дублікати можуть дати від'ємні втрати
+    return expected > ls->received ? expected - ls->received : 0;
+}
+
+void link_stats_on_packet(link_stats_t *ls, const pkt_header_t *h, uint32_t arrival_ms)
+{
+    ls->peer_ts_valid = true;
+    ls->peer_ts = h->timestamp;
+    ls->peer_ts_arrival_ms = arrival_ms;
+}
+
+void link_stats_on_audio(link_stats_t *ls, const pkt_header_t *h, uint32_t arrival_ms)
+{
+    if (!ls->seq_init) {
+        reset_sequence(ls, h->seq);
+    } else {
+        uint16_t delta = (uint16_t)(h->seq - ls->max_seq);
+        if (delta != 0 && delta < LINK_MAX_DROPOUT) {
+            // Пакет у порядку, можливо з пропусками
+            if (h->seq < ls->max_seq) {
+                ls->cycles += 1u << 16;
+            }
+            ls->max_seq = h->seq;
+        } else if (delta >= LINK_MAX_DROPOUT && delta <= 0xFFFF - LINK_MAX_DROPOUT) {
+            // Великий стрибок - співрозмовник перезапустився
+            reset_sequence(ls, h->seq);
+        }
+        // Інакше дублікат або пакет не по порядку - лише рахуємо
+    }
+    ls->received++;
+
+    // Джиттер за RFC 3550: J += (|D| - J) / 16
+    int32_t transit = (int32_t)(arrival_ms - h->timestamp);
+    if (ls->transit_init) {
+        int32_t d = transit - ls->transit;
+        if (d < 0) {
+            d = -d;
+        }
+        ls->jitter_q4 += (uint32_t)d - ((ls->jitter_q4 + 8) >> 4);
+    }
+    ls->transit = transit;
+    ls->transit_init = true;
+}
+
+void link_stats_on_report(link_stats_t *ls, const pkt_report_t *r, uint32_t now_ms)
+{
+    ls->remote = *r;
+    ls->remote_valid = true;
+    ls->last_report_ms = now_ms;
+    ls->reports_received++;
+
+    if (r->flags & PKT_REPORT_ECHO_VALID) {
+        int32_t rtt = (int32_t)(now_ms - r->echo_ts - r->echo_delay_ms);
+        if (rtt < 0) {
+            rtt = 0;
+        }
+        if (!ls->rtt_valid) {
+            ls->rtt_ms = (uint32_t)rtt;
+            ls->rtt_valid = true;
+        } else {
+            // Згладжування як у TCP SRTT, коефіцієнт 1/8
+            ls->rtt_ms = (ls->rtt_ms * 7 + (uint32_t)rtt + 4) / 8;
+        }
+    }
+}
+
+void link_stats_build_report(link_stats_t *ls, uint32_t now_ms, pkt_report_t *r)
+{
+    memset(r, 0, sizeof(*r));
+
+    if (ls->seq_init) {
+        uint32_t expected = ext_max_seq(ls) - ls->base_seq + 1;
+        uint32_t expected_interval = expected - ls->expected_prior;
+        uint32_t received_interval = ls->received - ls->received_prior;
+        ls->expected_prior = expected;
+        ls->received_prior = ls->received;
+
+        if (expected_interval > received_interval) {
+            ls->fraction_lost = (uint8_t)(((expected_interval - received_interval) << 8) / expected_interval);
+        } else {
+            ls->fraction_lost = 0;
+        }
+
+        r->fraction_lost = ls->fraction_lost;
+        r->received = ls->received;
+        r->cumulative_lost = cumulative_lost(ls);
+        r->ext_max_seq = ext_max_seq(ls);
+        r->jitter_q4 = ls->jitter_q4;
+    }
+
+    if (ls->peer_ts_valid) {
+        r->flags |= PKT_REPORT_ECHO_VALID;
+        r->echo_ts = ls->peer_ts;
+        r->echo_delay_ms = now_ms - ls->peer_ts_arrival_ms;
+    }
+}
+
+void link_stats_summary(const link_stats_t *ls, link_summary_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->valid = ls->seq_init || ls->remote_valid;
+
+    if (ls->seq_init) {
+        out->rx_received = ls->received;
+        out->rx_lost = cumulative_lost(ls);
+        out->rx_fraction_lost = ls->fraction_lost;
+        out->rx_jitter_ms = ls->jitter_q4 >> 4;
+    }
+    if (ls->remote_valid) {
+        out->remote_valid = true;
+        out->tx_lost = ls->remote.cumulative_lost;
+        out->tx_fraction_lost = ls->remote.fraction_lost;
+        out->tx_jitter_ms = ls->remote.jitter_q4 >> 4;
+    }
+    out->rtt_valid = ls->rtt_valid;
+    out->rtt_ms = ls->rtt_ms;
+}
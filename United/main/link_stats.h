@@ -0,0 +1,72 @@
+#ifndef MAIN_LINK_STATS_H_
+#define MAIN_LINK_STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "packet.h"
+
+// Статистика каналу з одним співрозмовником: втрати та джиттер вхідного
+// аудіо потоку (за RFC 3550), RTT за відлунням мітки часу зі звітів.
+// Без динамічної пам'яті, всі оновлення O(1).
+
+#define LINK_MAX_DROPOUT 3000   // Стрибок номера, після якого потік вважається перезапущеним
+
+typedef struct {
+    // Вхідний аудіо потік
+    bool seq_init;
+    uint16_t max_seq;
+    uint32_t cycles;            // Переповнення 16-бітного номера, << 16
+    uint32_t base_seq;
+    uint32_t received;
+    uint32_t expected_prior;
+    uint32_t received_prior;
+    uint8_t fraction_lost;
+    bool transit_init;
+    int32_t transit;
+    uint32_t jitter_q4;
+
+    // Остання мітка часу від співрозмовника, яку відлунюємо у звіті
+    bool peer_ts_valid;
+    uint32_t peer_ts;
+    uint32_t peer_ts_arrival_ms;
+
+    // Погляд співрозмовника на наш потік (з його звіту)
+    bool remote_valid;
+    pkt_report_t remote;
+    bool rtt_valid;
+    uint32_t rtt_ms;            // Згладжений RTT
+    uint32_t last_report_ms;
+    uint32_t reports_received;
+} link_stats_t;
+
+// Зведення для дисплея та консолі
+typedef struct {
+    bool valid;
+    uint32_t rx_received;
+    uint32_t rx_lost;
+    uint8_t rx_fraction_lost;   // /256
+    uint32_t rx_jitter_ms;
+    bool remote_valid;
+    uint32_t tx_lost;           // Втрати нашого потоку зі звіту співрозмовника
+    uint8_t tx_fraction_lost;
+    uint32_t tx_jitter_ms;
+    bool rtt_valid;
+    uint32_t rtt_ms;
+} link_summary_t;
+
+void link_stats_init(link_stats_t *ls);
+
+// Будь-який пакет від співрозмовника: запам'ятовуємо мітку часу для відлуння
+void link_stats_on_packet(link_stats_t *ls, const pkt_header_t *h, uint32_t arrival_ms);
+// Аудіо пакет: номер для підрахунку втрат, мітка часу для джиттера
+void link_stats_on_audio(link_stats_t *ls, const pkt_header_t *h, uint32_t arrival_ms);
+// Звіт від співрозмовника: його погляд на наш потік і RTT
+void link_stats_on_report(link_stats_t *ls, const pkt_report_t *r, uint32_t now_ms);
+
+// Заповнення звіту для відправки співрозмовнику
+void link_stats_build_report(link_stats_t *ls, uint32_t now_ms, pkt_report_t *r);
+
+void link_stats_summary(const link_stats_t *ls, link_summary_t *out);
+
+#endif /* MAIN_LINK_STATS_H_ */
@@ -0,0 +1,53 @@
+#include <string.h>
+
+#include "mac_cache.h"
+
+static void mac_block(void *ctx, const uint8_t in[CMAC_BLOCK_SIZE], uint8_t out[CMAC_BLOCK_SIZE])
+{
+    mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, in, out);
+}
+
+void mac_cache_init(mac_cache_t *mc)
+{
+    memset(mc, 0, sizeof(*mc));
+    for (int i = 0; i < MAC_CACHE_SIZE; i++) {
+        mbedtls_aes_init(&mc->entries[i].aes);
+    }
+}
+
+void mac_cache_free(mac_cache_t *mc)
+{
+    for (int i = 0; i < MAC_CACHE_SIZE; i++) {
+        mbedtls_aes_free(&mc->entries[i].aes);
+    }
+    memset(mc, 0, sizeof(*mc));
+}
+
+cmac_t *mac_cache_get(mac_cache_t *mc, const uint8_t key[MAC_CACHE_KEY_SIZE])
+{
+    mac_cache_entry_t *victim = &mc->entries[0];
+
+    mc->clock++;
+    for (int i = 0; i < MAC_CACHE_SIZE; i++) {
+        mac_cache_entry_t *e = &mc->entries[i];
+        if (e->valid && memcmp(e->key, key, MAC_CACHE_KEY_SIZE) == 0) {
+            e->used = mc->clock;
+            mc->hits++;
+            cmac_start(&e->cmac);
+            return &e->cmac;
+        }
+        if (!e->valid) {
+            victim = e;
+        } else if (victim->valid && (int32_t)(e->used - victim->used) < 0) {
+            victim = e;
+        }
+    }
+
+    memcpy(victim->key, key, MAC_CACHE_KEY_SIZE);
+    victim->valid = true;
+    victim->used = mc->clock;
+    mbedtls_aes_setkey_enc(&victim->aes, key, MAC_CACHE_KEY_SIZE * 8);
+    cmac_init(&victim->cmac, mac_block, &victim->aes);
+    mc->key_loads++;
+    return &victim->cmac;
+}
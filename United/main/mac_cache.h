@@ -0,0 +1,42 @@
+#ifndef MAIN_MAC_CACHE_H_
+#define MAIN_MAC_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mbedtls/aes.h"
+#include "cmac.h"
+
+// Готові контексти CMAC для кількох ключів автентифікації. Розклад ключа AES
+// і підключі CMAC рахуються лише при появі нового ключа, а не на кожен пакет:
+// так підроблений пакет коштує один прохід CMAC, а не ще й розклад ключа.
+// Ключів одночасно небагато - груповий і ключі відправників, що говорять,
+// тож витісняється той, яким найдовше не користувались.
+
+#define MAC_CACHE_SIZE 4
+#define MAC_CACHE_KEY_SIZE 16
+
+typedef struct {
+    bool valid;
+    uint8_t key[MAC_CACHE_KEY_SIZE];
+    uint32_t used;              // Момент останнього звертання за лічильником кешу
+    mbedtls_aes_context aes;
+    cmac_t cmac;
+} mac_cache_entry_t;
+
+typedef struct {
+    mac_cache_entry_t entries[MAC_CACHE_SIZE];
+    uint32_t clock;
+
+    // Лічильники
+    uint32_t hits;
+    uint32_t key_loads;
+} mac_cache_t;
+
+void mac_cache_init(mac_cache_t *mc);
+void mac_cache_free(mac_cache_t *mc);
+
+// Контекст CMAC для ключа, готовий до cmac_update. Чинний до наступного виклику
+cmac_t *mac_cache_get(mac_cache_t *mc, const uint8_t key[MAC_CACHE_KEY_SIZE]);
+
+#endif /* MAIN_MAC_CACHE_H_ */
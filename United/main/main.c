@@ -4,6 +4,7 @@
 #include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
@@ -13,17 +14,56 @@
 #include "driver/i2s_std.h"
 #include "math.h"
 #include "mbedtls/aes.h"
+#include "mbedtls/sha256.h"
 #include "esp_err.h"
 #include "esp_system.h"
 #include "esp_vfs.h"
-#include "esp_spiffs.h"
 #include "st7789.h"
 #include "fontx.h"
+#include "net_engine.h"
+#include "packet.h"
+#include "link_stats.h"
+#include "rate_ctl.h"
+#include "peer_table.h"
+#include "floor_ctl.h"
+#include "discovery.h"
+#include "wifi_cache.h"
+#include "boot.h"
+#include "reconnect.h"
+#include "audio_backlog.h"
+#include "forwarder.h"
+#include "channel.h"
+#include "hdr_comp.h"
+#include "keyx.h"
+#include "x25519.h"
+#include "replay.h"
+#include "cmac.h"
+#include "mac_cache.h"
+#include "crypto_mode.h"
+#include "aes_batch.h"
+#include "chachapoly.h"
+#include "status_view.h"
+#include "esp_mac.h"
+#include "esp_random.h"
+#include "esp_timer.h"
 
 // Визначаємо пристрій сервер чи клієнт
 #define IS_SERVER
 //#define IS_CLIENT
 
+// Ретранслятор між двома пристроями поза досяжністю один одного: клієнт точки
+// доступу і водночас власна точка доступу з тим самим SSID в іншій підмережі.
+// Лише пересилає пакети між сегментами, сам не говорить і не відтворює звук
+//#define RELAY_NODE
+
+// Аудіо шифрується і автентифікується ChaCha20-Poly1305 замість AES-ECB і CMAC,
+// не займаючи апаратний блок AES. Має збігатися на всіх пристроях і точці доступу
+//#define AUDIO_CHACHA20_POLY1305
+
+#if defined(RELAY_NODE) && !defined(IS_CLIENT)
+#error "RELAY_NODE requires IS_CLIENT"
+#endif
+
 #define I2S_NUM_TX 0
 #define I2S_NUM_RX 1
 
@@ -41,11 +81,50 @@
 #define EXAMPLE_ESP_WIFI_SSID "esp32_ap"
 #define EXAMPLE_ESP_WIFI_PASS "password"
 #define PORT 1234
-#define CLIENT_IP_ADDR "192.168.4.2"
-#define SERVER_IP_ADDR "192.168.4.1"
+#define DISCOVERY_IP_ADDR "255.255.255.255" // Маяки присутності в режимі один-на-один
+
+// Режим розмовної групи: один широкомовний або multicast пакет на кадр для всіх приймачів
+//#define TALK_GROUP_BROADCAST
+//#define TALK_GROUP_MULTICAST
+#define TALK_GROUP_ID 1 // Канал за замовчуванням
+#define CHANNEL_SELECT_COUNT 4 // Довге натискання кнопки шифрування перемикає канали 1..4
+#define CHANNEL_SUBSCRIBE_MASK 0 // Канали, які слухаємо завжди, крім власного (біт на канал)
+#define PRIORITY_CHANNEL 9 // Екстрений канал: слухаємо завжди, перебиває інші; 0 - немає
+#define LONG_PRESS_MS 1000
+#define PIGGYBACK_MAX_BYTES 32 // Повідомлення керування словом у хвості аудіо пакета
+#define PIGGYBACK_MAX_DELAY_MS (AUDIO_FRAME_MS * 2) // Довше службове повідомлення аудіо не чекає
+#define BROADCAST_IP_ADDR "192.168.4.255"
+#define MULTICAST_IP_ADDR "239.0.77.1"
+#define RELAY_AP_SUBNET 5 // Підмережа 192.168.5.0/24 власної точки доступу ретранслятора
+
+#if defined(TALK_GROUP_BROADCAST) || defined(TALK_GROUP_MULTICAST)
+#define TALK_GROUP_MODE
+#define AP_MAX_STA_CONN 4
+#else
+#define AP_MAX_STA_CONN 1
+#endif
 
 #define UDP_BUFFER_SIZE 1024
 #define SAMPLE_RATE 44100 // Аудіо стандарт, частота дискретизації
+#define AUDIO_FRAME_MS ((UDP_BUFFER_SIZE / 2) * 1000 / SAMPLE_RATE) // Тривалість одного кадру, мс
+#define RX_SILENCE_TIMEOUT_MS 100
+#define PLAY_QUEUE_LEN 6 // Кадрів між мережевою задачею і динаміком (~70 мс)
+#define MIC_QUEUE_LEN 4  // Кадрів між мікрофоном і мережевою задачею (~45 мс)
+#define SILENCE_FRAMES 5 // Тиша, що виштовхує залишки звуку з буферів DMA динаміка
+#define TX_DEADLINE_MS (AUDIO_FRAME_MS * 4) // Максимальна затримка кадру в черзі на відправку
+#define NET_STATS_PERIOD_MS 10000
+#define LINK_REPORT_PERIOD_MS 1000 // Період обміну звітами про якість каналу
+#define LINK_DISPLAY_PERIOD_MS 5000
+#define DISPLAY_POLL_MS 50 // Перевірка станів; без змін екран не малюється
+#define FLOOR_TICK_MS 20
+#define DISCOVERY_TICK_MS 100
+#define FLOOR_PRIORITY 0 // Пріоритет права голосу, вищий відбирає слово в нижчого
+#define AUDIO_BACKLOG_MAX_AGE_MS 1500 // Старіше накопичене за перерву вже не відправляється
+#define AUDIO_BACKLOG_BURST_FRAMES 4  // Кадрів накопиченого в одному пакеті: наздоганяємо вчетверо швидше
+
+#if (UDP_BUFFER_SIZE >> AUDIO_BACKLOG_DECIM_SHIFT) != AUDIO_BACKLOG_FRAME_BYTES
+#error "AUDIO_BACKLOG_FRAME_BYTES does not match the audio frame size"
+#endif
 
 #define AES_KEY_SIZE 16
 
@@ -59,11 +138,148 @@ static i2s_chan_handle_t    tx_chan;
 
 static const char *TAG = "Walkie_Talkie"; 
 #ifdef IS_CLIENT
-static bool got_ip = false;
+static volatile bool got_ip = false;
+#endif
+#ifndef IS_SERVER
+static esp_netif_t *sta_netif;
+static reconnect_backoff_t wifi_backoff;   // Лише в задачі подій Wi-Fi
+static esp_timer_handle_t reconnect_timer;
+static bool wifi_cache_used = false;    // Підключення за збереженими в NVS параметрами
+static wifi_cache_t wifi_current;       // Параметри поточного підключення для збереження
 #endif
+volatile bool ptt_pressed = false;   // Стан кнопки, передача лише після отримання слова
 volatile bool transmit_data = false;
 volatile bool receiving_data = false;
-volatile bool encryption_enabled = true;
+volatile bool encryption_enabled = true;            // Вибір кнопкою, узгоджує мережева задача
+volatile uint8_t crypto_status = CRYPTO_STATUS_ON;  // Для дисплея: фактичний режим передачі
+volatile uint8_t tx_channel = TALK_GROUP_ID;        // Для дисплея, змінює мережева задача
+static volatile uint8_t requested_channel = 0;      // Вибір кнопкою, 0 - без змін
+
+static net_engine_t net;
+static struct sockaddr_in peer_addr;    // Співрозмовник у режимі один-на-один
+static bool peer_known = false;         // Співрозмовника виявлено маяком
+static uint16_t peer_node;
+static struct sockaddr_in tx_dest;      // Куди відправляється аудіо
+static uint16_t node_id;                // Ідентифікатор цього пристрою в заголовках
+static channel_set_t channels;          // Підписки і вибір каналу для відтворення
+static uint32_t last_receive_ms; // Час останнього отримання даних
+
+// Кадр з мікрофона з міткою часу захоплення
+typedef struct {
+    uint32_t capture_ms;
+    uint8_t pcm[UDP_BUFFER_SIZE];
+} mic_frame_t;
+
+// Буфери аудіо кадрів (статичні, щоб не займати стек мережевої задачі)
+static mic_frame_t mic_frame;
+static uint8_t send_buf[PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE + UDP_BUFFER_SIZE +
+                        PIGGYBACK_MAX_BYTES + PKT_TRAILER_ITEM_HDR + PKT_REPORT_SIZE + PKT_AUDIO_MAC_SIZE];
+static uint8_t play_buf[UDP_BUFFER_SIZE];
+static uint8_t rx_body[UDP_BUFFER_SIZE];
+
+// Кадри на відтворення: у I2S пише лише задача динаміка, мережева не блокується
+static QueueHandle_t play_queue;
+static uint32_t play_overruns = 0;      // Кадри, для яких не було місця в черзі динаміка
+
+// Захоплені кадри: з I2S читає лише задача мікрофона, мережева забирає їх без очікування
+static QueueHandle_t mic_queue;
+static volatile uint32_t mic_overruns = 0;  // Кадри, для яких не було місця в черзі мікрофона
+
+// Стан передавача для поточного рівня якості
+static rate_ctl_t rate_ctl;
+static const rate_level_t *tx_level = NULL;
+static uint8_t tx_body[UDP_BUFFER_SIZE];    // Кадри, що збираються в пакет
+static uint8_t tx_frames = 0;
+static uint32_t tx_first_capture_ms = 0;
+static uint8_t fec_body[UDP_BUFFER_SIZE];   // Кадри попереднього пакета для FEC
+static size_t fec_len = 0;
+
+// Сеансові ключі: множення X25519 рахує фонова задача, мережева лише
+// обмінюється з нею чергами. Таємний ключ і спільні секрети не залишають фонову задачу
+typedef struct {
+    bool own;                   // Результат: власний відкритий ключ готовий
+    bool ok;
+    uint16_t node;
+    uint8_t pub[X25519_KEY_SIZE];       // Відкритий ключ пристрою
+    uint8_t pair_key[KEYX_KEY_SIZE];    // Результат: парний ключ
+} keyx_job_t;
+
+static QueueHandle_t keyx_jobs;
+static QueueHandle_t keyx_results;
+static uint8_t keyx_secret[X25519_KEY_SIZE];
+static uint8_t keyx_pub[X25519_KEY_SIZE];   // Мережевій задачі - лише після результату own
+static bool keyx_pub_ready = false;
+static keyx_tx_t tx_keys;               // Власний ключ відправника
+static keyx_key_t group_key;            // Вбудований ключ і похідний ключ автентифікації
+static crypto_mode_t crypto;            // Узгоджений режим шифрування
+static aes_batch_t audio_enc;           // Ключ аудіо тримається між пакетами
+static aes_batch_t audio_dec;
+
+// Автентифікація аудіо пакетів, лише в мережевій задачі
+static mac_cache_t mac_keys;            // Підключі CMAC групового ключа і ключів відправників
+static replay_table_t replays;          // Запуски і вікна повторів відправників, переживають таблицю сусідів
+static uint32_t auth_failures = 0;
+static uint32_t replay_drops = 0;
+static uint32_t unknown_senders = 0;    // Пакети від відправників без автентифікованого маяка
+
+static uint16_t audio_seq = 0;
+static uint16_t control_seq = 0;
+static hdr_comp_tx_t tx_comp;           // Контекст стиснення заголовків аудіо потоку
+
+// Службові повідомлення, що чекають на найближчий аудіо пакет до того ж адресата.
+// Звіт формується лише в момент відправки, щоб очікування не спотворило RTT
+static uint8_t piggyback[PIGGYBACK_MAX_BYTES];
+static size_t piggyback_len = 0;
+static link_stats_t *piggyback_report = NULL;
+static uint32_t piggyback_since_ms;
+static uint32_t piggyback_packets = 0;  // Аудіо пакети, що віднесли службові повідомлення
+
+// Право голосу в напівдуплексі
+static floor_ctl_t floor_ctl;
+
+// Відомі пристрої та статистика каналу з кожним з них
+static peer_table_t peers;
+static discovery_t discovery;
+
+// Перерви зв'язку: аудіо, захоплене без каналу, і метрики відновлення
+static audio_backlog_t backlog;
+static reconnect_stats_t outage;
+static uint8_t backlog_body[AUDIO_BACKLOG_BURST_FRAMES * AUDIO_BACKLOG_FRAME_BYTES];
+
+#ifdef RELAY_NODE
+static forwarder_t forwarder;
+static volatile uint32_t relay_sta_bcast = 0;  // Широкомовна адреса сегмента над нами, 0 - ще без IP
+static uint32_t relay_ap_net;                  // Власна підмережа точки доступу
+static uint32_t relay_ap_mask;
+static uint32_t relay_send_drops = 0;
+#endif
+
+// Зведення для дисплея та консолі: оновлюється мережевою задачею
+static link_summary_t link_summary;
+static portMUX_TYPE link_summary_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#ifndef IS_SERVER
+static void wifi_reconnect_cb(void *arg)
+{
+    esp_wifi_connect();
+}
+
+// Збережена точка доступу недоступна - повне сканування
+static void wifi_fallback_to_scan(void)
+{
+    wifi_config_t wifi_config;
+
+    ESP_LOGW(TAG, "Cached AP unreachable, falling back to full scan");
+    wifi_cache_used = false;
+    wifi_cache_clear();
+
+    esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+    wifi_config.sta.bssid_set = false;
+    wifi_config.sta.channel = 0;
+    wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+}
+#endif
 
 // Обробник подій Wi-Fi
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
@@ -81,6 +297,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
     {
         ip_event_ap_staipassigned_t* event = (ip_event_ap_staipassigned_t*) event_data;
         ESP_LOGI(TAG, "Assigned IP to station: " IPSTR, IP2STR(&event->ip));
+        discovery_kick(&discovery); // Новий пристрій дізнається про нас одразу
 
         esp_netif_ip_info_t ip_info;
         esp_netif_t *ap_netif = esp_netif_get_handle_from_ifkey("WIFI_AP_DEF");
@@ -103,19 +320,51 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
 #else
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) 
     {
+        boot_mark("wifi started");
         esp_wifi_connect();
     } 
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) 
+    {
+        wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t*) event_data;
+        boot_mark("associated");
+        memcpy(wifi_current.bssid, event->bssid, sizeof(wifi_current.bssid));
+        wifi_current.channel = event->channel;
+    } 
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) 
     {
-        esp_wifi_connect();
-        ESP_LOGI(TAG, "retry to connect to the AP");
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
+        if (wifi_cache_used && !got_ip) {
+            wifi_fallback_to_scan();
+        }
         got_ip = false;
+#ifdef RELAY_NODE
+        relay_sta_bcast = 0;
+#endif
+
+        // Повтор не одразу, а із затримкою, що росте з кожною невдачею
+        uint32_t delay_ms = reconnect_backoff_next(&wifi_backoff, esp_random());
+        esp_timer_stop(reconnect_timer);
+        esp_timer_start_once(reconnect_timer, (uint64_t)delay_ms * 1000);
+        ESP_LOGI(TAG, "Disconnected (reason %d), retry %" PRIu32 " in %" PRIu32 " ms",
+                 event->reason, wifi_backoff.attempt, delay_ms);
     } 
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) 
     {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
         got_ip = true;
+        reconnect_backoff_reset(&wifi_backoff);
+#ifdef RELAY_NODE
+        relay_sta_bcast = event->ip_info.ip.addr | ~event->ip_info.netmask.addr;
+#endif
+        boot_signal(BOOT_NETIF_UP, "got ip");
+        discovery_kick(&discovery);
+
+        // Точка доступу, що видала адресу, - для наступного швидкого старту.
+        // Саму оренду (зокрема нову після NAK) запам'ятовує DHCP клієнт
+        if (wifi_cache_save(&wifi_current) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to cache AP parameters");
+        }
     }
 #endif
 }
@@ -147,7 +396,7 @@ void wifi_init(void)
             .ssid = EXAMPLE_ESP_WIFI_SSID,
             .ssid_len = strlen(EXAMPLE_ESP_WIFI_SSID),
             .password = EXAMPLE_ESP_WIFI_PASS,
-            .max_connection = 1,
+            .max_connection = AP_MAX_STA_CONN,
             .authmode = WIFI_AUTH_WPA_WPA2_PSK      // Режим автентифікації
         },
     };
@@ -181,13 +430,22 @@ void wifi_init(void)
     ESP_ERROR_CHECK(esp_netif_dhcps_start(ap_netif));
 
     ESP_LOGI(TAG, "wifi_init_softap finished. SSID:%s password:%s", EXAMPLE_ESP_WIFI_SSID, EXAMPLE_ESP_WIFI_PASS);
+    boot_signal(BOOT_NETIF_UP, "AP up");
 #else
     // Створення нового мережевого інтерфейсу STA (клієнт)
-    esp_netif_t *sta_netif = esp_netif_create_default_wifi_sta();
+    sta_netif = esp_netif_create_default_wifi_sta();
 
     // Реєстрація обробника подій IP для STA
     ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL, &instance_got_ip));
 
+    // Таймер повторного підключення після втрати точки доступу
+    const esp_timer_create_args_t reconnect_args = {
+        .callback = wifi_reconnect_cb,
+        .name = "wifi_reconnect"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&reconnect_args, &reconnect_timer));
+    reconnect_backoff_init(&wifi_backoff, RECONNECT_BASE_MS, RECONNECT_MAX_MS);
+
     wifi_config_t wifi_config = 
     {
         .sta = 
@@ -197,8 +455,49 @@ void wifi_init(void)
         },
     };
 
+    // Відома точка доступу: підключення без сканування всіх каналів
+    wifi_cache_t cache;
+    if (wifi_cache_load(&cache) == ESP_OK) {
+        wifi_cache_used = true;
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, cache.bssid, sizeof(cache.bssid));
+        wifi_config.sta.channel = cache.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        ESP_LOGI(TAG, "Fast connect to " MACSTR " on channel %d",
+                 MAC2STR(cache.bssid), cache.channel);
+    }
+
+#ifdef RELAY_NODE
+    // Клієнт точки доступу і власна точка доступу для сегмента за межами її досяжності
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
+    esp_netif_t *ap_netif = esp_netif_create_default_wifi_ap();
+
+    wifi_config_t ap_config = 
+    {
+        .ap = 
+        {
+            .ssid = EXAMPLE_ESP_WIFI_SSID,
+            .ssid_len = strlen(EXAMPLE_ESP_WIFI_SSID),
+            .password = EXAMPLE_ESP_WIFI_PASS,
+            .max_connection = AP_MAX_STA_CONN,
+            .authmode = WIFI_AUTH_WPA_WPA2_PSK
+        },
+    };
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &ap_config));
+
+    esp_netif_ip_info_t ap_ip_info;
+    IP4_ADDR(&ap_ip_info.ip, 192, 168, RELAY_AP_SUBNET, 1);
+    IP4_ADDR(&ap_ip_info.gw, 192, 168, RELAY_AP_SUBNET, 1);
+    IP4_ADDR(&ap_ip_info.netmask, 255, 255, 255, 0);
+    ESP_ERROR_CHECK(esp_netif_dhcps_stop(ap_netif));
+    ESP_ERROR_CHECK(esp_netif_set_ip_info(ap_netif, &ap_ip_info));
+    ESP_ERROR_CHECK(esp_netif_dhcps_start(ap_netif));
+    relay_ap_mask = ap_ip_info.netmask.addr;
+    relay_ap_net = ap_ip_info.ip.addr & relay_ap_mask;
+#else
     // Встановлення режиму WiFi як STA (клієнт)    
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+#endif
 
     // Встановлення конфігурації WiFi
     ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
@@ -206,7 +505,9 @@ void wifi_init(void)
     // Запуск інтерфейсу WiFi
     ESP_ERROR_CHECK(esp_wifi_start());
 
-    // Запуск DHCP клієнта
+    // Запуск DHCP клієнта. Після перезапуску він просить попередню адресу
+    // (INIT-REBOOT) і отримує її за один обмін; якщо сервер відмовить,
+    // клієнт сам переходить до повного DISCOVER
     ESP_ERROR_CHECK(esp_netif_dhcpc_start(sta_netif));
 
     ESP_LOGI(TAG, "wifi_init_sta finished.");
@@ -223,7 +524,11 @@ void encryption_button_task(void* arg)
     // Встановлення режиму підтягування до живлення
     gpio_set_pull_mode(ENCRYPTION_BUTTON_GPIO, GPIO_PULLUP_ONLY);
 
+    // Коротке натискання перемикає шифрування (при відпусканні),
+    // довге - наступний канал (щойно кнопку втримали LONG_PRESS_MS)
     int last_state = 1;
+    TickType_t pressed_at = 0;
+    bool long_press = false;
     while(1) 
     {
         int state = gpio_get_level(ENCRYPTION_BUTTON_GPIO);
@@ -231,11 +536,22 @@ void encryption_button_task(void* arg)
         {
             last_state = state;
             if(state == 0) 
+            {
+                pressed_at = xTaskGetTickCount();
+                long_press = false;
+            }
+            else if(!long_press)
             {
                 encryption_enabled = !encryption_enabled;
                 ESP_LOGI(TAG, "Encryption %s", encryption_enabled ? "enabled" : "disabled");
             }
         }
+        else if(state == 0 && !long_press && xTaskGetTickCount() - pressed_at >= pdMS_TO_TICKS(LONG_PRESS_MS))
+        {
+            long_press = true;
+            requested_channel = tx_channel % CHANNEL_SELECT_COUNT + 1;
+            ESP_LOGI(TAG, "Channel %d selected", requested_channel);
+        }
         vTaskDelay(10 / portTICK_PERIOD_MS);     // Затримка для запобігання багаторазового натискання кнопки
     }
 }
@@ -260,12 +576,12 @@ void button_task(void* arg)
             if(state == 0) 
             {
                 ESP_LOGI(TAG, "Button Pressed");
-                 transmit_data = true; 
+                ptt_pressed = true;
             } 
             else 
             {
                 ESP_LOGI(TAG, "Button Released");
-               transmit_data = false; 
+                ptt_pressed = false;
             }
         }
         vTaskDelay(10 / portTICK_PERIOD_MS);    // Затримка для запобігання багаторазового натискання кнопки
@@ -289,395 +605,1671 @@ void high_pass_filter(int16_t *buffer, size_t length, float alpha) {
     }
 }
 
-void my_aes_encrypt(uint8_t *input, uint8_t *output, size_t length, uint8_t *key) {
-    mbedtls_aes_context aes;
-    mbedtls_aes_init(&aes);
-    mbedtls_aes_setkey_enc(&aes, key, 128);
-
-    // Шифрування даних блочним методом ECB
-    for (size_t i = 0; i < length; i += 16) {
-        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, input + i, output + i);
+// Проріджування кадру: середнє кожних (1 << shift) відліків
+void decimate_frame(const int16_t *in, size_t length, uint8_t shift, int16_t *out) {
+    size_t step = (size_t)1 << shift;
+    for (size_t i = 0; i < length / step; i++) {
+        int32_t sum = 0;
+        for (size_t k = 0; k < step; k++) {
+            sum += in[i * step + k];
+        }
+        out[i] = (int16_t)(sum >> shift);
     }
-
-    mbedtls_aes_free(&aes);
 }
 
-void my_aes_decrypt(uint8_t *input, uint8_t *output, size_t length, uint8_t *key) {
-    mbedtls_aes_context aes;
-    mbedtls_aes_init(&aes);
-    mbedtls_aes_setkey_dec(&aes, key, 128);
-
-    // Дешифрування даних блочним методом ECB
-    for (size_t i = 0; i < length; i += 16) {
-        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_DECRYPT, input + i, output + i);
+// Відновлення повної частоти лінійною інтерполяцією
+void expand_frame(const int16_t *in, size_t length, uint8_t shift, int16_t *out) {
+    size_t step = (size_t)1 << shift;
+    for (size_t i = 0; i < length; i++) {
+        int32_t a = in[i];
+        int32_t b = (i + 1 < length) ? in[i + 1] : in[i];
+        for (size_t k = 0; k < step; k++) {
+            out[i * step + k] = (int16_t)(a + ((b - a) * (int32_t)k >> shift));
+        }
     }
-
-    mbedtls_aes_free(&aes);
 }
 
-void udp_send_task(void *pvParameters)
-{
-    int addr_family = AF_INET;
-    int ip_protocol = IPPROTO_IP;
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(PORT);
-
-    // Виділення пам'яті для буфера даних та шифрованого буфера
-    uint8_t *read_buf = (uint8_t *)calloc(1, UDP_BUFFER_SIZE);
-    uint8_t *encrypted_buf = (uint8_t *)calloc(1, UDP_BUFFER_SIZE);
-    assert(read_buf); // Перевірка на успішне виділення пам'яті
-    assert(encrypted_buf);
-    size_t read_bytes = 0;
-
-#ifdef IS_SERVER
-    dest_addr.sin_addr.s_addr = inet_addr(CLIENT_IP_ADDR);
-#else
-    dest_addr.sin_addr.s_addr = inet_addr(SERVER_IP_ADDR);
-#endif
+// Разове шифрування службових даних. Аудіо йде через audio_enc/audio_dec
+void my_aes_encrypt(const uint8_t *input, uint8_t *output, size_t length, const uint8_t *key) {
+    aes_batch_t aes;
+    aes_batch_init(&aes);
+    aes_batch_setkey(&aes, key, AES_BATCH_ENCRYPT);
 
-    while (1) {
-        if (transmit_data) {
-            if (i2s_channel_read(rx_chan, read_buf, UDP_BUFFER_SIZE, &read_bytes, 1000) == ESP_OK) {
-                // Підсилюємо сигнал
-                amplify_signal((int16_t *)read_buf, read_bytes / 2, 10.0f); // Підсилюємо в 10 разів
-
-                // Фільтруємо сигнал
-                //high_pass_filter((int16_t *)read_buf, read_bytes / 2, 0.9f);
-
-                // Шифрування даних, якщо увімкнено шифрування
-               if (encryption_enabled) {
-                    my_aes_encrypt(read_buf, encrypted_buf, read_bytes, aes_key);
-                } else {
-                    memcpy(encrypted_buf, read_buf, read_bytes);
-                }
-
-                // Відправка даних по UDP
-                int sock = socket(addr_family, SOCK_DGRAM, ip_protocol);
-                int err = sendto(sock, encrypted_buf, read_bytes, 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-                if (err < 0) {
-                    ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
-                }
-                close(sock);
-            }
-        } 
-        vTaskDelay(10 / portTICK_PERIOD_MS);        // Для запобігання watch dog
-    }
+    // Шифрування даних блочним методом ECB
+    aes_batch_crypt(&aes, input, output, length);
 
-    // Звільнення виділеної пам'яті
-    free(read_buf);
-    free(encrypted_buf);
+    aes_batch_free(&aes);
 }
 
-void udp_receive_task(void *pvParameters)
-{
-    int addr_family = AF_INET;
-    int ip_protocol = IPPROTO_IP;
-    struct sockaddr_in source_addr;
-    source_addr.sin_family = AF_INET;
-    source_addr.sin_port = htons(PORT);
-    source_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-
-    // Створення UDP сокету
-    int sock = socket(addr_family, SOCK_DGRAM, ip_protocol);
-    bind(sock, (struct sockaddr *)&source_addr, sizeof(source_addr));
+void my_aes_decrypt(const uint8_t *input, uint8_t *output, size_t length, const uint8_t *key) {
+    aes_batch_t aes;
+    aes_batch_init(&aes);
+    aes_batch_setkey(&aes, key, AES_BATCH_DECRYPT);
 
-    // Налаштування таймауту для recvfrom
-    struct timeval timeout;
-    timeout.tv_sec = 0; // 0 секунд
-    timeout.tv_usec = 100000; // 100 мілісекунд
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    // Дешифрування даних блочним методом ECB
+    aes_batch_crypt(&aes, input, output, length);
 
-    // Виділення пам'яті для буфера даних та дешифрованого буфера
-    uint8_t *write_buf = (uint8_t *)calloc(1, UDP_BUFFER_SIZE);
-    uint8_t *decrypted_buf = (uint8_t *)calloc(1, UDP_BUFFER_SIZE);
-    assert(write_buf); // Перевірка на успішне виділення пам'яті
-    assert(decrypted_buf);
-    size_t write_bytes = 0;     
+    aes_batch_free(&aes);
+}
 
-    TickType_t last_receive_time = xTaskGetTickCount(); // Час останнього отримання даних
-    const TickType_t timeout_ticks = pdMS_TO_TICKS(100); // 100 мілісекунд таймаут
+// Ключ автентифікації - окремий від ключа шифрування, виводиться з нього
+static void derive_mac_key(uint8_t mac_key[AES_KEY_SIZE], const uint8_t key[AES_KEY_SIZE])
+{
+    static const uint8_t label[AES_KEY_SIZE] = "WT audio MAC key";
 
-    while (1) {
-        ESP_LOGI(TAG, "Receiving");
-
-        struct sockaddr_in dest_addr;
-        socklen_t socklen = sizeof(dest_addr);
-
-        // Отримання даних по UDP   
-        int len = recvfrom(sock, write_buf, UDP_BUFFER_SIZE, 0, (struct sockaddr *)&dest_addr, &socklen);
-
-        if (len < 0) {
-            receiving_data = false;
-            if (errno == EWOULDBLOCK || errno == EAGAIN) {
-                // Таймаут recvfrom, продовжуємо цикл
-                if (xTaskGetTickCount() - last_receive_time > timeout_ticks) {
-                    memset(write_buf, 0, UDP_BUFFER_SIZE); // Очищення буфера звуку при таймауті
-                    for (int i = 0; i < 5; i++) {
-                        if (i2s_channel_write(tx_chan, write_buf, UDP_BUFFER_SIZE, &write_bytes, 1000) != ESP_OK) {
-                            ESP_LOGE(TAG, "i2s write failed");
-                            break; // Виходимо з циклу, якщо запис не вдається
-                        }
-                    }
-                    last_receive_time = xTaskGetTickCount(); // Оновлюємо час останнього очищення буфера
-                }
-            } else {
-                ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
-            }
-        } else {
-            last_receive_time = xTaskGetTickCount(); // Оновлюємо час останнього отримання даних
+    my_aes_encrypt(label, mac_key, AES_KEY_SIZE, key);
+}
 
-            // Дешифрування даних, якщо увімкнено шифрування
-            if (encryption_enabled) {
-                my_aes_decrypt(write_buf, decrypted_buf, len, aes_key);
-            } else {
-                memcpy(decrypted_buf, write_buf, len);
-            }
+// Захист аудіо: кадри (audio_len байт, зашифровані або ні - за desc->key), далі
+// службові повідомлення і тег. boot_id - ідентифікатор запуску відправника
+#ifdef AUDIO_CHACHA20_POLY1305
+// Ключ 32 байти - ключ шифрування і похідний від нього. Nonce унікальний для
+// відправника в межах ключа: вузол, запуск (4 байти), час і номер пакета
+static void audio_aead_params(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id,
+                              uint8_t key[CHACHA_KEY_SIZE], uint8_t nonce[CHACHA_NONCE_SIZE])
+{
+    memcpy(key, k->key, KEYX_KEY_SIZE);
+    memcpy(key + KEYX_KEY_SIZE, k->mac_key, KEYX_KEY_SIZE);
+    pkt_put_u16(&nonce[0], hdr->node);
+    pkt_put_u32(&nonce[2], boot_id);
+    pkt_put_u32(&nonce[6], hdr->timestamp);
+    pkt_put_u16(&nonce[10], hdr->seq);
+}
 
-            receiving_data = true;
+static void audio_seal_frames(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *d,
+                              const uint8_t *body, const uint8_t *fec, size_t body_len, uint8_t *out)
+{
+    uint8_t key[CHACHA_KEY_SIZE];
+    uint8_t nonce[CHACHA_NONCE_SIZE];
 
-            // Запис даних у I2S канал
-            if (i2s_channel_write(tx_chan, decrypted_buf, len, &write_bytes, 1000) != ESP_OK) {
-                ESP_LOGE(TAG, "i2s write failed");
-            }
-        }
+    memcpy(out, body, body_len);
+    if (d->fec) {
+        memcpy(out + body_len, fec, body_len);
     }
+    if (d->key != PKT_AUDIO_KEY_NONE) {
+        audio_aead_params(k, hdr, boot_id, key, nonce);
+        chacha20_xor(key, nonce, 1, out, d->fec ? body_len * 2 : body_len);
+        memset(key, 0, sizeof(key));
+    }
+}
 
-    // Звільнення виділеної пам'яті
-    free(write_buf);
-    free(decrypted_buf);
+// Тег Poly1305: префікс і хвіст - додаткові дані, кадри - шифротекст
+// (або теж додаткові дані, якщо йдуть відкритим текстом)
+static void audio_tag(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *d,
+                      const uint8_t *data, size_t audio_len, size_t len, uint8_t tag[PKT_AUDIO_MAC_SIZE])
+{
+    uint8_t key[CHACHA_KEY_SIZE];
+    uint8_t nonce[CHACHA_NONCE_SIZE];
+    uint8_t prefix[PKT_MAC_PREFIX_SIZE];
+    uint8_t full[POLY1305_TAG_SIZE];
+    chachapoly_t c;
+
+    audio_aead_params(k, hdr, boot_id, key, nonce);
+    chachapoly_start(&c, key, nonce);
+    memset(key, 0, sizeof(key));
+    chachapoly_aad(&c, prefix, pkt_write_mac_prefix(prefix, hdr, d, boot_id));
+    if (d->key == PKT_AUDIO_KEY_NONE) {
+        chachapoly_aad(&c, data, len);
+    } else {
+        chachapoly_aad(&c, data + audio_len, len - audio_len);
+        chachapoly_ct(&c, data, audio_len);
+    }
+    chachapoly_finish(&c, full);
+    memcpy(tag, full, PKT_AUDIO_MAC_SIZE);
 }
 
-// Конфігурація I2S каналу для приймання (RX) даних
-void microphone_init(void)  
+static void audio_open_frames(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *d,
+                              const uint8_t *in, uint8_t *out, size_t audio_len)
 {
-    i2s_chan_config_t rx_chan_cfg  = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_RX, I2S_ROLE_MASTER);
-    ESP_ERROR_CHECK(i2s_new_channel(&rx_chan_cfg , NULL, &rx_chan));
-    
-    i2s_std_config_t rx_std_cfg  = 
-    {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
-        .gpio_cfg =
-        {
-            .mclk = I2S_GPIO_UNUSED, 
-            .bclk = I2S_SCL_RX,
-            .ws = I2S_WS_RX,
-            .dout = I2S_GPIO_UNUSED,
-            .din = I2S_SD_RX,
-            .invert_flags =
-            {
-                .mclk_inv = false,
-                .bclk_inv = false,
-                .ws_inv = false,
-            },
+    uint8_t key[CHACHA_KEY_SIZE];
+    uint8_t nonce[CHACHA_NONCE_SIZE];
+
+    memcpy(out, in, audio_len);
+    if (d->key != PKT_AUDIO_KEY_NONE) {
+        audio_aead_params(k, hdr, boot_id, key, nonce);
+        chacha20_xor(key, nonce, 1, out, audio_len);
+        memset(key, 0, sizeof(key));
+    }
+}
+#else
+// Кадри і копія FEC одним викликом
+static void audio_seal_frames(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *d,
+                              const uint8_t *body, const uint8_t *fec, size_t body_len, uint8_t *out)
+{
+    if (d->key == PKT_AUDIO_KEY_NONE) {
+        memcpy(out, body, body_len);
+        if (d->fec) {
+            memcpy(out + body_len, fec, body_len);
         }
+        return;
+    }
+    aes_batch_seg_t segs[2] = {
+        { .in = body, .out = out, .len = body_len },
+        { .in = fec, .out = out + body_len, .len = body_len },
     };
+    aes_batch_setkey(&audio_enc, k->key, AES_BATCH_ENCRYPT);
+    aes_batch_run(&audio_enc, segs, d->fec ? 2 : 1);
+}
 
-    ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_chan, &rx_std_cfg ));
-    ESP_ERROR_CHECK(i2s_channel_enable(rx_chan));
+// Тег: усічений CMAC від канонічного префікса і всього, що після заголовка
+static void audio_tag(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *d,
+                      const uint8_t *data, size_t audio_len, size_t len, uint8_t tag[PKT_AUDIO_MAC_SIZE])
+{
+    uint8_t prefix[PKT_MAC_PREFIX_SIZE];
+    uint8_t full[CMAC_BLOCK_SIZE];
+    cmac_t *cmac = mac_cache_get(&mac_keys, k->mac_key);
+
+    cmac_update(cmac, prefix, pkt_write_mac_prefix(prefix, hdr, d, boot_id));
+    cmac_update(cmac, data, len);
+    cmac_finish(cmac, full);
+    memcpy(tag, full, PKT_AUDIO_MAC_SIZE);
 }
 
-// Конфігурація I2S каналу для передавання (TX) даних
-void speaker_init(void)
+static void audio_open_frames(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *d,
+                              const uint8_t *in, uint8_t *out, size_t audio_len)
 {
-    i2s_chan_config_t tx_chan_cfg  = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_TX, I2S_ROLE_MASTER);
-    ESP_ERROR_CHECK(i2s_new_channel(&tx_chan_cfg, &tx_chan, NULL));
-    
-    i2s_std_config_t tx_std_cfg  = 
-    {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
-        .gpio_cfg =
-        {
-            .mclk = I2S_GPIO_UNUSED, 
-            .bclk = I2S_SCK_TX,
-            .ws = I2S_WS_TX,
-            .dout = I2S_DATA_OUT_TX,
-            .din = -1
-        }
-    };
+    if (d->key == PKT_AUDIO_KEY_NONE) {
+        memcpy(out, in, audio_len);
+        return;
+    }
+    aes_batch_setkey(&audio_dec, k->key, AES_BATCH_DECRYPT);
+    aes_batch_crypt(&audio_dec, in, out, audio_len);
+}
+#endif
 
+// Порівняння тегу за сталий час
+static bool audio_tag_ok(const keyx_key_t *k, const pkt_header_t *hdr, uint32_t boot_id, const pkt_audio_desc_t *d,
+                         const uint8_t *data, size_t audio_len, size_t len, const uint8_t *tag)
+{
+    uint8_t expected[PKT_AUDIO_MAC_SIZE];
+    uint8_t diff = 0;
 
-    ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_chan, &tx_std_cfg ));
-    ESP_ERROR_CHECK(i2s_channel_enable(tx_chan));
+    audio_tag(k, hdr, boot_id, d, data, audio_len, len, expected);
+    for (int i = 0; i < PKT_AUDIO_MAC_SIZE; i++) {
+        diff |= expected[i] ^ tag[i];
+    }
+    return diff == 0;
 }
 
-// Функція для відображення тексту на дисплеї
-void DrawText(TFT_t * dev, FontxFile *fx, int width, int height, const char* text1, const char* text2, const char* text3, const char* text4, uint16_t bgColor, uint16_t textColor) {
-    uint16_t xpos1, ypos1, xpos2, ypos2, xpos3, ypos3, xpos4, ypos4;
-    uint8_t ascii1[24], ascii2[24], ascii3[24], ascii4[24];
+// Тег службового пакета окремою датаграмою - завжди CMAC груповим ключем
+// автентифікації: сеансових ключів до обміну (який сам іде службовими пакетами) немає
+static void control_tag(const pkt_header_t *hdr, uint32_t boot_id, const uint8_t *payload, size_t len,
+                        uint8_t tag[PKT_CONTROL_MAC_SIZE])
+{
+    uint8_t prefix[PKT_CONTROL_PREFIX_SIZE];
+    uint8_t full[CMAC_BLOCK_SIZE];
+    cmac_t *cmac = mac_cache_get(&mac_keys, group_key.mac_key);
+
+    cmac_update(cmac, prefix, pkt_write_control_prefix(prefix, hdr, boot_id));
+    cmac_update(cmac, payload, len);
+    cmac_finish(cmac, full);
+    memcpy(tag, full, PKT_CONTROL_MAC_SIZE);
+}
 
-    // Встановлюємо колір фону 
-    lcdFillScreen(dev, bgColor);
+static bool control_tag_ok(const pkt_header_t *hdr, uint32_t boot_id, const uint8_t *payload, size_t len,
+                           const uint8_t *tag)
+{
+    uint8_t expected[PKT_CONTROL_MAC_SIZE];
+    uint8_t diff = 0;
 
-    // Встановлюємо тексти для відображення
-    strcpy((char *)ascii1, text1);
-    strcpy((char *)ascii2, text2);
-    strcpy((char *)ascii3, text3);
-    strcpy((char *)ascii4, text4);
+    control_tag(hdr, boot_id, payload, len, expected);
+    for (int i = 0; i < PKT_CONTROL_MAC_SIZE; i++) {
+        diff |= expected[i] ^ tag[i];
+    }
+    return diff == 0;
+}
 
-    // Розраховуємо позицію для центрування першого тексту
-    uint8_t buffer[FontxGlyphBufSize];
-    uint8_t fontWidth;
-    uint8_t fontHeight;
-    GetFontx(fx, 0, buffer, &fontWidth, &fontHeight);
-    xpos1 = (width - (strlen((char *)ascii1) * fontWidth)) / 2;
-    ypos1 = (height / 2) - fontHeight * 3;
+// Маяк з discovery: запуск у тезі той самий, що в маяку
+static size_t beacon_seal(void *ctx, uint8_t *buf, size_t len)
+{
+    pkt_header_t hdr;
 
-    // Розраховуємо позицію для центрування другого тексту
-    xpos2 = (width - (strlen((char *)ascii2) * fontWidth)) / 2;
-    ypos2 = (height / 2) - fontHeight;
+    pkt_read_header(buf, len, &hdr);
+    control_tag(&hdr, discovery.local.boot_id, buf + PKT_HEADER_SIZE, len - PKT_HEADER_SIZE, buf + len);
+    return len + PKT_CONTROL_MAC_SIZE;
+}
 
-    // Розраховуємо позицію для центрування третього тексту
-    xpos3 = (width - (strlen((char *)ascii3) * fontWidth)) / 2;
-    ypos3 = (height / 2) + fontHeight;
+// Зведена статистика каналу для дисплея та консолі
+void walkie_get_link_summary(link_summary_t *out)
+{
+    taskENTER_CRITICAL(&link_summary_lock);
+    *out = link_summary;
+    taskEXIT_CRITICAL(&link_summary_lock);
+}
 
-    // Розраховуємо позицію для центрування четвертого тексту
-    xpos4 = (width - (strlen((char *)ascii4) * fontWidth)) / 2;
-    ypos4 = (height / 2) + fontHeight * 3;
+// Публікуємо статистику того, хто говорив останнім (або кого чули останнім)
+static void publish_link_summary(void)
+{
+    link_summary_t summary;
+    peer_t *best = NULL;
 
-    // Встановлюємо напрямок шрифту та колір
-    lcdSetFontDirection(dev, DIRECTION0);
-    lcdDrawString(dev, fx, xpos1, ypos1, ascii1, textColor);
-    lcdDrawString(dev, fx, xpos2, ypos2, ascii2, textColor);
-    if (strlen((char *)ascii3) > 0) {
-        lcdDrawString(dev, fx, xpos3, ypos3, ascii3, textColor);
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        peer_t *p = &peers.peers[i];
+        if (!p->used) {
+            continue;
+        }
+        if (best == NULL ||
+            (int32_t)(p->last_audio_ms - best->last_audio_ms) > 0 ||
+            (p->last_audio_ms == best->last_audio_ms && (int32_t)(p->last_seen_ms - best->last_seen_ms) > 0)) {
+            best = p;
+        }
     }
-    if (strlen((char *)ascii4) > 0) {
-        lcdDrawString(dev, fx, xpos4, ypos4, ascii4, textColor);
+    if (best) {
+        link_stats_summary(&best->stats, &summary);
+    } else {
+        memset(&summary, 0, sizeof(summary));
     }
-    lcdDrawFinish(dev);
+    taskENTER_CRITICAL(&link_summary_lock);
+    link_summary = summary;
+    taskEXIT_CRITICAL(&link_summary_lock);
 }
 
-// Функція для управління дисплеєм ST7789
-void ST7789(void *pvParameters)
+// Відтворення кадрів пакета з відновленням повної частоти дискретизації
+static void play_frames(const uint8_t *body, const pkt_audio_desc_t *desc)
 {
-    // Ініціалізація файлу шрифту
-    FontxFile fx16G[2];
-    InitFontx(fx16G,"/spiffs/ILGH16XB.FNT",""); // 8x16Dot Gothic
-
-    TFT_t dev;
-
-    // Ініціалізація дисплея
-    spi_master_init(&dev, CONFIG_MOSI_GPIO, CONFIG_SCLK_GPIO, CONFIG_CS_GPIO, CONFIG_DC_GPIO, CONFIG_RESET_GPIO, CONFIG_BL_GPIO);
-    lcdInit(&dev, CONFIG_WIDTH, CONFIG_HEIGHT, CONFIG_OFFSETX, CONFIG_OFFSETY);
-
-    esp_rom_gpio_pad_select_gpio(BUTTON_GPIO);
-    gpio_set_direction(BUTTON_GPIO, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(BUTTON_GPIO, GPIO_PULLUP_ONLY);
+    size_t frame_bytes = UDP_BUFFER_SIZE >> desc->decim_shift;
 
-    char encryption_status[24];
-    
-    bool last_transmit_state = false;
-    bool last_receive_state = false;
-    bool last_encryption_state = encryption_enabled;
+    for (int i = 0; i < desc->frames; i++) {
+        const uint8_t *frame = body + i * frame_bytes;
+        if (desc->decim_shift == 0) {
+            memcpy(play_buf, frame, UDP_BUFFER_SIZE);
+        } else {
+            expand_frame((const int16_t *)frame, frame_bytes / 2, desc->decim_shift, (int16_t *)play_buf);
+        }
 
-    // Стартове оновлення дисплея
-    snprintf(encryption_status, sizeof(encryption_status), "Encryption: %s", encryption_enabled ? "ON" : "OFF");
-#ifdef IS_SERVER
-    DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "SERVER", "", encryption_status, BLUE, WHITE);
-#else
-    DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "CLIENT", "", encryption_status, BLUE, WHITE);
-#endif
+        // Кадр - задачі динаміка; черга повна - динамік відстає, кадр відкидається
+        if (xQueueSend(play_queue, play_buf, 0) != pdTRUE) {
+            play_overruns++;
+        }
+    }
+}
 
-    while (1) {
-        bool update_display = false;
+// Підлаштування рівня якості за найгіршим зі звітів приймачів про наш потік
+static void update_rate_level(void)
+{
+    rate_sample_t sample = { 0 };
+    bool have_sample = false;
 
-        // Перевірка на зміну станів передавання/прийому/шифрування
-        if (transmit_data != last_transmit_state) {
-            last_transmit_state = transmit_data;
-            update_display = true;
+    if (!transmit_data) {
+        return;
+    }
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        const link_stats_t *ls = &peers.peers[i].stats;
+        if (!peers.peers[i].used || !ls->remote_valid) {
+            continue;
         }
-
-        if (receiving_data != last_receive_state) {
-            last_receive_state = receiving_data;
-            update_display = true;
+        have_sample = true;
+        if (ls->remote.fraction_lost > sample.fraction_lost) {
+            sample.fraction_lost = ls->remote.fraction_lost;
         }
+        if ((ls->remote.jitter_q4 >> 4) > sample.jitter_ms) {
+            sample.jitter_ms = ls->remote.jitter_q4 >> 4;
+        }
+        if (ls->rtt_valid && (!sample.rtt_valid || ls->rtt_ms > sample.rtt_ms)) {
+            sample.rtt_valid = true;
+            sample.rtt_ms = ls->rtt_ms;
+        }
+    }
+    if (!have_sample) {
+        return;
+    }
+    if (rate_ctl_update(&rate_ctl, &sample)) {
+        const rate_level_t *lvl = rate_ctl_level(&rate_ctl);
+        ESP_LOGI(TAG, "Rate level %d: %d Hz, %d frames/packet, FEC %s", rate_ctl.level,
+                 SAMPLE_RATE >> lvl->decim_shift, lvl->frames_per_packet, lvl->fec ? "on" : "off");
+    }
+}
 
-        if (encryption_enabled != last_encryption_state) {
-            last_encryption_state = encryption_enabled;
-            update_display = true;
+// Пристрої, що говорять на нашому каналі: від них чекаємо згоди на слово
+static int known_peers(void)
+{
+    int n = 0;
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        if (peers.peers[i].used && peers.peers[i].channel == channels.tx) {
+            n++;
         }
+    }
+    return n;
+}
 
-        snprintf(encryption_status, sizeof(encryption_status), "Encryption: %s", encryption_enabled ? "ON" : "OFF");
+// Службове повідомлення окремим пакетом
+static void send_control(uint8_t type, const uint8_t *payload, size_t payload_len,
+                         const struct sockaddr_in *dest, uint32_t now_ms)
+{
+    uint8_t buf[PKT_HEADER_SIZE + PKT_CONTROL_MAX_SIZE + PKT_CONTROL_MAC_SIZE];
+
+    pkt_header_t hdr = {
+        .type = type,
+        .group = channels.tx,
+        .node = node_id,
+        .seq = control_seq++,
+        .timestamp = now_ms
+    };
+    size_t len = pkt_write_header(buf, &hdr);
+    memcpy(buf + len, payload, payload_len);
+    control_tag(&hdr, discovery.local.boot_id, buf + len, payload_len, buf + len + payload_len);
+    net_engine_send(&net, buf, len + payload_len + PKT_CONTROL_MAC_SIZE, dest);
+}
 
-        // Оновлення дисплея, якщо змінився якийсь стан
-        if (update_display) {
-#ifdef IS_SERVER
-            if (transmit_data && receiving_data) { // Повний дуплекс
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "SERVER", "Full-Duplex", encryption_status, PURPLE, WHITE);
-            } else if (transmit_data) { // Передача даних
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "SERVER", "Transmitting", encryption_status, RED, WHITE);
-            } else if (receiving_data) { // Прийом даних
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "SERVER", "Receiving", encryption_status, GREEN, WHITE);
-            } else { // Бездіяльність
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "SERVER", "", encryption_status, BLUE, WHITE);
-            }
-#else
-            if (transmit_data && receiving_data) { // Повний дуплекс    
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "CLIENT", "Full-Duplex", encryption_status, PURPLE, WHITE);
-            } else if (transmit_data) { // Передача даних
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "CLIENT", "Transmitting", encryption_status, RED, WHITE);
-            } else if (receiving_data) { // Прийом даних
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "CLIENT", "Receiving", encryption_status, GREEN, WHITE);
-            } else { // Бездіяльність
-                DrawText(&dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, "Walkie-Talkie", "CLIENT", "", encryption_status, BLUE, WHITE);
-            }
-#endif
-        }
+static bool same_dest(const struct sockaddr_in *a, const struct sockaddr_in *b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
 
-        // Перевірка станів кожні 200 мс
-        vTaskDelay(200 / portTICK_PERIOD_MS);
+// Місце в хвості наступного аудіо пакета. Повертає false, якщо треба слати окремо
+static bool piggyback_add(uint8_t type, const uint8_t *payload, size_t payload_len,
+                          const struct sockaddr_in *dest, uint32_t now_ms)
+{
+    if (!same_dest(dest, &tx_dest) || piggyback_len + PKT_TRAILER_ITEM_HDR + payload_len > sizeof(piggyback)) {
+        return false;
     }
+    if (piggyback_len == 0 && piggyback_report == NULL) {
+        piggyback_since_ms = now_ms;
+    }
+    piggyback_len += pkt_write_trailer_item(piggyback + piggyback_len, type, payload, payload_len);
+    return true;
 }
 
-void app_main(void)
+// Хвіст для аудіо пакета: службові повідомлення, що чекають. Повертає довжину
+static size_t piggyback_write(uint8_t *buf, uint32_t now_ms)
 {
-    // Ініціалізація NVS (Non-Volatile Storage)
-    ESP_ERROR_CHECK(nvs_flash_init());
+    size_t len = 0;
 
-    // Ініціалізація мережевого інтерфейсу
-    ESP_ERROR_CHECK(esp_netif_init());
+    if (piggyback_report == NULL && piggyback_len == 0) {
+        return 0;
+    }
+    if (piggyback_report) {
+        uint8_t payload[PKT_REPORT_SIZE];
+        pkt_report_t report;
+        link_stats_build_report(piggyback_report, now_ms, &report);
+        len += pkt_write_trailer_item(buf, PKT_TYPE_REPORT, payload, pkt_write_report(payload, &report));
+        piggyback_report = NULL;
+    }
+    memcpy(buf + len, piggyback, piggyback_len);
+    len += piggyback_len;
+    piggyback_len = 0;
+    piggyback_packets++;
+    return len;
+}
 
-    // Створення циклу обробки подій за замовчуванням
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
+// Аудіо пакета не буде (передачу зупинено) або він запізнюється - відправка окремо
+static void piggyback_flush(uint32_t now_ms)
+{
+    if (piggyback_report == NULL && piggyback_len == 0) {
+        return;
+    }
+    if (transmit_data && (uint32_t)(now_ms - piggyback_since_ms) < PIGGYBACK_MAX_DELAY_MS) {
+        return;
+    }
+    if (piggyback_report) {
+        uint8_t payload[PKT_REPORT_SIZE];
+        pkt_report_t report;
+        link_stats_build_report(piggyback_report, now_ms, &report);
+        send_control(PKT_TYPE_REPORT, payload, pkt_write_report(payload, &report), &tx_dest, now_ms);
+        piggyback_report = NULL;
+    }
 
-    wifi_init();
-    microphone_init();
-    speaker_init();
-    
-    ESP_LOGI(TAG, "Initializing SPIFFS");
+    const uint8_t *item = piggyback;
+    const uint8_t *data;
+    size_t left = piggyback_len;
+    uint8_t type;
+    uint8_t data_len;
+    while (pkt_next_trailer_item(&item, &left, &type, &data, &data_len)) {
+        send_control(type, data, data_len, &tx_dest, now_ms);
+    }
+    piggyback_len = 0;
+}
 
-    esp_vfs_spiffs_conf_t conf = {
-        .base_path = "/spiffs",
-        .partition_label = NULL,
-        .max_files = 12,
-        .format_if_mount_failed = true
-    };
+// Відправка повідомлень керування словом і перемикання передачі
+static void floor_update(uint32_t now_ms)
+{
+    pkt_floor_t msg;
+    uint8_t payload[PKT_FLOOR_SIZE];
+
+    // Поки говоримо, відповіді їдуть з наступним аудіо пакетом. Відпускання слова - окремо і одразу
+    bool talk = floor_ctl_can_talk(&floor_ctl);
+    while (floor_ctl_pop(&floor_ctl, &msg)) {
+        size_t len = pkt_write_floor(payload, &msg);
+        if (!(talk && transmit_data && piggyback_add(PKT_TYPE_FLOOR, payload, len, &tx_dest, now_ms))) {
+            send_control(PKT_TYPE_FLOOR, payload, len, &tx_dest, now_ms);
+        }
+    }
 
-    esp_err_t spiffs = esp_vfs_spiffs_register(&conf);
+    if (talk != transmit_data) {
+        transmit_data = talk;
+        ESP_LOGI(TAG, "Floor %s", talk ? "granted" : "released");
+    }
+}
 
-    // Перевірка, чи успішно була ініціалізована файлова системи SPIFFS
-    if (spiffs != ESP_OK) {
-        if (spiffs == ESP_FAIL) {
-            ESP_LOGE(TAG, "Failed to mount or format filesystem");
-        } else if (spiffs == ESP_ERR_NOT_FOUND) {
-            ESP_LOGE(TAG, "Failed to find SPIFFS partition");
-        } else {
-            ESP_LOGE(TAG, "Failed to initialize SPIFFS (%s)",esp_err_to_name(spiffs));
+// Співрозмовник у режимі один-на-один - той, кого чули останнім
+static void select_unicast_peer(void)
+{
+#ifndef TALK_GROUP_MODE
+    peer_t *best = NULL;
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        peer_t *p = &peers.peers[i];
+        if (p->used && p->info_valid && (best == NULL || (int32_t)(p->last_seen_ms - best->last_seen_ms) > 0)) {
+            best = p;
+        }
+    }
+    if (best == NULL) {
+        if (peer_known) {
+            ESP_LOGW(TAG, "Peer %04x lost", peer_node);
         }
+        peer_known = false;
         return;
     }
+    if (!peer_known || peer_node != best->node) {
+        ESP_LOGI(TAG, "Talking to %04x at %s", best->node, inet_ntoa(best->addr.sin_addr));
+        hdr_comp_tx_refresh(&tx_comp); // Новий приймач не має контексту стиснення
+    }
+    peer_known = true;
+    peer_node = best->node;
+    peer_addr = best->addr;
+    tx_dest = peer_addr;
+#endif
+}
 
-    // Затримка для стабілізації системи перед запуском задач
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
+// Фонова задача обміну ключами: нижчий пріоритет за мережеву, тож аудіо
+// ніколи не чекає на множення X25519
+void keyx_task(void *arg)
+{
+    keyx_job_t job;
+    uint8_t shared[X25519_KEY_SIZE];
+    uint8_t kdf_in[X25519_KEY_SIZE * 3 + AES_KEY_SIZE];
+    uint8_t digest[32];
+
+    // Випадкові числа апаратного генератора надійні лише з увімкненим радіо
+    boot_wait(BOOT_NETIF_UP, portMAX_DELAY);
+    esp_fill_random(keyx_secret, sizeof(keyx_secret));
+
+    int64_t start_us = esp_timer_get_time();
+    memset(&job, 0, sizeof(job));
+    x25519_public(keyx_pub, keyx_secret);
+    job.own = true;
+    job.ok = true;
+    ESP_LOGI(TAG, "X25519 key pair in %d ms", (int)((esp_timer_get_time() - start_us) / 1000));
+    xQueueSend(keyx_results, &job, portMAX_DELAY);
 
-    xTaskCreate(udp_send_task, "udp_send_task", 4096, NULL, 2, NULL); 
-    xTaskCreate(udp_receive_task, "udp_receive_task", 4096, NULL, 2, NULL);
+    while (1) {
+        xQueueReceive(keyx_jobs, &job, portMAX_DELAY);
+
+        start_us = esp_timer_get_time();
+        job.ok = x25519_shared(shared, keyx_secret, job.pub);
+        if (job.ok) {
+            // Парний ключ: SHA-256(секрет | груповий ключ | відкриті ключі за зростанням).
+            // Груповий ключ не дає підмінити обмін тому, хто його не знає
+            bool own_first = memcmp(keyx_pub, job.pub, X25519_KEY_SIZE) < 0;
+            memcpy(kdf_in, shared, X25519_KEY_SIZE);
+            memcpy(kdf_in + X25519_KEY_SIZE, aes_key, AES_KEY_SIZE);
+            memcpy(kdf_in + X25519_KEY_SIZE + AES_KEY_SIZE, own_first ? keyx_pub : job.pub, X25519_KEY_SIZE);
+            memcpy(kdf_in + X25519_KEY_SIZE * 2 + AES_KEY_SIZE, own_first ? job.pub : keyx_pub, X25519_KEY_SIZE);
+            mbedtls_sha256(kdf_in, sizeof(kdf_in), digest, 0);
+            memcpy(job.pair_key, digest, KEYX_KEY_SIZE);
+            memset(kdf_in, 0, sizeof(kdf_in));
+            memset(digest, 0, sizeof(digest));
+        }
+        memset(shared, 0, sizeof(shared));
+        ESP_LOGI(TAG, "Pair key for %04x in %d ms%s", job.node,
+                 (int)((esp_timer_get_time() - start_us) / 1000), job.ok ? "" : ": rejected public key");
+        xQueueSend(keyx_results, &job, portMAX_DELAY);
+    }
+}
 
-    xTaskCreate(button_task, "button_task", 4096, NULL, 3, NULL);
-    xTaskCreate(encryption_button_task, "encryption_button_task", 4096, NULL, 3, NULL);
+// Перші 4 байти AES(ключ, нулі): приймач перевіряє, що розгорнув той самий ключ
+static uint32_t key_check_value(const uint8_t *key)
+{
+    uint8_t zero[16] = { 0 };
+    uint8_t out[16];
+
+    my_aes_encrypt(zero, out, sizeof(out), key);
+    return pkt_get_u32(out);
+}
+
+static void send_key_msg(peer_t *peer, const pkt_key_t *msg, uint32_t now_ms)
+{
+    uint8_t payload[PKT_CONTROL_MAX_SIZE];
+
+    send_control(PKT_TYPE_KEY, payload, pkt_write_key(payload, msg), &peer->addr, now_ms);
+}
+
+static void send_key_hello(peer_t *peer, bool reply, uint32_t now_ms)
+{
+    pkt_key_t msg = { .op = PKT_KEY_HELLO, .flags = reply ? PKT_KEY_HELLO_REPLY : 0 };
+
+    memcpy(msg.data, keyx_pub, X25519_KEY_SIZE);
+    send_key_msg(peer, &msg, now_ms);
+}
+
+static void send_key_sender(peer_t *peer, const keyx_key_t *k, uint32_t now_ms)
+{
+    pkt_key_t msg = { .op = PKT_KEY_SENDER, .id = k->id, .check = key_check_value(k->key) };
+
+    my_aes_encrypt(k->key, msg.data, KEYX_KEY_SIZE, peer->keys.pair_key);
+    send_key_msg(peer, &msg, now_ms);
+}
+
+static void keyx_on_msg(peer_t *peer, const pkt_key_t *msg, uint32_t now_ms)
+{
+    keyx_peer_t *k = &peer->keys;
+
+    switch (msg->op) {
+    case PKT_KEY_HELLO:
+        if (keyx_peer_set_pub(k, msg->data)) {
+            keyx_job_t job = { .node = peer->node };
+            memcpy(job.pub, msg->data, X25519_KEY_SIZE);
+            if (xQueueSend(keyx_jobs, &job, 0) != pdTRUE) {
+                keyx_peer_init(k); // Черга повна - пристрій повторить HELLO
+                return;
+            }
+        }
+        if (msg->flags & PKT_KEY_HELLO_REPLY) {
+            // Пристрій не має нашого відкритого ключа, отже й ключа відправника
+            k->acked_mask = 0;
+            if (keyx_pub_ready) {
+                send_key_hello(peer, false, now_ms);
+            }
+        }
+        break;
+    case PKT_KEY_SENDER: {
+        uint8_t key[KEYX_KEY_SIZE];
+        uint8_t mac_key[KEYX_KEY_SIZE];
+        if (!k->pair_valid) {
+            return; // Парний ключ ще рахується, відправник повторить
+        }
+        my_aes_decrypt(msg->data, key, KEYX_KEY_SIZE, k->pair_key);
+        if (key_check_value(key) != msg->check) {
+            ESP_LOGW(TAG, "Sender key %u from %04x failed the check", msg->id, peer->node);
+            return;
+        }
+        derive_mac_key(mac_key, key);
+        keyx_peer_install(k, msg->id, key, mac_key);
+        memset(key, 0, sizeof(key));
+        memset(mac_key, 0, sizeof(mac_key));
+        pkt_key_t ack = { .op = PKT_KEY_ACK, .id = msg->id };
+        send_key_msg(peer, &ack, now_ms);
+        break;
+    }
+    case PKT_KEY_ACK:
+        keyx_peer_ack(k, msg->id);
+        break;
+    }
+}
+
+// Результати фонової задачі, новий ключ відправника і повтори обміну.
+// Ключ відправника вмикається, коли його підтвердили всі відомі пристрої
+static void keyx_update(uint32_t now_ms)
+{
+    keyx_job_t res;
+
+    while (xQueueReceive(keyx_results, &res, 0) == pdTRUE) {
+        if (res.own) {
+            keyx_pub_ready = true;
+            continue;
+        }
+        peer_t *p = peer_table_find(&peers, res.node);
+        // Відповідь могла запізнитись: пристрій уже зник або змінив ключ
+        if (p == NULL || !p->keys.pub_valid || memcmp(p->keys.pub, res.pub, X25519_KEY_SIZE) != 0 || !res.ok) {
+            continue;
+        }
+        p->keys.pair_valid = true;
+        memcpy(p->keys.pair_key, res.pair_key, KEYX_KEY_SIZE);
+        p->keys.sent_ms = now_ms - KEYX_RETRY_MS; // Ключ відправника - одразу
+    }
+    if (!keyx_pub_ready) {
+        return;
+    }
+
+    if (keyx_tx_rekey_due(&tx_keys, now_ms)) {
+        uint8_t key[KEYX_KEY_SIZE];
+        uint8_t mac_key[KEYX_KEY_SIZE];
+        esp_fill_random(key, sizeof(key));
+        derive_mac_key(mac_key, key);
+        keyx_tx_prepare(&tx_keys, key, mac_key);
+        memset(key, 0, sizeof(key));
+        memset(mac_key, 0, sizeof(mac_key));
+    }
+
+    bool capable = true;
+    bool has_cur = true;
+    bool has_next = true;
+    const keyx_key_t *target = tx_keys.next.valid ? &tx_keys.next : &tx_keys.cur;
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        peer_t *p = &peers.peers[i];
+        keyx_peer_t *k = &p->keys;
+        if (!p->used) {
+            continue;
+        }
+        if (!p->info_valid || !(p->info.caps & PKT_CAP_KEYX)) {
+            capable = false; // Лише спільний груповий ключ
+            continue;
+        }
+        has_cur = has_cur && keyx_peer_has(k, &tx_keys.cur);
+        has_next = has_next && keyx_peer_has(k, &tx_keys.next);
+        if ((uint32_t)(now_ms - k->sent_ms) < KEYX_RETRY_MS) {
+            continue;
+        }
+        if (!k->pub_valid) {
+            send_key_hello(p, true, now_ms);
+            k->sent_ms = now_ms;
+        } else if (k->pair_valid && target->valid && !keyx_peer_has(k, target)) {
+            send_key_sender(p, target, now_ms);
+            k->sent_ms = now_ms;
+        }
+    }
+    keyx_tx_update(&tx_keys, capable, has_cur, has_next);
+}
+
+// Звіт або повідомлення керування словом: окремим пакетом чи в хвості аудіо
+static void handle_control(peer_t *peer, const pkt_header_t *hdr, uint8_t type,
+                           const uint8_t *data, size_t len, uint32_t now_ms)
+{
+    if (type == PKT_TYPE_REPORT) {
+        pkt_report_t report;
+        if (pkt_read_report(data, len, &report)) {
+            link_stats_on_report(&peer->stats, &report, now_ms);
+        }
+    } else if (type == PKT_TYPE_FLOOR) {
+        pkt_floor_t msg;
+        if (hdr->group == channels.tx && pkt_read_floor(data, len, &msg)) {
+            floor_ctl_on_msg(&floor_ctl, hdr->node, &msg, now_ms, known_peers());
+            floor_update(now_ms); // Відповідь одразу, щоб слово надавалось за один RTT
+        }
+    } else if (type == PKT_TYPE_KEY) {
+        pkt_key_t msg;
+        if (pkt_read_key(data, len, &msg)) {
+            keyx_on_msg(peer, &msg, now_ms);
+        }
+    }
+}
+
+// Шифрування потрібне, якщо його вимагає хоч один відомий пристрій
+static void update_crypto_mode(void)
+{
+    bool required = false;
+
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        const peer_t *p = &peers.peers[i];
+        if (p->used && p->info_valid && (p->info.caps & PKT_CAP_ENCRYPTED)) {
+            required = true;
+        }
+    }
+    bool was = crypto_mode_tx_encrypted(&crypto);
+    crypto_mode_set_peers(&crypto, required);
+    if (crypto_mode_tx_encrypted(&crypto) != was) {
+        ESP_LOGI(TAG, "Transmitting %s", crypto_mode_tx_encrypted(&crypto) ? "encrypted" : "in plaintext");
+    }
+    crypto_status = crypto_mode_status(&crypto);
+}
+
+// Аудіо пакет. Спершу найдешевші відмови: формат, відправник без маяка, вікно
+// повторів, тег. Стан відправника (вікно, контекст заголовків, ключ, статистика)
+// змінює лише автентифікований пакет, і лише він дешифрується та відтворюється.
+// compact - стиснутий заголовок, інакше hdr повний і data починається з опису
+static void audio_rx(pkt_header_t *hdr, const pkt_compact_t *compact, uint8_t *data, size_t len,
+                     const struct sockaddr_in *from, uint32_t now_ms)
+{
+    pkt_audio_desc_t desc;
+    peer_t *peer = peer_table_find(&peers, hdr->node);
+    replay_node_t *sender = replay_table_find(&replays, hdr->node);
+
+    // Без маяка невідомий запуск відправника: ні вікна повторів, ні тегу
+    if (sender == NULL) {
+        unknown_senders++;
+        return;
+    }
+    if (compact != NULL) {
+        if (peer == NULL || !hdr_comp_rx_expand(&peer->hdr_ctx, compact, now_ms, hdr, &desc)) {
+            return; // Чекаємо на повний заголовок
+        }
+    } else {
+        if (!pkt_read_audio_desc(data, len, &desc)) {
+            return;
+        }
+        data += PKT_AUDIO_DESC_SIZE;
+        len -= PKT_AUDIO_DESC_SIZE;
+    }
+
+    size_t frame_bytes = UDP_BUFFER_SIZE >> desc.decim_shift;
+    size_t body_len = frame_bytes * desc.frames;
+    size_t audio_len = body_len * (desc.fec ? 2 : 1);
+    if (audio_len > UDP_BUFFER_SIZE || len < audio_len + PKT_AUDIO_MAC_SIZE) {
+        ESP_LOGE(TAG, "Dropped malformed audio packet: %d bytes", (int)len);
+        return;
+    }
+    len -= PKT_AUDIO_MAC_SIZE;
+
+    // Повтор відкидається порівнянням з вікном, без жодної криптографії
+    if (replay_check(&sender->audio, hdr->seq, hdr->timestamp) != REPLAY_OK) {
+        replay_drops++;
+        return;
+    }
+    const keyx_key_t *key = &group_key;
+    if (desc.key == PKT_AUDIO_KEY_PHASE0 || desc.key == PKT_AUDIO_KEY_PHASE1) {
+        key = peer != NULL ? keyx_peer_lookup(&peer->keys, desc.key) : NULL;
+        if (key == NULL) {
+            return; // Ключа відправника ще немає - автентифікувати нічим
+        }
+    }
+    uint32_t boot_id = sender->boot_id;
+    if (!audio_tag_ok(key, hdr, boot_id, &desc, data, audio_len, len, data + len)) {
+        auth_failures++;
+        return;
+    }
+
+    peer = peer_table_touch(&peers, hdr->node, from, now_ms);
+    replay_accept(&sender->audio, hdr->seq, hdr->timestamp);
+    sender->last_ms = now_ms;
+    hdr_comp_rx_update(&peer->hdr_ctx, hdr, now_ms);
+    if (key != &group_key) {
+        key = keyx_peer_confirm(&peer->keys, key, hdr->seq);
+    }
+    if (hdr->group != PKT_GROUP_ANY) {
+        peer->channel = hdr->group;
+    }
+    link_stats_on_packet(&peer->stats, hdr, now_ms);
+
+    // Службові повідомлення в хвості - незалежно від того, чи відтворюватиметься звук
+    const uint8_t *item = data + audio_len;
+    const uint8_t *item_data;
+    size_t item_left = len - audio_len;
+    uint8_t item_type;
+    uint8_t item_len;
+    while (pkt_next_trailer_item(&item, &item_left, &item_type, &item_data, &item_len)) {
+        handle_control(peer, hdr, item_type, item_data, item_len, now_ms);
+    }
+    len = audio_len;
+    link_stats_on_audio(&peer->stats, hdr, now_ms);
+    if (hdr->group == channels.tx) {
+        floor_ctl_on_audio(&floor_ctl, hdr->node, now_ms);
+    }
+    peer->last_audio_ms = now_ms;
+    last_receive_ms = now_ms; // Оновлюємо час останнього отримання даних
+
+    // Запізнілий пакет вже не потрібен
+    int16_t seq_delta = (int16_t)(hdr->seq - peer->last_rx_seq);
+    if (peer->rx_seq_valid && seq_delta <= 0) {
+        return;
+    }
+
+    // Динамік зайнятий іншим каналом - далі не дешифруємо
+    if (!channel_accept_audio(&channels, hdr->group, now_ms)) {
+        peer->last_rx_seq = hdr->seq;
+        peer->rx_seq_valid = true;
+        return;
+    }
+
+    // Режим - з пакета: відправник міг перемкнутись посеред потоку
+    bool encrypted = desc.key != PKT_AUDIO_KEY_NONE;
+    if (!crypto_mode_rx_accept(&crypto, encrypted)) {
+        peer->last_rx_seq = hdr->seq;
+        peer->rx_seq_valid = true;
+        return;
+    }
+
+    // Дешифрування даних груповим ключем або ключем відправника
+    audio_open_frames(key, hdr, boot_id, &desc, data, rx_body, len);
+
+    receiving_data = true;
+
+    // Втрачено рівно один пакет - програємо його копію з FEC
+    if (desc.fec && peer->rx_seq_valid && seq_delta == 2) {
+        play_frames(rx_body + body_len, &desc);
+    }
+    play_frames(rx_body, &desc);
+
+    peer->last_rx_seq = hdr->seq;
+    peer->rx_seq_valid = true;
+}
+
+// Службовий пакет окремою датаграмою: тег груповим ключем і вікно повторів
+// відправника - до того, як пакет торкнеться таблиці сусідів. Маяк приносить
+// запуск відправника сам і лише він заводить або перемикає його вікна; решта
+// без маяка відкидається. Повертає true, якщо пакет справжній і свіжий, тоді
+// *len - довжина навантаження без тегу, а для маяка *beacon заповнено
+static bool control_rx(const pkt_header_t *hdr, const uint8_t *data, size_t *len,
+                       pkt_beacon_t *beacon, uint32_t now_ms)
+{
+    replay_node_t *sender = replay_table_find(&replays, hdr->node);
+    replay_t *window = NULL;
+    uint32_t boot_id;
+
+    if (*len < PKT_CONTROL_MAC_SIZE) {
+        return false;
+    }
+    size_t payload_len = *len - PKT_CONTROL_MAC_SIZE;
+
+    if (hdr->type == PKT_TYPE_BEACON) {
+        if (!pkt_read_beacon(data, payload_len, beacon)) {
+            return false;
+        }
+        boot_id = beacon->boot_id;
+        replay_boot_t boot = replay_table_check_boot(&replays, hdr->node, boot_id);
+        if (boot == REPLAY_BOOT_STALE) {
+            replay_drops++;
+            return false;
+        }
+        if (boot == REPLAY_BOOT_SAME) {
+            window = &sender->beacon;
+        }
+    } else if (hdr->type == PKT_TYPE_REPORT || hdr->type == PKT_TYPE_FLOOR || hdr->type == PKT_TYPE_KEY) {
+        if (sender == NULL) {
+            unknown_senders++;
+            return false;
+        }
+        boot_id = sender->boot_id;
+        window = &sender->control;
+    } else {
+        return false;
+    }
+
+    if (window != NULL && replay_check(window, hdr->seq, hdr->timestamp) != REPLAY_OK) {
+        replay_drops++;
+        return false;
+    }
+    if (!control_tag_ok(hdr, boot_id, data, payload_len, data + payload_len)) {
+        auth_failures++;
+        return false;
+    }
+
+    if (hdr->type == PKT_TYPE_BEACON) {
+        sender = replay_table_set_boot(&replays, hdr->node, boot_id, now_ms);
+        window = &sender->beacon;
+    }
+    replay_accept(window, hdr->seq, hdr->timestamp);
+    sender->last_ms = now_ms;
+    *len = payload_len;
+    return true;
+}
+
+// Обробка отриманого пакета
+static void audio_rx_handler(void *ctx, uint8_t *packet, size_t packet_len, const struct sockaddr_in *from)
+{
+    pkt_header_t hdr;
+    pkt_compact_t compact;
+    bool is_compact = false;
+    size_t hdr_len = PKT_HEADER_SIZE;
+    uint32_t now_ms = net_now_ms();
+
+    if (pkt_read_compact(packet, packet_len, &compact)) {
+        // Для фільтрів вистачає полів, що йдуть як є, решта - з контексту відправника
+        is_compact = true;
+        hdr_len = PKT_COMPACT_SIZE;
+        hdr.node = compact.node;
+        hdr.group = compact.group;
+    } else if (!pkt_read_header(packet, packet_len, &hdr)) {
+        return; // Не наш формат пакета
+    }
+    if (hdr.node == node_id) {
+        return; // Власний широкомовний пакет
+    }
+    // Пакети каналів без підписки відкидаємо до будь-якої обробки: один біт маски
+    if (hdr.group != PKT_GROUP_ANY && !channel_subscribed(&channels, hdr.group)) {
+        channels.unsubscribed++;
+        return;
+    }
+
+    uint8_t *data = packet + hdr_len;
+    size_t len = packet_len - hdr_len;
+
+    if (is_compact || hdr.type == PKT_TYPE_AUDIO) {
+        audio_rx(&hdr, is_compact ? &compact : NULL, data, len, from, now_ms);
+        return;
+    }
+
+    pkt_beacon_t beacon;
+    if (!control_rx(&hdr, data, &len, &beacon, now_ms)) {
+        return;
+    }
+    peer_t *peer = peer_table_touch(&peers, hdr.node, from, now_ms);
+    if (hdr.group != PKT_GROUP_ANY) {
+        peer->channel = hdr.group;
+    }
+    link_stats_on_packet(&peer->stats, &hdr, now_ms);
+
+    if (hdr.type == PKT_TYPE_REPORT || hdr.type == PKT_TYPE_FLOOR || hdr.type == PKT_TYPE_KEY) {
+        handle_control(peer, &hdr, hdr.type, data, len, now_ms);
+        return;
+    }
+    if (hdr.type == PKT_TYPE_BEACON) {
+        if (discovery_on_beacon(&discovery, peer, &beacon, now_ms)) {
+            ESP_LOGI(TAG, "Discovered %04x at %s, %u Hz, caps 0x%02x", hdr.node,
+                     inet_ntoa(from->sin_addr), beacon.sample_rate, beacon.caps);
+            boot_signal(BOOT_PEER_KNOWN, "peer discovered");
+            if (!peer_known) {
+                select_unicast_peer();
+            }
+        }
+        update_crypto_mode(); // Вимогу шифрування виконуємо з наступного ж пакета
+    }
+}
+
+// Заголовок (стиснутий, коли можна), опис, кадри (зашифровані, якщо так
+// узгоджено, ключем відправника або груповим), службові повідомлення, що чекають,
+// і тег автентифікації тим самим ключем в send_buf.
+// fec - копія кадрів попереднього пакета, якщо desc->fec. Повертає довжину пакета
+static size_t build_audio_packet(const pkt_audio_desc_t *desc, uint8_t *body, size_t body_len, uint8_t *fec, uint32_t timestamp)
+{
+    pkt_header_t hdr = {
+        .type = PKT_TYPE_AUDIO,
+        .group = channels.tx,
+        .node = node_id,
+        .seq = audio_seq++,
+        .timestamp = timestamp
+    };
+    // Новий ключ відправника вмикається лише тут, на межі пакетів
+    const keyx_key_t *key = keyx_tx_packet_key(&tx_keys, hdr.seq, timestamp);
+    bool encrypted = crypto_mode_tx_encrypted(&crypto);
+    if (key == NULL || !encrypted) {
+        key = &group_key;
+    }
+    pkt_audio_desc_t d = *desc;
+    if (!encrypted) {
+        d.key = PKT_AUDIO_KEY_NONE;
+    } else {
+        d.key = key != &group_key ? keyx_key_code(key) : PKT_AUDIO_KEY_GROUP;
+    }
+    size_t hdr_len = hdr_comp_write(&tx_comp, send_buf, &hdr, &d);
+    size_t len = hdr_len;
+
+    // Шифрування даних у режимі, записаному в пакеті
+    size_t audio_len = desc->fec ? body_len * 2 : body_len;
+    audio_seal_frames(key, &hdr, discovery.local.boot_id, &d, body, fec, body_len, send_buf + len);
+    len += audio_len;
+    len += piggyback_write(send_buf + len, net_now_ms());
+    audio_tag(key, &hdr, discovery.local.boot_id, &d, send_buf + hdr_len, audio_len, len - hdr_len, send_buf + len);
+    return len + PKT_AUDIO_MAC_SIZE;
+}
+
+// Канал для аудіо: мережа піднята і співрозмовник відомий. Веде облік перерв
+static bool link_watch(uint32_t now_ms)
+{
+#ifdef IS_SERVER
+    bool up = peer_known;
+#else
+    bool up = got_ip && peer_known;
+#endif
+    if (reconnect_stats_update(&outage, up, now_ms)) {
+        if (!up) {
+            ESP_LOGW(TAG, "Link down, buffering up to %d ms of audio", AUDIO_BACKLOG_FRAMES * AUDIO_FRAME_MS);
+        } else if (outage.recovering) {
+            ESP_LOGI(TAG, "Link restored after %" PRIu32 " ms, %d frames buffered", outage.last_outage_ms, backlog.count);
+        }
+    }
+    return up;
+}
+
+// Відправка накопиченого за перерву: на кожен живий кадр - пакет з кількох
+// збережених, тож відставання від живого звуку скорочується, доки буфер не спорожніє
+static void flush_backlog(uint32_t now_ms)
+{
+    audio_backlog_expire(&backlog, now_ms, AUDIO_BACKLOG_MAX_AGE_MS);
+
+    int n = backlog.count < AUDIO_BACKLOG_BURST_FRAMES ? backlog.count : AUDIO_BACKLOG_BURST_FRAMES;
+    if (n == 0) {
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        memcpy(backlog_body + i * AUDIO_BACKLOG_FRAME_BYTES, audio_backlog_peek(&backlog, i), AUDIO_BACKLOG_FRAME_BYTES);
+    }
+    pkt_audio_desc_t desc = {
+        .decim_shift = AUDIO_BACKLOG_DECIM_SHIFT,
+        .frames = n,
+        .fec = false
+    };
+
+    // Мітка часу відправки, а не захоплення: старі мітки спотворили б у
+    // приймача оцінку джиттера, а в нас - RTT і рівень якості
+    size_t len = build_audio_packet(&desc, backlog_body, n * AUDIO_BACKLOG_FRAME_BYTES, NULL, now_ms);
+    if (net_engine_send(&net, send_buf, len, &tx_dest)) {
+        audio_backlog_pop(&backlog, n);
+    }
+}
+
+#ifdef RELAY_NODE
+// Пересилання пакета в інший сегмент на його широкомовну адресу прямо з буфера
+// прийому, в тому ж проході циклу: затримка на перехід - лише sendto()
+static void relay_rx_handler(void *ctx, uint8_t *packet, size_t packet_len, const struct sockaddr_in *from)
+{
+    struct sockaddr_in dest = *from;
+    uint32_t sta_bcast = relay_sta_bcast;
+
+    if (sta_bcast == 0 || !forwarder_accept(&forwarder, packet, packet_len, net_now_ms())) {
+        return;
+    }
+    if ((from->sin_addr.s_addr & relay_ap_mask) == relay_ap_net) {
+        dest.sin_addr.s_addr = sta_bcast;                     // Зі своєї точки доступу - вгору
+    } else {
+        dest.sin_addr.s_addr = relay_ap_net | ~relay_ap_mask; // Згори - у свою підмережу
+    }
+    dest.sin_port = htons(PORT);
+    if (!net_engine_send_now(&net, packet, packet_len, &dest)) {
+        relay_send_drops++;
+    }
+}
+#endif
+
+// Один захоплений кадр: в накопичене за перерву або в пакет поточного рівня якості
+static void audio_tx_frame(mic_frame_t *f, bool link_up)
+{
+    size_t samples = UDP_BUFFER_SIZE / 2;
+    uint32_t capture_ms = f->capture_ms; // Мітка часу захоплення для дедлайну відправки
+
+    // Підсилюємо сигнал
+    amplify_signal((int16_t *)f->pcm, samples, 10.0f); // Підсилюємо в 10 разів
+
+    // Фільтруємо сигнал
+    //high_pass_filter((int16_t *)f->pcm, samples, 0.9f);
+
+    // Каналу немає або накопичене ще не відправлене - кадр стає в чергу за ним,
+    // щоб звук ішов по порядку
+    if (!link_up || !audio_backlog_empty(&backlog)) {
+        decimate_frame((int16_t *)f->pcm, samples, AUDIO_BACKLOG_DECIM_SHIFT,
+                       (int16_t *)audio_backlog_push(&backlog, capture_ms));
+        tx_frames = 0;
+        fec_len = 0;
+        return;
+    }
+
+    // Зміна рівня якості: незавершений пакет і копія для FEC вже в іншому форматі
+    const rate_level_t *lvl = rate_ctl_level(&rate_ctl);
+    if (lvl != tx_level) {
+        tx_level = lvl;
+        tx_frames = 0;
+        fec_len = 0;
+    }
+
+    size_t frame_bytes = UDP_BUFFER_SIZE >> lvl->decim_shift;
+    if (tx_frames == 0) {
+        tx_first_capture_ms = capture_ms;
+    }
+    decimate_frame((int16_t *)f->pcm, samples, lvl->decim_shift, (int16_t *)(tx_body + tx_frames * frame_bytes));
+    tx_frames++;
+    if (tx_frames < lvl->frames_per_packet) {
+        return;
+    }
+    size_t body_len = tx_frames * frame_bytes;
+
+    // Заголовок з номером і міткою часу захоплення першого кадру
+    pkt_audio_desc_t desc = {
+        .decim_shift = lvl->decim_shift,
+        .frames = tx_frames,
+        .fec = lvl->fec && fec_len == body_len
+    };
+    size_t len = build_audio_packet(&desc, tx_body, body_len, fec_body, tx_first_capture_ms);
+
+    memcpy(fec_body, tx_body, body_len);
+    fec_len = body_len;
+    tx_frames = 0;
+
+    // Постановка кадру в чергу на відправку
+    if (!net_engine_send_stamped(&net, send_buf, len, &tx_dest, tx_first_capture_ms)) {
+        ESP_LOGE(TAG, "Frame too large for TX queue");
+    }
+}
+
+// Відправка захопленого, викликається кожні AUDIO_FRAME_MS. З I2S не читає:
+// кадри вже в черзі від задачі мікрофона, тож таймер не блокує select()
+static void audio_capture_timer(void *ctx, uint32_t now_ms)
+{
+    bool link_up = link_watch(now_ms);
+
+    piggyback_flush(now_ms);
+
+    if (link_up && !audio_backlog_empty(&backlog)) {
+        flush_backlog(now_ms);
+    }
+    if (link_up && audio_backlog_empty(&backlog) && reconnect_stats_resumed(&outage, now_ms)) {
+        ESP_LOGI(TAG, "Audio live again %" PRIu32 " ms after reconnect", outage.last_recovery_ms);
+    }
+
+    if (!transmit_data) {
+        // Захоплене до втрати слова вже не відправляється
+        xQueueReset(mic_queue);
+        tx_frames = 0;
+        fec_len = 0;
+        return;
+    }
+    // Зазвичай один кадр; після затримки циклу - всі, що встигли накопичитись
+    while (xQueueReceive(mic_queue, &mic_frame, 0) == pdTRUE) {
+        audio_tx_frame(&mic_frame, link_up);
+    }
+}
+
+// Періодичний звіт про втрати на стороні відправника
+static void net_stats_timer(void *ctx, uint32_t now_ms)
+{
+    static uint32_t last_misses = 0;
+    static uint32_t last_overflows = 0;
+    static uint32_t last_errors = 0;
+    static uint32_t last_outages = 0;
+    static uint32_t last_auth_failures = 0;
+    static uint32_t last_replay_drops = 0;
+    static uint32_t last_unknown_senders = 0;
+    static uint32_t last_plain_rejected = 0;
+    static uint32_t last_play_overruns = 0;
+    static uint32_t last_mic_overruns = 0;
+
+#ifdef RELAY_NODE
+    ESP_LOGI(TAG, "Relay: forwarded %" PRIu32 ", duplicates %" PRIu32 ", hop limited %" PRIu32 ", send drops %" PRIu32,
+             forwarder.forwarded, forwarder.duplicates, forwarder.hop_limited, relay_send_drops);
+#endif
+
+    if (channels.unsubscribed > 0 || channels.busy > 0) {
+        ESP_LOGI(TAG, "Channel %d: dropped %" PRIu32 " unsubscribed, %" PRIu32 " busy, %" PRIu32 " priority preemptions",
+                 channels.tx, channels.unsubscribed, channels.busy, channels.preemptions);
+        channels.unsubscribed = 0;
+        channels.busy = 0;
+    }
+
+    if (net.tx_deadline_misses != last_misses || net.tx_overflows != last_overflows || net.tx_errors != last_errors) {
+        ESP_LOGW(TAG, "TX sent %" PRIu32 ", deadline misses %" PRIu32 ", overflows %" PRIu32 ", errors %" PRIu32,
+                 net.tx_sent, net.tx_deadline_misses, net.tx_overflows, net.tx_errors);
+        last_misses = net.tx_deadline_misses;
+        last_overflows = net.tx_overflows;
+        last_errors = net.tx_errors;
+    }
+
+    if (tx_comp.compact_sent > 0) {
+        ESP_LOGI(TAG, "Audio headers: %" PRIu32 " compact, %" PRIu32 " full; %" PRIu32 " packets carried control messages",
+                 tx_comp.compact_sent, tx_comp.full_sent, piggyback_packets);
+    }
+
+    if (audio_enc.batches > 0 || audio_dec.batches > 0) {
+        ESP_LOGI(TAG, "Audio AES: encrypt %" PRIu32 " calls/%" PRIu32 " blocks, decrypt %" PRIu32 " calls/%" PRIu32 " blocks, key loads %" PRIu32,
+                 audio_enc.batches, audio_enc.blocks, audio_dec.batches, audio_dec.blocks,
+                 audio_enc.key_loads + audio_dec.key_loads);
+    }
+
+    if (mac_keys.key_loads > 0) {
+        ESP_LOGI(TAG, "Packet MAC: %" PRIu32 " tags with cached keys, %" PRIu32 " key loads",
+                 mac_keys.hits, mac_keys.key_loads);
+    }
 
+    if (tx_keys.cur.valid) {
+        ESP_LOGI(TAG, "Sender key %u %s since packet %u, %" PRIu32 " rekeys",
+                 tx_keys.cur.id, tx_keys.active ? "in use" : "pending, group key in use", tx_keys.switch_seq, tx_keys.rekeys);
+    }
+
+    if (play_overruns != last_play_overruns) {
+        ESP_LOGW(TAG, "Speaker queue full, %" PRIu32 " frames dropped", play_overruns);
+        last_play_overruns = play_overruns;
+    }
+    if (mic_overruns != last_mic_overruns) {
+        ESP_LOGW(TAG, "Microphone queue full, %" PRIu32 " frames dropped", mic_overruns);
+        last_mic_overruns = mic_overruns;
+    }
+
+    if (auth_failures != last_auth_failures || replay_drops != last_replay_drops ||
+        crypto.plain_rejected != last_plain_rejected || unknown_senders != last_unknown_senders) {
+        ESP_LOGW(TAG, "Rejected packets: %" PRIu32 " failed authentication, %" PRIu32 " replayed (%" PRIu32 " old boots), "
+                 "%" PRIu32 " from unknown senders, %" PRIu32 " plaintext; %" PRIu32 " peer restarts",
+                 auth_failures, replay_drops, replays.stale_boots, unknown_senders, crypto.plain_rejected,
+                 discovery.restarted);
+        last_auth_failures = auth_failures;
+        last_replay_drops = replay_drops;
+        last_plain_rejected = crypto.plain_rejected;
+        last_unknown_senders = unknown_senders;
+    }
+
+    if (outage.outages != last_outages) {
+        ESP_LOGI(TAG, "Outages %" PRIu32 ": last %" PRIu32 " ms, max %" PRIu32 " ms, total %" PRIu32 " ms; "
+                 "recovery last %" PRIu32 " ms, max %" PRIu32 " ms; backlog sent %" PRIu32 ", overwritten %" PRIu32 ", expired %" PRIu32,
+                 outage.outages, outage.last_outage_ms, outage.max_outage_ms, outage.total_outage_ms,
+                 outage.last_recovery_ms, outage.max_recovery_ms, backlog.sent, backlog.overwritten, backlog.expired);
+        last_outages = outage.outages;
+    }
+
+    link_summary_t summary;
+    walkie_get_link_summary(&summary);
+    if (summary.valid) {
+        ESP_LOGI(TAG, "Link: rx %" PRIu32 " lost %" PRIu32 " jitter %" PRIu32 " ms, peer lost %" PRIu32 ", rtt %" PRIu32 " ms",
+                 summary.rx_received, summary.rx_lost, summary.rx_jitter_ms, summary.tx_lost, summary.rtt_ms);
+    }
+}
+
+static void send_report(link_stats_t *ls, const struct sockaddr_in *dest, uint32_t now_ms)
+{
+    uint8_t payload[PKT_REPORT_SIZE];
+    pkt_report_t report;
+
+    // Під час передачі тому ж адресату звіт поїде з аудіо
+    if (transmit_data && piggyback_report == NULL && same_dest(dest, &tx_dest)) {
+        if (piggyback_len == 0) {
+            piggyback_since_ms = now_ms;
+        }
+        piggyback_report = ls;
+        return;
+    }
+    link_stats_build_report(ls, now_ms, &report);
+    send_control(PKT_TYPE_REPORT, payload, pkt_write_report(payload, &report), dest, now_ms);
+}
+
+// Періодичні звіти кожному відомому пристрою про якість його потоку
+static void link_report_timer(void *ctx, uint32_t now_ms)
+{
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        peer_t *p = &peers.peers[i];
+        if (p->used) {
+            send_report(&p->stats, &p->addr, now_ms);
+        }
+    }
+
+    update_rate_level();
+    publish_link_summary();
+}
+
+// Маяки присутності з поточними можливостями і видалення зниклих пристроїв
+static void discovery_timer(void *ctx, uint32_t now_ms)
+{
+    // Вибір кнопкою інші дізнаються одразу, а не з наступним маяком
+    if (crypto_mode_set_local(&crypto, encryption_enabled)) {
+        discovery_kick(&discovery);
+        ESP_LOGI(TAG, "Encryption %s locally", crypto.local ? "required" : "not required");
+    }
+    discovery.local.caps = PKT_CAP_AES | PKT_CAP_FEC | PKT_CAP_FLOOR | PKT_CAP_KEYX | (crypto.local ? PKT_CAP_ENCRYPTED : 0);
+    discovery.local.max_decim_shift = rate_levels[RATE_LEVEL_COUNT - 1].decim_shift;
+    discovery.local.rate_level = rate_ctl.level;
+    discovery.local.sample_rate = SAMPLE_RATE;
+
+    if (discovery_tick(&discovery, now_ms) > 0 && peer_known && peer_table_find(&peers, peer_node) == NULL) {
+        select_unicast_peer();
+    }
+    update_crypto_mode();
+    keyx_update(now_ms);
+}
+
+// Перехід на канал, обраний кнопкою. Право голосу на старому каналі втрачається
+static void apply_channel(uint8_t ch)
+{
+    channel_set_t *cs = &channels;
+
+    if (ch == cs->tx) {
+        return;
+    }
+    uint8_t old = cs->tx;
+    channel_set_tx(cs, ch);
+    discovery.group = ch;
+    discovery_kick(&discovery); // Інші дізнаються про новий канал одразу
+    floor_ctl_init(&floor_ctl, node_id, FLOOR_PRIORITY);
+    tx_channel = ch;
+    ESP_LOGI(TAG, "Talking on channel %d (was %d), subscriptions 0x%08" PRIx32, ch, old, cs->subscribed);
+}
+
+// Кнопка PTT і тайм-аути права голосу
+static void floor_timer(void *ctx, uint32_t now_ms)
+{
+    uint8_t ch = requested_channel;
+    if (ch != 0) {
+        requested_channel = 0;
+        apply_channel(ch);
+    }
+
+    int peer_count = known_peers();
+
+    if (ptt_pressed && !floor_ctl.want) {
+        floor_ctl_press(&floor_ctl, now_ms, peer_count);
+    } else if (!ptt_pressed && floor_ctl.want) {
+        floor_ctl_release(&floor_ctl, now_ms);
+    }
+    floor_ctl_tick(&floor_ctl, now_ms, peer_count);
+    floor_update(now_ms);
+}
+
+// Прийом закінчився, якщо дані давно не надходили. Тишу в динамік пише його задача
+static void rx_timeout_timer(void *ctx, uint32_t now_ms)
+{
+    if ((int32_t)(now_ms - last_receive_ms) >= RX_SILENCE_TIMEOUT_MS) {
+        receiving_data = false;
+    }
+}
+
+// Задача динаміка: єдине місце, де пишемо в I2S, тож блокуючий запис не
+// затримує таймери мережевої задачі. Тиша пишеться один раз і лише тоді,
+// коли кадри справді перестали надходити, а не за кожним таймером
+void speaker_task(void *pvParameters)
+{
+    static uint8_t frame[UDP_BUFFER_SIZE];
+    size_t write_bytes = 0;
+    bool idle = true;
+
+    boot_wait(BOOT_I2S_READY, portMAX_DELAY);
+    while (1) {
+        // Простоюючий динамік чекає на перший кадр без обмеження
+        TickType_t wait = idle ? portMAX_DELAY : pdMS_TO_TICKS(RX_SILENCE_TIMEOUT_MS);
+        if (xQueueReceive(play_queue, frame, wait) == pdTRUE) {
+            idle = false;
+            if (i2s_channel_write(tx_chan, frame, UDP_BUFFER_SIZE, &write_bytes, portMAX_DELAY) != ESP_OK) {
+                ESP_LOGE(TAG, "i2s write failed");
+            }
+            continue;
+        }
+
+        // Кадрів немає RX_SILENCE_TIMEOUT_MS - виштовхуємо залишки звуку тишею
+        memset(frame, 0, sizeof(frame));
+        for (int i = 0; i < SILENCE_FRAMES; i++) {
+            if (i2s_channel_write(tx_chan, frame, UDP_BUFFER_SIZE, &write_bytes, portMAX_DELAY) != ESP_OK) {
+                ESP_LOGE(TAG, "i2s write failed");
+                break;
+            }
+        }
+        idle = true;
+    }
+}
+
+// Задача мікрофона: єдине місце, де читаємо з I2S, тож блокуюче читання не
+// затримує таймери мережевої задачі. Без передачі не читає, як і раніше
+void mic_task(void *pvParameters)
+{
+    static mic_frame_t frame;
+    size_t read_bytes = 0;
+
+    boot_wait(BOOT_I2S_READY, portMAX_DELAY);
+    while (1) {
+        if (!transmit_data) {
+            vTaskDelay(pdMS_TO_TICKS(AUDIO_FRAME_MS));
+            continue;
+        }
+        if (i2s_channel_read(rx_chan, frame.pcm, UDP_BUFFER_SIZE, &read_bytes, portMAX_DELAY) != ESP_OK ||
+            read_bytes != UDP_BUFFER_SIZE) {
+            ESP_LOGE(TAG, "i2s read failed");
+            continue;
+        }
+        frame.capture_ms = net_now_ms();
+
+        // Кадр - мережевій задачі; черга повна - мережа відстає, кадр відкидається
+        if (xQueueSend(mic_queue, &frame, 0) != pdTRUE) {
+            mic_overruns++;
+        }
+    }
+}
+
+// Єдина мережева задача: прийом, відправка та таймери в одному циклі select()
+void udp_task(void *pvParameters)
+{
+    uint8_t mac[6];
+
+    // Захоплення звуку починається з першим таймером - I2S має бути готовий
+    boot_wait(BOOT_I2S_READY, portMAX_DELAY);
+
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    node_id = (uint16_t)((mac[4] << 8) | mac[5]);
+
+    // Широкомовна відправка потрібна маякам у будь-якому режимі
+#if defined(TALK_GROUP_MODE)
+    int net_opts = NET_OPT_BROADCAST | NET_OPT_REUSE;
+#else
+    int net_opts = NET_OPT_BROADCAST;
+#endif
+    if (net_engine_init(&net, PORT, net_opts) < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    // Адреса співрозмовника стане відома з маяка
+    peer_addr.sin_family = AF_INET;
+    peer_addr.sin_port = htons(PORT);
+    peer_addr.sin_addr.s_addr = inet_addr(DISCOVERY_IP_ADDR);
+
+    tx_dest = peer_addr;
+#if defined(TALK_GROUP_BROADCAST)
+    tx_dest.sin_addr.s_addr = inet_addr(BROADCAST_IP_ADDR);
+#elif defined(TALK_GROUP_MULTICAST)
+    tx_dest.sin_addr.s_addr = inet_addr(MULTICAST_IP_ADDR);
+    if (net_engine_join_multicast(&net, tx_dest.sin_addr.s_addr) < 0) {
+        ESP_LOGE(TAG, "Unable to join multicast group: errno %d", errno);
+    }
+#endif
+    channel_init(&channels, TALK_GROUP_ID, PRIORITY_CHANNEL, CHANNEL_SUBSCRIBE_MASK);
+    ESP_LOGI(TAG, "Node %04x, channel %d, priority channel %d", node_id, TALK_GROUP_ID, PRIORITY_CHANNEL);
+
+#ifdef TALK_GROUP_MODE
+    peer_known = true; // Аудіо йде всій групі, окремий співрозмовник не потрібен
+    boot_signal(BOOT_PEER_KNOWN, "talk group joined");
+#endif
+
+#ifdef RELAY_NODE
+    // Ретранслятор не має власного аудіо: лише пересилання і статистика
+    forwarder_init(&forwarder, FORWARDER_MAX_HOPS);
+    net_engine_set_rx(&net, relay_rx_handler, NULL);
+    net_engine_add_timer(&net, NET_STATS_PERIOD_MS, net_stats_timer, NULL);
+    ESP_LOGI(TAG, "Relay node, up to %d hops", FORWARDER_MAX_HOPS);
+    net_engine_run(&net);
+
+    ESP_LOGE(TAG, "select failed: errno %d", errno);
+    net_engine_close(&net);
+    vTaskDelete(NULL);
+    return;
+#endif
+
+    last_receive_ms = net_now_ms();
+    peer_table_init(&peers);
+    rate_ctl_init(&rate_ctl, NULL);
+    floor_ctl_init(&floor_ctl, node_id, FLOOR_PRIORITY);
+    discovery_init(&discovery, &net, &peers, &tx_dest, channels.tx, node_id);
+    audio_backlog_init(&backlog);
+    hdr_comp_tx_init(&tx_comp);
+    keyx_tx_init(&tx_keys);
+    reconnect_stats_init(&outage);
+
+    // Груповий ключ з похідним ключем автентифікації. Новий ідентифікатор запуску
+    // в маяках скидає у співрозмовників вікно повторів і обмін ключами з нами
+    mac_cache_init(&mac_keys);
+    memcpy(group_key.key, aes_key, AES_KEY_SIZE);
+    derive_mac_key(group_key.mac_key, aes_key);
+    group_key.valid = true;
+    crypto_mode_init(&crypto, encryption_enabled);
+    aes_batch_init(&audio_enc);
+    aes_batch_init(&audio_dec);
+    discovery.local.boot_id = esp_random() | 1;
+    discovery_set_seal(&discovery, beacon_seal, NULL);
+    replay_table_init(&replays);
+    audio_seq = (uint16_t)esp_random(); // Як у RTP: номери з нового запуску не повторюють старі
+
+    net_engine_set_rx(&net, audio_rx_handler, NULL);
+    net_engine_set_tx_deadline(&net, TX_DEADLINE_MS);
+    net_engine_add_timer(&net, AUDIO_FRAME_MS, audio_capture_timer, NULL);
+    net_engine_add_timer(&net, RX_SILENCE_TIMEOUT_MS, rx_timeout_timer, NULL);
+    net_engine_add_timer(&net, LINK_REPORT_PERIOD_MS, link_report_timer, NULL);
+    net_engine_add_timer(&net, NET_STATS_PERIOD_MS, net_stats_timer, NULL);
+    net_engine_add_timer(&net, FLOOR_TICK_MS, floor_timer, NULL);
+    net_engine_add_timer(&net, DISCOVERY_TICK_MS, discovery_timer, NULL);
+
+    net_engine_run(&net);
+
+    ESP_LOGE(TAG, "select failed: errno %d", errno);
+    net_engine_close(&net);
+    vTaskDelete(NULL);
+}
+
+// Конфігурація I2S каналу для приймання (RX) даних
+void microphone_init(void)  
+{
+    i2s_chan_config_t rx_chan_cfg  = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_RX, I2S_ROLE_MASTER);
+    ESP_ERROR_CHECK(i2s_new_channel(&rx_chan_cfg , NULL, &rx_chan));
+    
+    i2s_std_config_t rx_std_cfg  = 
+    {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg =
+        {
+            .mclk = I2S_GPIO_UNUSED, 
+            .bclk = I2S_SCL_RX,
+            .ws = I2S_WS_RX,
+            .dout = I2S_GPIO_UNUSED,
+            .din = I2S_SD_RX,
+            .invert_flags =
+            {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        }
+    };
+
+    ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_chan, &rx_std_cfg ));
+    ESP_ERROR_CHECK(i2s_channel_enable(rx_chan));
+}
+
+// Конфігурація I2S каналу для передавання (TX) даних
+void speaker_init(void)
+{
+    i2s_chan_config_t tx_chan_cfg  = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_TX, I2S_ROLE_MASTER);
+    ESP_ERROR_CHECK(i2s_new_channel(&tx_chan_cfg, &tx_chan, NULL));
+    
+    i2s_std_config_t tx_std_cfg  = 
+    {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg =
+        {
+            .mclk = I2S_GPIO_UNUSED, 
+            .bclk = I2S_SCK_TX,
+            .ws = I2S_WS_TX,
+            .dout = I2S_DATA_OUT_TX,
+            .din = -1
+        }
+    };
+
+
+    ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_chan, &tx_std_cfg ));
+    ESP_ERROR_CHECK(i2s_channel_enable(tx_chan));
+}
+
+#ifdef IS_SERVER
+#define DEVICE_ROLE "SERVER"
+#else
+#define DEVICE_ROLE "CLIENT"
+#endif
+
+// Фактичний режим передачі для рядка стану
+static const char *crypto_status_text(uint8_t status)
+{
+    switch (status) {
+    case CRYPTO_STATUS_ON:
+        return "ON";
+    case CRYPTO_STATUS_ON_PEER:
+        return "ON (peer)";
+    default:
+        return "OFF";
+    }
+}
+
+// Функція для управління дисплеєм ST7789
+void ST7789(void *pvParameters)
+{
+    // Шрифт вбудований у прошивку (United/fonts), файлова система не потрібна
+    FontxFile fx16G[2];
+    InitFontxMem(fx16G, "ILGH16XB", ""); // 8x16Dot Gothic
+
+    // Без шрифтів дисплей працювати не може, решта пристрою - може
+    if (!fx16G[0].valid) {
+        ESP_LOGE(TAG, "Font ILGH16XB is not embedded, display disabled");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    TFT_t dev;
+
+    // Ініціалізація дисплея
+    spi_master_init(&dev, CONFIG_MOSI_GPIO, CONFIG_SCLK_GPIO, CONFIG_CS_GPIO, CONFIG_DC_GPIO, CONFIG_RESET_GPIO, CONFIG_BL_GPIO);
+    lcdInit(&dev, CONFIG_WIDTH, CONFIG_HEIGHT, CONFIG_OFFSETX, CONFIG_OFFSETY);
+    boot_signal(BOOT_DISPLAY_READY, "display ready");
+
+    esp_rom_gpio_pad_select_gpio(BUTTON_GPIO);
+    gpio_set_direction(BUTTON_GPIO, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(BUTTON_GPIO, GPIO_PULLUP_ONLY);
+
+    char encryption_status[24];
+    char role_status[24];
+    char link_status[24] = "";
+    TickType_t last_link_update = 0;
+    status_view_t view;
+
+    // Екран малюється повністю лише перший раз, далі - тільки змінені рядки
+    status_view_init(&view, &dev, fx16G, CONFIG_WIDTH, CONFIG_HEIGHT, BLUE);
+    status_view_set(&view, STATUS_TITLE, "Walkie-Talkie", WHITE, BLUE);
+
+    while (1) {
+        // Статистика каналу оновлюється рідше, щоб рядок не мерехтів
+        TickType_t now_ticks = xTaskGetTickCount();
+        if (now_ticks - last_link_update >= pdMS_TO_TICKS(LINK_DISPLAY_PERIOD_MS)) {
+            link_summary_t summary;
+            last_link_update = now_ticks;
+            walkie_get_link_summary(&summary);
+            if (!summary.valid) {
+                link_status[0] = '\0';
+            } else if (summary.rtt_valid) {
+                snprintf(link_status, sizeof(link_status), "Loss %d%% RTT %dms",
+                         summary.rx_fraction_lost * 100 / 256, (int)summary.rtt_ms);
+            } else {
+                snprintf(link_status, sizeof(link_status), "Loss %d%%", summary.rx_fraction_lost * 100 / 256);
+            }
+        }
+
+        snprintf(encryption_status, sizeof(encryption_status), "Encryption: %s", crypto_status_text(crypto_status));
+        snprintf(role_status, sizeof(role_status), "%s  CH %d", DEVICE_ROLE, tx_channel);
+        status_view_set(&view, STATUS_ROLE, role_status, WHITE, BLUE);
+        status_view_set(&view, STATUS_CRYPTO, encryption_status, WHITE, BLUE);
+        status_view_set(&view, STATUS_LINK, link_status, WHITE, BLUE);
+
+        // Стан - смуга свого кольору навколо третього рядка
+        if (transmit_data && receiving_data) { // Повний дуплекс
+            status_view_set(&view, STATUS_STATE, "Full-Duplex", WHITE, PURPLE);
+        } else if (transmit_data) { // Передача даних
+            status_view_set(&view, STATUS_STATE, "Transmitting", WHITE, RED);
+        } else if (receiving_data) { // Прийом даних
+            status_view_set(&view, STATUS_STATE, "Receiving", WHITE, GREEN);
+        } else if (ptt_pressed) { // Чекаємо на слово
+            status_view_set(&view, STATUS_STATE, "Waiting", BLACK, YELLOW);
+        } else { // Бездіяльність
+            status_view_set(&view, STATUS_STATE, "", WHITE, BLUE);
+        }
+
+        // Перемальовуються лише змінені рядки
+        status_view_flush(&view);
+
+        vTaskDelay(pdMS_TO_TICKS(DISPLAY_POLL_MS));
+    }
+}
+
+void app_main(void)
+{
+    boot_init();
+    boot_mark("app_main");
+
+    // Ініціалізація NVS (Non-Volatile Storage)
+    ESP_ERROR_CHECK(nvs_flash_init());
+
+    // Ініціалізація мережевого інтерфейсу
+    ESP_ERROR_CHECK(esp_netif_init());
+
+    // Створення циклу обробки подій за замовчуванням
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+
+    // Задачі стартують одразу і чекають лише на свої залежності (boot.h):
+    // дисплей з вбудованим шрифтом - паралельно з мережею,
+    // мережева задача готова до прийому ще до отримання IP
+    keyx_jobs = xQueueCreate(PEER_TABLE_SIZE, sizeof(keyx_job_t));
+    keyx_results = xQueueCreate(PEER_TABLE_SIZE, sizeof(keyx_job_t));
+    play_queue = xQueueCreate(PLAY_QUEUE_LEN, UDP_BUFFER_SIZE);
+    mic_queue = xQueueCreate(MIC_QUEUE_LEN, sizeof(mic_frame_t));
     xTaskCreate(ST7789, "ST7789", 4096, NULL, 1, NULL);
+    xTaskCreate(udp_task, "udp_task", 4096, NULL, 2, NULL);
+#ifndef RELAY_NODE
+    xTaskCreate(keyx_task, "keyx_task", 4096, NULL, 1, NULL);
+    xTaskCreate(speaker_task, "speaker_task", 2048, NULL, 3, NULL);
+    xTaskCreate(mic_task, "mic_task", 2048, NULL, 3, NULL);
+#endif
+
+    wifi_init();
+    microphone_init();
+    speaker_init();
+    boot_signal(BOOT_I2S_READY, "i2s ready");
+
+    xTaskCreate(button_task, "button_task", 4096, NULL, 3, NULL);
+    xTaskCreate(encryption_button_task, "encryption_button_task", 4096, NULL, 3, NULL);
+    boot_mark("tasks started");
 }
@@ -0,0 +1,309 @@
+#include <string.h>
+#include <errno.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#else
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+
+#include "net_engine.h"
+
+uint32_t net_now_ms(void)
+{
+#ifdef ESP_PLATFORM
+    return (uint32_t)(esp_timer_get_time() / 1000);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+#endif
+}
+
+// Порівняння часу з урахуванням переповнення лічильника
+static inline bool time_reached(uint32_t now, uint32_t deadline)
+{
+    return (int32_t)(now - deadline) >= 0;
+}
+
+int net_engine_init(net_engine_t *ne, uint16_t port, int opts)
+{
+    int one = 1;
+
+    memset(ne, 0, sizeof(*ne));
+
+    ne->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (ne->sock < 0) {
+        return -1;
+    }
+    if (opts & NET_OPT_REUSE) {
+        setsockopt(ne->sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+    if (opts & NET_OPT_BROADCAST) {
+        setsockopt(ne->sock, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+    }
+
+    struct sockaddr_in bind_addr;
+    memset(&bind_addr, 0, sizeof(bind_addr));
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(port);
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(ne->sock, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+        int err = errno;
+        close(ne->sock);
+        ne->sock = -1;
+        errno = err;
+        return -1;
+    }
+
+    // Неблокуючий режим: відправка не повинна затримувати прийом
+    int flags = fcntl(ne->sock, F_GETFL, 0);
+    fcntl(ne->sock, F_SETFL, flags | O_NONBLOCK);
+
+    ne->running = true;
+    return 0;
+}
+
+int net_engine_join_multicast(net_engine_t *ne, uint32_t group_addr)
+{
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.imr_multiaddr.s_addr = group_addr;
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    return setsockopt(ne->sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq));
+}
+
+void net_engine_close(net_engine_t *ne)
+{
+    if (ne->sock >= 0) {
+        close(ne->sock);
+        ne->sock = -1;
+    }
+    ne->running = false;
+}
+
+void net_engine_set_rx(net_engine_t *ne, net_rx_cb_t cb, void *ctx)
+{
+    ne->on_rx = cb;
+    ne->rx_ctx = ctx;
+}
+
+int net_engine_add_timer(net_engine_t *ne, uint32_t period_ms, net_timer_cb_t cb, void *ctx)
+{
+    if (ne->timer_count >= NET_MAX_TIMERS || period_ms == 0) {
+        return -1;
+    }
+    net_timer_t *t = &ne->timers[ne->timer_count];
+    t->cb = cb;
+    t->ctx = ctx;
+    t->period_ms = period_ms;
+    t->next_ms = net_now_ms() + period_ms;
+    return ne->timer_count++;
+}
+
+void net_engine_set_tx_deadline(net_engine_t *ne, uint32_t deadline_ms)
+{
+    ne->tx_deadline_ms = deadline_ms;
+}
+
+bool net_engine_send_stamped(net_engine_t *ne, const uint8_t *data, size_t len, const struct sockaddr_in *dest, uint32_t stamp_ms)
+{
+    if (len > NET_MAX_DATAGRAM) {
+        return false;
+    }
+    if (ne->tx_count == NET_TX_QUEUE_LEN) {
+        // Новий кадр цінніший за найстаріший - витісняємо голову черги
+        ne->tx_head = (ne->tx_head + 1) % NET_TX_QUEUE_LEN;
+        ne->tx_count--;
+        ne->tx_overflows++;
+    }
+
+    net_frame_t *f = &ne->tx[(ne->tx_head + ne->tx_count) % NET_TX_QUEUE_LEN];
+    memcpy(f->data, data, len);
+    f->len = len;
+    f->dest = *dest;
+    f->stamp_ms = stamp_ms;
+    ne->tx_count++;
+    return true;
+}
+
+bool net_engine_send(net_engine_t *ne, const uint8_t *data, size_t len, const struct sockaddr_in *dest)
+{
+    return net_engine_send_stamped(ne, data, len, dest, net_now_ms());
+}
+
+bool net_engine_send_now(net_engine_t *ne, const uint8_t *data, size_t len, const struct sockaddr_in *dest)
+{
+    if (sendto(ne->sock, data, len, 0, (const struct sockaddr *)dest, sizeof(*dest)) < 0) {
+        ne->tx_errors++;
+        return false;
+    }
+    ne->tx_sent++;
+    return true;
+}
+
+// Відкидання кадрів з голови черги, які вже не встигнуть вчасно
+static void drop_stale(net_engine_t *ne, uint32_t now)
+{
+    if (ne->tx_deadline_ms == 0) {
+        return;
+    }
+    while (ne->tx_count > 0) {
+        net_frame_t *f = &ne->tx[ne->tx_head];
+        if ((uint32_t)(now - f->stamp_ms) <= ne->tx_deadline_ms) {
+            break;
+        }
+        ne->tx_head = (ne->tx_head + 1) % NET_TX_QUEUE_LEN;
+        ne->tx_count--;
+        ne->tx_deadline_misses++;
+    }
+}
+
+// Відправка кадрів з черги, поки сокет їх приймає
+static void flush_tx(net_engine_t *ne, uint32_t now)
+{
+    drop_stale(ne, now);
+
+    if (ne->tx_backoff) {
+        if (!time_reached(now, ne->tx_retry_ms)) {
+            return;
+        }
+        ne->tx_backoff = false;
+    }
+
+    while (ne->tx_count > 0) {
+        net_frame_t *f = &ne->tx[ne->tx_head];
+        int err = sendto(ne->sock, f->data, f->len, 0, (struct sockaddr *)&f->dest, sizeof(f->dest));
+        if (err < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOMEM || errno == ENOBUFS) {
+                // Стек тимчасово не має буферів - кадр лишається в черзі
+                ne->tx_backoff = true;
+                ne->tx_retry_ms = now + NET_TX_RETRY_MS;
+                return;
+            }
+            ne->tx_errors++;
+        } else {
+            ne->tx_sent++;
+        }
+        ne->tx_head = (ne->tx_head + 1) % NET_TX_QUEUE_LEN;
+        ne->tx_count--;
+    }
+}
+
+static void run_timers(net_engine_t *ne, uint32_t now)
+{
+    for (int i = 0; i < ne->timer_count; i++) {
+        net_timer_t *t = &ne->timers[i];
+        if (time_reached(now, t->next_ms)) {
+            t->next_ms += t->period_ms;
+            // Якщо відстали більш ніж на період, не наздоганяємо пропущені спрацювання
+            if (time_reached(now, t->next_ms)) {
+                t->next_ms = now + t->period_ms;
+            }
+            t->cb(t->ctx, now);
+        }
+    }
+}
+
+// Час очікування до найближчої події, мс
+static int next_wait_ms(net_engine_t *ne, uint32_t now, int max_wait_ms)
+{
+    int wait = max_wait_ms;
+    for (int i = 0; i < ne->timer_count; i++) {
+        int32_t left = (int32_t)(ne->timers[i].next_ms - now);
+        if (left < 0) {
+            left = 0;
+        }
+        if (wait < 0 || left < wait) {
+            wait = left;
+        }
+    }
+    if (ne->tx_count > 0 && ne->tx_backoff) {
+        int32_t left = (int32_t)(ne->tx_retry_ms - now);
+        if (left < 0) {
+            left = 0;
+        }
+        if (wait < 0 || left < wait) {
+            wait = left;
+        }
+    }
+    return wait;
+}
+
+int net_engine_poll(net_engine_t *ne, int max_wait_ms)
+{
+    uint32_t now = net_now_ms();
+    int wait = next_wait_ms(ne, now, max_wait_ms);
+
+    fd_set readfds;
+    fd_set writefds;
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    FD_SET(ne->sock, &readfds);
+    bool want_write = ne->tx_count > 0 && !ne->tx_backoff;
+    if (want_write) {
+        FD_SET(ne->sock, &writefds);
+    }
+
+    struct timeval tv;
+    struct timeval *ptv = NULL;
+    if (wait >= 0) {
+        tv.tv_sec = wait / 1000;
+        tv.tv_usec = (wait % 1000) * 1000;
+        ptv = &tv;
+    }
+
+    int n = select(ne->sock + 1, &readfds, want_write ? &writefds : NULL, NULL, ptv);
+    if (n < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    now = net_now_ms();
+
+    if (n > 0 && FD_ISSET(ne->sock, &readfds)) {
+        // Забираємо датаграми, що вже надійшли, але не більше NET_RX_BURST:
+        // решта дочекається наступної ітерації, після таймерів і відправки
+        int burst = 0;
+        while (1) {
+            if (burst == NET_RX_BURST) {
+                ne->rx_bursts++;
+                break;
+            }
+            struct sockaddr_in from;
+            socklen_t socklen = sizeof(from);
+            int len = recvfrom(ne->sock, ne->rx_buf, sizeof(ne->rx_buf), 0, (struct sockaddr *)&from, &socklen);
+            if (len < 0) {
+                break;
+            }
+            burst++;
+            ne->rx_packets++;
+            if (ne->on_rx) {
+                ne->on_rx(ne->rx_ctx, ne->rx_buf, (size_t)len, &from);
+            }
+        }
+        now = net_now_ms();
+    }
+
+    run_timers(ne, now);
+    flush_tx(ne, now);
+    return 0;
+}
+
+void net_engine_run(net_engine_t *ne)
+{
+    while (ne->running) {
+        if (net_engine_poll(ne, -1) < 0) {
+            break;
+        }
+    }
+}
+
+void net_engine_stop(net_engine_t *ne)
+{
+    ne->running = false;
+}
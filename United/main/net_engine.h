@@ -0,0 +1,108 @@
+#ifndef MAIN_NET_ENGINE_H_
+#define MAIN_NET_ENGINE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef ESP_PLATFORM
+#include "lwip/sockets.h"
+#else
+#include <netinet/in.h>
+#endif
+
+// Мережевий рушій: один UDP сокет і один цикл select(), який обслуговує
+// прийом, чергу на відправку та періодичні таймери.
+// Не залежить від FreeRTOS, тому так само збирається і на POSIX хості.
+
+#define NET_MAX_DATAGRAM 1280   // Максимальний розмір датаграми (аудіо кадр + заголовки)
+#define NET_TX_QUEUE_LEN 4      // Кількість кадрів у черзі на відправку
+#define NET_MAX_TIMERS 8        // Кількість періодичних таймерів
+#define NET_TX_RETRY_MS 2       // Пауза перед повтором після ENOMEM/EAGAIN
+#define NET_RX_BURST 8          // Датаграм за одну ітерацію: потік пакетів не затримує таймери
+
+// Опції сокета для net_engine_init
+#define NET_OPT_BROADCAST 0x01  // Дозволити відправку на широкомовну адресу
+#define NET_OPT_REUSE 0x02      // Кілька сокетів на одному порту (групи на одному хості)
+
+typedef void (*net_rx_cb_t)(void *ctx, uint8_t *data, size_t len, const struct sockaddr_in *from);
+typedef void (*net_timer_cb_t)(void *ctx, uint32_t now_ms);
+
+typedef struct {
+    uint8_t data[NET_MAX_DATAGRAM];
+    size_t len;
+    struct sockaddr_in dest;
+    uint32_t stamp_ms;          // Час захоплення кадру
+} net_frame_t;
+
+typedef struct {
+    net_timer_cb_t cb;
+    void *ctx;
+    uint32_t period_ms;
+    uint32_t next_ms;
+} net_timer_t;
+
+typedef struct {
+    int sock;
+    bool running;
+
+    net_rx_cb_t on_rx;
+    void *rx_ctx;
+
+    // Кільцева черга кадрів на відправку
+    net_frame_t tx[NET_TX_QUEUE_LEN];
+    uint8_t tx_head;
+    uint8_t tx_count;
+    uint32_t tx_retry_ms;       // Час, до якого відправка призупинена
+    bool tx_backoff;
+    uint32_t tx_deadline_ms;    // Максимальний вік кадру в черзі (0 - без обмеження)
+
+    net_timer_t timers[NET_MAX_TIMERS];
+    int timer_count;
+
+    uint8_t rx_buf[NET_MAX_DATAGRAM];
+
+    uint32_t tx_sent;
+    uint32_t tx_errors;
+    uint32_t tx_overflows;      // Кадри, витіснені з переповненої черги
+    uint32_t tx_deadline_misses; // Кадри, що застаріли до відправки
+    uint32_t rx_packets;
+    uint32_t rx_bursts;         // Ітерації, що вибрали NET_RX_BURST датаграм і лишили решту
+} net_engine_t;
+
+// Монотонний час у мілісекундах
+uint32_t net_now_ms(void);
+
+// Створення сокету, прив'язаного до port (0 - довільний порт), opts - NET_OPT_*.
+// Повертає 0 або -1 (errno)
+int net_engine_init(net_engine_t *ne, uint16_t port, int opts);
+// Приєднання до multicast групи (адреса в мережевому порядку байтів)
+int net_engine_join_multicast(net_engine_t *ne, uint32_t group_addr);
+void net_engine_close(net_engine_t *ne);
+
+void net_engine_set_rx(net_engine_t *ne, net_rx_cb_t cb, void *ctx);
+// Повертає індекс таймера або -1, якщо таймерів забагато
+int net_engine_add_timer(net_engine_t *ne, uint32_t period_ms, net_timer_cb_t cb, void *ctx);
+
+// Постановка кадру в чергу. Викликати лише з задачі, що крутить рушій (колбеки).
+// При переповненні витісняється найстаріший кадр. Повертає false, якщо кадр завеликий
+bool net_engine_send(net_engine_t *ne, const uint8_t *data, size_t len, const struct sockaddr_in *dest);
+// Те саме, але з часом захоплення кадру, від якого рахується дедлайн
+bool net_engine_send_stamped(net_engine_t *ne, const uint8_t *data, size_t len, const struct sockaddr_in *dest, uint32_t stamp_ms);
+
+// Негайна відправка без черги і без копіювання, для пересилання прийнятого пакета
+// прямо з буфера прийому. Якщо стек зайнятий, пакет не відправляється. Повертає true, якщо відправлено
+bool net_engine_send_now(net_engine_t *ne, const uint8_t *data, size_t len, const struct sockaddr_in *dest);
+
+// Кадри, старші за deadline_ms на момент відправки, відкидаються (0 - вимкнено)
+void net_engine_set_tx_deadline(net_engine_t *ne, uint32_t deadline_ms);
+
+// Одна ітерація циклу: чекає не довше max_wait_ms (-1 - до найближчого таймера)
+// Повертає 0 або -1 при помилці select()
+int net_engine_poll(net_engine_t *ne, int max_wait_ms);
+
+// Цикл рушія, працює до net_engine_stop()
+void net_engine_run(net_engine_t *ne);
+void net_engine_stop(net_engine_t *ne);
+
+#endif /* MAIN_NET_ENGINE_H_ */
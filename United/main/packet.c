@@ -0,0 +1,247 @@
+#include <string.h>
+
+#include "packet.h"
+
+size_t pkt_write_header(uint8_t *buf, const pkt_header_t *h)
+{
+    buf[0] = PKT_MAGIC;
+    buf[1] = h->type;
+    buf[2] = h->group;
+    buf[PKT_HOPS_OFFSET] = h->hops;
+    pkt_put_u16(&buf[4], h->node);
+    pkt_put_u16(&buf[6], h->seq);
+    pkt_put_u32(&buf[8], h->timestamp);
+    return PKT_HEADER_SIZE;
+}
+
+bool pkt_read_header(const uint8_t *buf, size_t len, pkt_header_t *h)
+{
+    if (len < PKT_HEADER_SIZE || buf[0] != PKT_MAGIC) {
+        return false;
+    }
+    h->type = buf[1];
+    h->group = buf[2];
+    h->hops = buf[PKT_HOPS_OFFSET];
+    h->node = pkt_get_u16(&buf[4]);
+    h->seq = pkt_get_u16(&buf[6]);
+    h->timestamp = pkt_get_u32(&buf[8]);
+    return true;
+}
+
+size_t pkt_write_report(uint8_t *buf, const pkt_report_t *r)
+{
+    buf[0] = r->flags;
+    buf[1] = r->fraction_lost;
+    pkt_put_u32(&buf[2], r->received);
+    pkt_put_u32(&buf[6], r->cumulative_lost);
+    pkt_put_u32(&buf[10], r->ext_max_seq);
+    pkt_put_u32(&buf[14], r->jitter_q4);
+    pkt_put_u32(&buf[18], r->echo_ts);
+    pkt_put_u32(&buf[22], r->echo_delay_ms);
+    return PKT_REPORT_SIZE;
+}
+
+bool pkt_read_report(const uint8_t *buf, size_t len, pkt_report_t *r)
+{
+    if (len < PKT_REPORT_SIZE) {
+        return false;
+    }
+    r->flags = buf[0];
+    r->fraction_lost = buf[1];
+    r->received = pkt_get_u32(&buf[2]);
+    r->cumulative_lost = pkt_get_u32(&buf[6]);
+    r->ext_max_seq = pkt_get_u32(&buf[10]);
+    r->jitter_q4 = pkt_get_u32(&buf[14]);
+    r->echo_ts = pkt_get_u32(&buf[18]);
+    r->echo_delay_ms = pkt_get_u32(&buf[22]);
+    return true;
+}
+
+size_t pkt_write_audio_desc(uint8_t *buf, const pkt_audio_desc_t *d)
+{
+    buf[0] = (d->decim_shift & PKT_AUDIO_DECIM_MASK) | (d->fec ? PKT_AUDIO_FEC : 0) |
+             (uint8_t)((d->key & PKT_AUDIO_KEY_MASK) << PKT_AUDIO_KEY_SHIFT);
+    buf[1] = d->frames;
+    return PKT_AUDIO_DESC_SIZE;
+}
+
+bool pkt_read_audio_desc(const uint8_t *buf, size_t len, pkt_audio_desc_t *d)
+{
+    if (len < PKT_AUDIO_DESC_SIZE || buf[1] == 0) {
+        return false;
+    }
+    d->decim_shift = buf[0] & PKT_AUDIO_DECIM_MASK;
+    d->fec = (buf[0] & PKT_AUDIO_FEC) != 0;
+    d->key = (buf[0] >> PKT_AUDIO_KEY_SHIFT) & PKT_AUDIO_KEY_MASK;
+    d->frames = buf[1];
+    return true;
+}
+
+size_t pkt_write_floor(uint8_t *buf, const pkt_floor_t *f)
+{
+    buf[0] = f->op;
+    buf[1] = f->priority;
+    pkt_put_u16(&buf[2], f->target);
+    pkt_put_u16(&buf[4], f->holder);
+    return PKT_FLOOR_SIZE;
+}
+
+bool pkt_read_floor(const uint8_t *buf, size_t len, pkt_floor_t *f)
+{
+    if (len < PKT_FLOOR_SIZE || buf[0] < PKT_FLOOR_REQUEST || buf[0] > PKT_FLOOR_RELEASE) {
+        return false;
+    }
+    f->op = buf[0];
+    f->priority = buf[1];
+    f->target = pkt_get_u16(&buf[2]);
+    f->holder = pkt_get_u16(&buf[4]);
+    return true;
+}
+
+size_t pkt_write_beacon(uint8_t *buf, const pkt_beacon_t *b)
+{
+    buf[0] = b->version;
+    buf[1] = b->codec;
+    buf[2] = b->caps;
+    buf[3] = b->max_decim_shift;
+    buf[4] = b->rate_level;
+    pkt_put_u32(&buf[5], b->boot_id);
+    pkt_put_u16(&buf[9], b->sample_rate);
+    return PKT_BEACON_SIZE;
+}
+
+bool pkt_read_beacon(const uint8_t *buf, size_t len, pkt_beacon_t *b)
+{
+    if (len < PKT_BEACON_SIZE || buf[0] != PKT_BEACON_VERSION) {
+        return false;
+    }
+    b->version = buf[0];
+    b->codec = buf[1];
+    b->caps = buf[2];
+    b->max_decim_shift = buf[3];
+    b->rate_level = buf[4];
+    b->boot_id = pkt_get_u32(&buf[5]);
+    b->sample_rate = pkt_get_u16(&buf[9]);
+    return true;
+}
+
+size_t pkt_write_compact(uint8_t *buf, const pkt_compact_t *c)
+{
+    buf[0] = PKT_MAGIC_COMPACT;
+    buf[1] = (c->desc.decim_shift & PKT_AUDIO_DECIM_MASK) | (c->desc.fec ? PKT_AUDIO_FEC : 0) |
+             (uint8_t)(((c->desc.frames - 1) & PKT_COMPACT_FRAMES_MASK) << PKT_COMPACT_FRAMES_SHIFT) | (uint8_t)((c->desc.key & PKT_AUDIO_KEY_MASK) << 6);
+    buf[2] = c->group;
+    buf[PKT_HOPS_OFFSET] = c->hops;
+    pkt_put_u16(&buf[4], c->node);
+    buf[6] = c->seq_lo;
+    pkt_put_u16(&buf[7], c->ts_lo);
+    return PKT_COMPACT_SIZE;
+}
+
+bool pkt_read_compact(const uint8_t *buf, size_t len, pkt_compact_t *c)
+{
+    if (len < PKT_COMPACT_SIZE || buf[0] != PKT_MAGIC_COMPACT) {
+        return false;
+    }
+    c->desc.decim_shift = buf[1] & PKT_AUDIO_DECIM_MASK;
+    c->desc.fec = (buf[1] & PKT_AUDIO_FEC) != 0;
+    c->desc.frames = ((buf[1] >> PKT_COMPACT_FRAMES_SHIFT) & PKT_COMPACT_FRAMES_MASK) + 1;
+    c->desc.key = buf[1] >> 6;
+    c->group = buf[2];
+    c->hops = buf[PKT_HOPS_OFFSET];
+    c->node = pkt_get_u16(&buf[4]);
+    c->seq_lo = buf[6];
+    c->ts_lo = pkt_get_u16(&buf[7]);
+    return true;
+}
+
+size_t pkt_write_key(uint8_t *buf, const pkt_key_t *k)
+{
+    buf[0] = k->op;
+    if (k->op == PKT_KEY_HELLO) {
+        buf[1] = k->flags;
+        memcpy(&buf[2], k->data, PKT_KEY_PUB_SIZE);
+        return PKT_KEY_HELLO_SIZE;
+    }
+    buf[1] = k->id;
+    if (k->op == PKT_KEY_SENDER) {
+        pkt_put_u32(&buf[2], k->check);
+        memcpy(&buf[6], k->data, PKT_KEY_WRAPPED_SIZE);
+        return PKT_KEY_SENDER_SIZE;
+    }
+    return PKT_KEY_ACK_SIZE;
+}
+
+bool pkt_read_key(const uint8_t *buf, size_t len, pkt_key_t *k)
+{
+    if (len < PKT_KEY_ACK_SIZE) {
+        return false;
+    }
+    memset(k, 0, sizeof(*k));
+    k->op = buf[0];
+    switch (k->op) {
+    case PKT_KEY_HELLO:
+        if (len < PKT_KEY_HELLO_SIZE) {
+            return false;
+        }
+        k->flags = buf[1];
+        memcpy(k->data, &buf[2], PKT_KEY_PUB_SIZE);
+        return true;
+    case PKT_KEY_SENDER:
+        if (len < PKT_KEY_SENDER_SIZE) {
+            return false;
+        }
+        k->id = buf[1];
+        k->check = pkt_get_u32(&buf[2]);
+        memcpy(k->data, &buf[6], PKT_KEY_WRAPPED_SIZE);
+        return true;
+    case PKT_KEY_ACK:
+        k->id = buf[1];
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t pkt_write_mac_prefix(uint8_t *buf, const pkt_header_t *h, const pkt_audio_desc_t *d, uint32_t boot_id)
+{
+    pkt_header_t canon = *h;
+
+    canon.type = PKT_TYPE_AUDIO;
+    canon.hops = 0;
+    size_t len = pkt_write_header(buf, &canon);
+    len += pkt_write_audio_desc(buf + len, d);
+    pkt_put_u32(buf + len, boot_id);
+    return len + 4;
+}
+
+size_t pkt_write_control_prefix(uint8_t *buf, const pkt_header_t *h, uint32_t boot_id)
+{
+    pkt_header_t canon = *h;
+
+    canon.hops = 0;
+    size_t len = pkt_write_header(buf, &canon);
+    pkt_put_u32(buf + len, boot_id);
+    return len + 4;
+}
+
+size_t pkt_write_trailer_item(uint8_t *buf, uint8_t type, const uint8_t *data, uint8_t len)
+{
+    buf[0] = type;
+    buf[1] = len;
+    memcpy(buf + PKT_TRAILER_ITEM_HDR, data, len);
+    return PKT_TRAILER_ITEM_HDR + len;
+}
+
+bool pkt_next_trailer_item(const uint8_t **buf, size_t *len, uint8_t *type, const uint8_t **data, uint8_t *data_len)
+{
+    if (*len < PKT_TRAILER_ITEM_HDR || *len - PKT_TRAILER_ITEM_HDR < (*buf)[1]) {
+        return false;
+    }
+    *type = (*buf)[0];
+    *data_len = (*buf)[1];
+    *data = *buf + PKT_TRAILER_ITEM_HDR;
+    *buf += PKT_TRAILER_ITEM_HDR + *data_len;
+    *len -= PKT_TRAILER_ITEM_HDR + *data_len;
+    return true;
+}
@@ -0,0 +1,244 @@
+#ifndef MAIN_PACKET_H_
+#define MAIN_PACKET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Формат датаграм між пристроями. Усі поля у мережевому порядку байтів.
+//
+//  0      1      2      3      4      5      6      7
+// +------+------+------+------+------+------+------+------+
+// | MAGIC| TYPE | GROUP| HOPS |    NODE     |     SEQ     |
+// +------+------+------+------+------+------+------+------+
+// |         TIMESTAMP         | корисне навантаження ...
+// +------+------+------+------+
+
+#define PKT_MAGIC 0x57          // 'W'
+#define PKT_HEADER_SIZE 12
+#define PKT_GROUP_ANY 0         // Пакет для всіх груп (службові повідомлення)
+#define PKT_HOPS_OFFSET 3       // Лічильник ретрансляцій, ретранслятор збільшує його на місці
+
+typedef enum {
+    PKT_TYPE_AUDIO = 1,
+    PKT_TYPE_REPORT = 2,
+    PKT_TYPE_FLOOR = 3,
+    PKT_TYPE_BEACON = 4,
+    PKT_TYPE_KEY = 5,
+} pkt_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t group;              // Розмовна група
+    uint8_t hops;               // Скільки разів пакет ретранслювали
+    uint16_t node;              // Ідентифікатор пристрою-відправника
+    uint16_t seq;
+    uint32_t timestamp;         // Час відправника, мс
+} pkt_header_t;
+
+// Опис аудіо навантаження, йде відкритим текстом одразу після заголовка:
+// байт 0 - проріджування (біти 0-1), прапорець FEC (біт 2) і ключ (біти 3-4),
+// байт 1 - кількість кадрів.
+// Далі зашифровані кадри, а при FEC - ще й копія кадрів попереднього пакета
+#define PKT_AUDIO_DESC_SIZE 2
+#define PKT_AUDIO_DECIM_MASK 0x03
+#define PKT_AUDIO_FEC 0x04
+#define PKT_AUDIO_KEY_SHIFT 3
+#define PKT_AUDIO_KEY_MASK 0x03
+
+// Ключ, яким зашифровано кадри: спільний груповий або сеансовий ключ
+// відправника, фаза - молодший біт його номера (keyx.h). NONE - кадри
+// відкритим текстом, тег рахується груповим ключем (crypto_mode.h)
+#define PKT_AUDIO_KEY_GROUP 0
+#define PKT_AUDIO_KEY_PHASE0 1
+#define PKT_AUDIO_KEY_PHASE1 2
+#define PKT_AUDIO_KEY_NONE 3
+
+typedef struct {
+    uint8_t decim_shift;
+    uint8_t frames;
+    bool fec;
+    uint8_t key;                // PKT_AUDIO_KEY_*
+} pkt_audio_desc_t;
+
+// Стиснутий заголовок аудіо пакета. Номер і час передаються молодшими байтами,
+// старші приймач відновлює з контексту потоку - попереднього пакета того ж
+// відправника (hdr_comp.h). GROUP, HOPS і NODE на тих самих місцях, що й у
+// повному заголовку, опис аудіо - в байті 1 замість типу.
+//
+//  0      1      2      3      4      5      6      7      8
+// +------+------+------+------+------+------+------+------+------+
+// |MAGIC2| DESC | GROUP| HOPS |    NODE     |SEQ_LO|    TS_LO    |
+// +------+------+------+------+------+------+------+------+------+
+//
+// DESC: проріджування (біти 0-1), FEC (біт 2), кількість кадрів - 1 (біти 3-5), ключ (біти 6-7).
+// На кількість кадрів лише три біти, тож стиснутим іде пакет з 8 кадрами
+// щонайбільше. Більший hdr_comp_write відправляє з повним заголовком
+#define PKT_MAGIC_COMPACT 0x58  // 'X'
+#define PKT_COMPACT_SIZE 9
+#define PKT_COMPACT_FRAMES_SHIFT 3
+#define PKT_COMPACT_FRAMES_MASK 0x07
+#define PKT_COMPACT_MAX_FRAMES (PKT_COMPACT_FRAMES_MASK + 1)
+
+typedef struct {
+    pkt_audio_desc_t desc;
+    uint8_t group;
+    uint8_t hops;
+    uint16_t node;
+    uint8_t seq_lo;
+    uint16_t ts_lo;
+} pkt_compact_t;
+
+// Службові повідомлення в хвості аудіо пакета, одразу після кадрів (і копії FEC),
+// відкритим текстом: [тип][довжина][дані] ... до тегу автентифікації
+#define PKT_TRAILER_ITEM_HDR 2
+
+// Тег автентифікації - останні байти аудіо датаграми: усічений AES-CMAC
+// (cmac.h) від канонічного префікса і всього, що йде після заголовка (кадри,
+// копія FEC, хвіст). Канонічний префікс - повний заголовок з HOPS = 0 (його
+// змінюють ретранслятори) і опис аудіо, тож стиснутий і повний заголовок
+// автентифікуються однаково, разом з відновленими старшими байтами номера і часу.
+// За описом - ідентифікатор запуску відправника з його маяка: пакет старого
+// запуску не проходить перевірку і після того, як номери почались спочатку
+#define PKT_AUDIO_MAC_SIZE 4
+#define PKT_MAC_PREFIX_SIZE (PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE + 4)
+
+// Службовий пакет окремою датаграмою (звіт, слово, ключі, маяк) закінчується
+// тегом груповим ключем автентифікації: усічений AES-CMAC від повного заголовка
+// з HOPS = 0, ідентифікатора запуску відправника і навантаження. Для маяка
+// запуск - з самого маяка, для решти - з останнього автентифікованого маяка
+#define PKT_CONTROL_MAC_SIZE 4
+#define PKT_CONTROL_PREFIX_SIZE (PKT_HEADER_SIZE + 4)
+
+// Звіт про якість каналу в стилі RTCP Receiver Report
+#define PKT_REPORT_SIZE 26
+#define PKT_REPORT_ECHO_VALID 0x01
+
+typedef struct {
+    uint8_t flags;
+    uint8_t fraction_lost;      // Частка втрат за останній інтервал, /256
+    uint32_t received;          // Отримано аудіо пакетів
+    uint32_t cumulative_lost;   // Втрачено аудіо пакетів з початку потоку
+    uint32_t ext_max_seq;       // Найбільший номер з урахуванням переповнень
+    uint32_t jitter_q4;         // Міжпакетний джиттер, мс * 16
+    uint32_t echo_ts;           // Мітка часу останнього пакета від адресата
+    uint32_t echo_delay_ms;     // Скільки ця мітка пролежала до відправки звіту
+} pkt_report_t;
+
+// Керування правом голосу (floor control)
+#define PKT_FLOOR_SIZE 6
+
+typedef enum {
+    PKT_FLOOR_REQUEST = 1,      // Прошу слова (всім)
+    PKT_FLOOR_GRANT = 2,        // Згоден (адресату target)
+    PKT_FLOOR_DENY = 3,         // Слово зайняте пристроєм holder (адресату target)
+    PKT_FLOOR_RELEASE = 4,      // Слово вільне (всім)
+} pkt_floor_op_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t priority;           // Пріоритет відправника запиту або власника слова
+    uint16_t target;            // Адресат відповіді, 0 - всі
+    uint16_t holder;            // Власник слова (для DENY)
+} pkt_floor_t;
+
+// Маяк присутності: адреса відправника береться з IP заголовка, тут - можливості
+#define PKT_BEACON_SIZE 11
+#define PKT_BEACON_VERSION 2
+
+#define PKT_CODEC_PCM16 0
+
+#define PKT_CAP_AES 0x01            // Підтримує шифрування AES
+#define PKT_CAP_ENCRYPTED 0x02      // Пристрій вимагає шифрування (crypto_mode.h)
+#define PKT_CAP_FEC 0x04
+#define PKT_CAP_FLOOR 0x08          // Керування правом голосу
+#define PKT_CAP_KEYX 0x10           // Сеансові ключі через обмін X25519
+
+typedef struct {
+    uint8_t version;
+    uint8_t codec;
+    uint8_t caps;               // PKT_CAP_*
+    uint8_t max_decim_shift;    // Найнижча частота, яку вміє відтворювати
+    uint8_t rate_level;         // Поточний рівень якості передачі
+    uint32_t boot_id;           // Випадковий для кожного запуску, 0 - невідомо
+    uint16_t sample_rate;
+} pkt_beacon_t;
+
+// Обмін сеансовими ключами (keyx.h), адресно конкретному пристрою:
+//  HELLO  [op][flags][відкритий ключ X25519, 32]
+//  SENDER [op][id][перевірка, 4][ключ відправника, загорнутий парним ключем, 16]
+//  ACK    [op][id]
+#define PKT_KEY_PUB_SIZE 32
+#define PKT_KEY_WRAPPED_SIZE 16
+#define PKT_KEY_HELLO_SIZE (2 + PKT_KEY_PUB_SIZE)
+#define PKT_KEY_SENDER_SIZE (6 + PKT_KEY_WRAPPED_SIZE)
+#define PKT_KEY_ACK_SIZE 2
+#define PKT_KEY_HELLO_REPLY 0x01    // Відправник ще не має нашого відкритого ключа
+
+typedef enum {
+    PKT_KEY_HELLO = 1,          // Відкритий ключ
+    PKT_KEY_SENDER = 2,         // Ключ відправника, яким він шифрує (або шифруватиме) аудіо
+    PKT_KEY_ACK = 3,            // Ключ відправника id встановлено
+} pkt_key_op_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t flags;              // HELLO: PKT_KEY_HELLO_*
+    uint8_t id;                 // SENDER, ACK: номер ключа відправника
+    uint32_t check;             // SENDER: перші 4 байти AES(ключ, нулі) для перевірки розгортання
+    uint8_t data[PKT_KEY_PUB_SIZE]; // HELLO: відкритий ключ, SENDER: загорнутий ключ
+} pkt_key_t;
+
+// Найбільше службове повідомлення окремим пакетом
+#define PKT_CONTROL_MAX_SIZE PKT_KEY_HELLO_SIZE
+
+static inline void pkt_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static inline void pkt_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static inline uint16_t pkt_get_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t pkt_get_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Повертають кількість записаних байтів
+size_t pkt_write_header(uint8_t *buf, const pkt_header_t *h);
+size_t pkt_write_report(uint8_t *buf, const pkt_report_t *r);
+size_t pkt_write_audio_desc(uint8_t *buf, const pkt_audio_desc_t *d);
+size_t pkt_write_floor(uint8_t *buf, const pkt_floor_t *f);
+size_t pkt_write_beacon(uint8_t *buf, const pkt_beacon_t *b);
+size_t pkt_write_compact(uint8_t *buf, const pkt_compact_t *c);
+size_t pkt_write_key(uint8_t *buf, const pkt_key_t *k);
+size_t pkt_write_mac_prefix(uint8_t *buf, const pkt_header_t *h, const pkt_audio_desc_t *d, uint32_t boot_id);
+size_t pkt_write_control_prefix(uint8_t *buf, const pkt_header_t *h, uint32_t boot_id);
+size_t pkt_write_trailer_item(uint8_t *buf, uint8_t type, const uint8_t *data, uint8_t len);
+
+// Повертають false, якщо дані не є коректним пакетом
+bool pkt_read_header(const uint8_t *buf, size_t len, pkt_header_t *h);
+bool pkt_read_report(const uint8_t *buf, size_t len, pkt_report_t *r);
+bool pkt_read_audio_desc(const uint8_t *buf, size_t len, pkt_audio_desc_t *d);
+bool pkt_read_floor(const uint8_t *buf, size_t len, pkt_floor_t *f);
+bool pkt_read_beacon(const uint8_t *buf, size_t len, pkt_beacon_t *b);
+bool pkt_read_compact(const uint8_t *buf, size_t len, pkt_compact_t *c);
+bool pkt_read_key(const uint8_t *buf, size_t len, pkt_key_t *k);
+
+// Наступне повідомлення з хвоста: *buf і *len зсуваються за нього.
+// Повертає false, коли хвіст закінчився або пошкоджений
+bool pkt_next_trailer_item(const uint8_t **buf, size_t *len, uint8_t *type, const uint8_t **data, uint8_t *data_len);
+
+#endif /* MAIN_PACKET_H_ */
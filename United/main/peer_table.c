@@ -0,0 +1,73 @@
+#include <string.h>
+
+#include "peer_table.h"
+
+void peer_table_init(peer_table_t *pt)
+{
+    memset(pt, 0, sizeof(*pt));
+}
+
+peer_t *peer_table_find(peer_table_t *pt, uint16_t node)
+{
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        if (pt->peers[i].used && pt->peers[i].node == node) {
+            return &pt->peers[i];
+        }
+    }
+    return NULL;
+}
+
+peer_t *peer_table_touch(peer_table_t *pt, uint16_t node, const struct sockaddr_in *addr, uint32_t now_ms)
+{
+    peer_t *p = peer_table_find(pt, node);
+
+    if (p == NULL) {
+        // Вільний запис або найдавніший
+        peer_t *oldest = &pt->peers[0];
+        for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+            if (!pt->peers[i].used) {
+                oldest = &pt->peers[i];
+                break;
+            }
+            if ((int32_t)(pt->peers[i].last_seen_ms - oldest->last_seen_ms) < 0) {
+                oldest = &pt->peers[i];
+            }
+        }
+        p = oldest;
+        memset(p, 0, sizeof(*p));
+        p->used = true;
+        p->node = node;
+        link_stats_init(&p->stats);
+    }
+
+    p->addr = *addr;
+    p->last_seen_ms = now_ms;
+    return p;
+}
+
+void peer_table_reset(peer_t *p)
+{
+    peer_t keep = *p;
+
+    memset(p, 0, sizeof(*p));
+    p->used = true;
+    p->node = keep.node;
+    p->channel = keep.channel;
+    p->addr = keep.addr;
+    p->last_seen_ms = keep.last_seen_ms;
+    p->info_valid = keep.info_valid;
+    p->info = keep.info;
+    link_stats_init(&p->stats);
+}
+
+int peer_table_expire(peer_table_t *pt, uint32_t now_ms, uint32_t timeout_ms)
+{
+    int removed = 0;
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        if (pt->peers[i].used && (uint32_t)(now_ms - pt->peers[i].last_seen_ms) > timeout_ms) {
+            pt->peers[i].used = false;
+            removed++;
+        }
+    }
+    return removed;
+}
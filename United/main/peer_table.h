@@ -0,0 +1,62 @@
+#ifndef MAIN_PEER_TABLE_H_
+#define MAIN_PEER_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef ESP_PLATFORM
+#include "lwip/sockets.h"
+#else
+#include <netinet/in.h>
+#endif
+
+#include "link_stats.h"
+#include "hdr_comp.h"
+#include "keyx.h"
+
+// Невелика таблиця відомих пристроїв фіксованого розміру.
+// Ключ - ідентифікатор вузла з заголовка пакета, адреса оновлюється з кожним пакетом.
+
+#define PEER_TABLE_SIZE 8
+#define PEER_TIMEOUT_MS 3500    // Пристрій, якого не чути стільки часу (три маяки), видаляється
+
+typedef struct {
+    bool used;
+    uint16_t node;
+    uint8_t channel;            // Канал, на якому пристрій говорить
+    struct sockaddr_in addr;
+    uint32_t last_seen_ms;
+    uint32_t last_audio_ms;
+
+    // Можливості з маяка присутності
+    bool info_valid;
+    pkt_beacon_t info;
+
+    keyx_peer_t keys;           // Обмін ключами і ключі відправника цього пристрою
+
+    // Стан прийому аудіо від цього пристрою
+    hdr_comp_rx_t hdr_ctx;      // Контекст для стиснутих заголовків
+    bool rx_seq_valid;
+    uint16_t last_rx_seq;
+    link_stats_t stats;
+} peer_t;
+
+typedef struct {
+    peer_t peers[PEER_TABLE_SIZE];
+} peer_table_t;
+
+void peer_table_init(peer_table_t *pt);
+
+peer_t *peer_table_find(peer_table_t *pt, uint16_t node);
+
+// Пошук або додавання пристрою. Якщо місця немає, витісняється той,
+// кого найдовше не було чути. Оновлює адресу і час останнього пакета
+peer_t *peer_table_touch(peer_table_t *pt, uint16_t node, const struct sockaddr_in *addr, uint32_t now_ms);
+
+// Пристрій перезапустився: стан його потоку і ключі скидаються, адреса і можливості лишаються
+void peer_table_reset(peer_t *p);
+
+// Видалення пристроїв, яких не чути довше timeout_ms. Повертає кількість видалених
+int peer_table_expire(peer_table_t *pt, uint32_t now_ms, uint32_t timeout_ms);
+
+#endif /* MAIN_PEER_TABLE_H_ */
@@ -0,0 +1,72 @@
+#include <string.h>
+
+#include "rate_ctl.h"
+
+// Розмір корисного навантаження на кожному рівні не перевищує одного повного кадру
+const rate_level_t rate_levels[RATE_LEVEL_COUNT] = {
+    { .decim_shift = 0, .frames_per_packet = 1, .fec = false },  // 44.1 кГц
+    { .decim_shift = 1, .frames_per_packet = 1, .fec = true  },  // 22 кГц + копія попереднього
+    { .decim_shift = 1, .frames_per_packet = 2, .fec = false },  // 22 кГц, удвічі менше пакетів
+    { .decim_shift = 2, .frames_per_packet = 2, .fec = true  },  // 11 кГц, менше пакетів + копія
+};
+
+static const rate_ctl_config_t default_config = {
+    .loss_bad_q8 = 13,          // ~5%
+    .loss_good_q8 = 3,          // ~1%
+    .delay_bad_ms = 60,
+    .delay_good_ms = 20,
+    .jitter_bad_ms = 30,
+    .jitter_good_ms = 10,
+    .down_after = 2,
+    .up_after = 5,
+};
+
+void rate_ctl_init(rate_ctl_t *rc, const rate_ctl_config_t *cfg)
+{
+    memset(rc, 0, sizeof(*rc));
+    rc->cfg = cfg ? *cfg : default_config;
+}
+
+bool rate_ctl_update(rate_ctl_t *rc, const rate_sample_t *s)
+{
+    const rate_ctl_config_t *cfg = &rc->cfg;
+    uint32_t queue_ms = 0;
+
+    if (s->rtt_valid) {
+        if (!rc->min_rtt_valid || s->rtt_ms < rc->min_rtt_ms) {
+            rc->min_rtt_ms = s->rtt_ms;
+            rc->min_rtt_valid = true;
+        } else {
+            queue_ms = s->rtt_ms - rc->min_rtt_ms;
+            // Повільний дрейф, щоб мінімум не залип після зміни маршруту
+            rc->min_rtt_ms++;
+        }
+    }
+
+    bool bad = s->fraction_lost >= cfg->loss_bad_q8 ||
+               queue_ms >= cfg->delay_bad_ms ||
+               s->jitter_ms >= cfg->jitter_bad_ms;
+    bool good = s->fraction_lost <= cfg->loss_good_q8 &&
+                queue_ms <= cfg->delay_good_ms &&
+                s->jitter_ms <= cfg->jitter_good_ms;
+
+    // Між порогами - зона гістерезису, лічильники скидаються
+    rc->bad_streak = bad ? rc->bad_streak + 1 : 0;
+    rc->good_streak = good ? rc->good_streak + 1 : 0;
+
+    if (rc->bad_streak >= cfg->down_after && rc->level + 1 < RATE_LEVEL_COUNT) {
+        rc->level++;
+        rc->bad_streak = 0;
+        rc->good_streak = 0;
+        rc->changes++;
+        return true;
+    }
+    if (rc->good_streak >= cfg->up_after && rc->level > 0) {
+        rc->level--;
+        rc->bad_streak = 0;
+        rc->good_streak = 0;
+        rc->changes++;
+        return true;
+    }
+    return false;
+}
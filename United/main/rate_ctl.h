@@ -0,0 +1,59 @@
+#ifndef MAIN_RATE_CTL_H_
+#define MAIN_RATE_CTL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Адаптивний контролер якості передачі. Чиста логіка без мережі та FreeRTOS:
+// на вхід - зразки зі звітів співрозмовника, на вихід - рівень зі сходинок
+// нижче. Рівень 0 - найкраща якість, кожен наступний стійкіший до поганого каналу.
+
+typedef struct {
+    uint8_t decim_shift;        // Проріджування відліків: частота / (1 << decim_shift)
+    uint8_t frames_per_packet;  // Скільки кадрів збирається в один пакет
+    bool fec;                   // Пакет несе копію попереднього пакета
+} rate_level_t;
+
+#define RATE_LEVEL_COUNT 4
+extern const rate_level_t rate_levels[RATE_LEVEL_COUNT];
+
+typedef struct {
+    uint8_t loss_bad_q8;        // Частка втрат (/256), з якої інтервал поганий
+    uint8_t loss_good_q8;       // Частка втрат, нижче якої інтервал добрий
+    uint32_t delay_bad_ms;      // Черга в мережі (RTT понад мінімальний), з якої інтервал поганий
+    uint32_t delay_good_ms;
+    uint32_t jitter_bad_ms;
+    uint32_t jitter_good_ms;
+    uint8_t down_after;         // Поганих інтервалів поспіль до зниження якості
+    uint8_t up_after;           // Добрих інтервалів поспіль до підвищення якості
+} rate_ctl_config_t;
+
+typedef struct {
+    uint8_t fraction_lost;      // /256, як у звіті
+    uint32_t jitter_ms;
+    bool rtt_valid;
+    uint32_t rtt_ms;
+} rate_sample_t;
+
+typedef struct {
+    rate_ctl_config_t cfg;
+    uint8_t level;
+    uint8_t bad_streak;
+    uint8_t good_streak;
+    bool min_rtt_valid;
+    uint32_t min_rtt_ms;        // Оцінка RTT без черг, повільно дрейфує вгору
+    uint32_t changes;
+} rate_ctl_t;
+
+// cfg == NULL - налаштування за замовчуванням
+void rate_ctl_init(rate_ctl_t *rc, const rate_ctl_config_t *cfg);
+
+// Обробка одного звітного інтервалу. Повертає true, якщо рівень змінився
+bool rate_ctl_update(rate_ctl_t *rc, const rate_sample_t *s);
+
+static inline const rate_level_t *rate_ctl_level(const rate_ctl_t *rc)
+{
+    return &rate_levels[rc->level];
+}
+
+#endif /* MAIN_RATE_CTL_H_ */
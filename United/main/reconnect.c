@@ -0,0 +1,83 @@
+#include <string.h>
+
+#include "reconnect.h"
+
+void reconnect_backoff_init(reconnect_backoff_t *b, uint32_t base_ms, uint32_t max_ms)
+{
+    b->base_ms = base_ms;
+    b->max_ms = max_ms;
+    b->attempt = 0;
+}
+
+uint32_t reconnect_backoff_next(reconnect_backoff_t *b, uint32_t rnd)
+{
+    uint32_t interval = b->base_ms;
+
+    // Подвоєння до стелі, без переповнення при довгих серіях невдач
+    for (uint32_t i = 0; i < b->attempt && interval < b->max_ms; i++) {
+        interval *= 2;
+    }
+    if (interval > b->max_ms) {
+        interval = b->max_ms;
+    }
+    b->attempt++;
+
+    uint32_t half = interval / 2;
+    return half + rnd % (interval - half + 1);
+}
+
+void reconnect_backoff_reset(reconnect_backoff_t *b)
+{
+    b->attempt = 0;
+}
+
+void reconnect_stats_init(reconnect_stats_t *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+bool reconnect_stats_update(reconnect_stats_t *s, bool up, uint32_t now_ms)
+{
+    if (up) {
+        if (!s->was_up) {
+            s->was_up = true;
+            return true;
+        }
+        if (!s->down) {
+            return false;
+        }
+        uint32_t outage_ms = now_ms - s->down_since_ms;
+        s->down = false;
+        s->outages++;
+        s->last_outage_ms = outage_ms;
+        s->total_outage_ms += outage_ms;
+        if (outage_ms > s->max_outage_ms) {
+            s->max_outage_ms = outage_ms;
+        }
+        s->recovering = true;
+        s->up_since_ms = now_ms;
+        return true;
+    }
+
+    if (!s->was_up || s->down) {
+        return false;
+    }
+    s->down = true;
+    s->recovering = false;
+    s->down_since_ms = now_ms;
+    return true;
+}
+
+bool reconnect_stats_resumed(reconnect_stats_t *s, uint32_t now_ms)
+{
+    if (!s->recovering) {
+        return false;
+    }
+    uint32_t recovery_ms = now_ms - s->up_since_ms;
+    s->recovering = false;
+    s->last_recovery_ms = recovery_ms;
+    if (recovery_ms > s->max_recovery_ms) {
+        s->max_recovery_ms = recovery_ms;
+    }
+    return true;
+}
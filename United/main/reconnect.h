@@ -0,0 +1,57 @@
+#ifndef MAIN_RECONNECT_H_
+#define MAIN_RECONNECT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Керування повторним підключенням. Чиста логіка без Wi-Fi та FreeRTOS.
+//
+// Затримка між спробами росте експоненційно від base_ms до max_ms, до неї
+// додається випадковий розкид (половина інтервалу), щоб пристрої, які втратили
+// точку доступу одночасно, не підключалися всі в ту саму мить.
+
+#define RECONNECT_BASE_MS 200
+#define RECONNECT_MAX_MS 10000
+
+typedef struct {
+    uint32_t base_ms;
+    uint32_t max_ms;
+    uint32_t attempt;           // Спроб від останнього успішного підключення
+} reconnect_backoff_t;
+
+void reconnect_backoff_init(reconnect_backoff_t *b, uint32_t base_ms, uint32_t max_ms);
+
+// Затримка до наступної спроби: від половини до повного поточного інтервалу.
+// rnd - будь-яке випадкове число
+uint32_t reconnect_backoff_next(reconnect_backoff_t *b, uint32_t rnd);
+
+// Підключення вдалося - наступна перерва знову почнеться з base_ms
+void reconnect_backoff_reset(reconnect_backoff_t *b);
+
+// Облік перерв зв'язку. Перерва - від втрати каналу до його відновлення,
+// відновлення - від появи каналу до моменту, коли накопичене за перерву
+// аудіо відправлене і передача знову йде наживо
+typedef struct {
+    bool was_up;                // Канал хоч раз був, до цього перерви не рахуються
+    bool down;
+    bool recovering;
+    uint32_t down_since_ms;
+    uint32_t up_since_ms;
+
+    uint32_t outages;
+    uint32_t last_outage_ms;
+    uint32_t max_outage_ms;
+    uint32_t total_outage_ms;
+    uint32_t last_recovery_ms;
+    uint32_t max_recovery_ms;
+} reconnect_stats_t;
+
+void reconnect_stats_init(reconnect_stats_t *s);
+
+// Поточний стан каналу. Повертає true, якщо стан щойно змінився
+bool reconnect_stats_update(reconnect_stats_t *s, bool up, uint32_t now_ms);
+
+// Передача знову наживо. Повертає true, якщо це завершило відновлення після перерви
+bool reconnect_stats_resumed(reconnect_stats_t *s, uint32_t now_ms);
+
+#endif /* MAIN_RECONNECT_H_ */
@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "replay.h"
+
+void replay_init(replay_t *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+replay_result_t replay_check(replay_t *r, uint16_t seq, uint32_t timestamp)
+{
+    if (!r->valid) {
+        return REPLAY_OK;
+    }
+    // Номер міг обернутись: записаний пакет старший за вікно в часі
+    if ((int32_t)(r->newest_ts - timestamp) > REPLAY_WINDOW_MS) {
+        r->too_old++;
+        return REPLAY_TOO_OLD;
+    }
+    int16_t delta = (int16_t)(seq - r->top);
+    if (delta > 0) {
+        return REPLAY_OK;
+    }
+    if (-delta >= REPLAY_WINDOW) {
+        r->too_old++;
+        return REPLAY_TOO_OLD;
+    }
+    if ((r->seen >> -delta) & 1) {
+        r->duplicates++;
+        return REPLAY_DUPLICATE;
+    }
+    return REPLAY_OK;
+}
+
+void replay_accept(replay_t *r, uint16_t seq, uint32_t timestamp)
+{
+    if (!r->valid) {
+        r->valid = true;
+        r->top = seq;
+        r->seen = 1;
+        r->newest_ts = timestamp;
+        return;
+    }
+    if ((int32_t)(timestamp - r->newest_ts) > 0) {
+        r->newest_ts = timestamp;
+    }
+    int16_t delta = (int16_t)(seq - r->top);
+    if (delta > 0) {
+        r->seen = delta < REPLAY_WINDOW ? (r->seen << delta) | 1 : 1;
+        r->top = seq;
+    } else if (-delta < REPLAY_WINDOW) {
+        r->seen |= (uint64_t)1 << -delta;
+    }
+}
+
+void replay_table_init(replay_table_t *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+replay_node_t *replay_table_find(replay_table_t *t, uint16_t node)
+{
+    for (int i = 0; i < REPLAY_NODES; i++) {
+        if (t->nodes[i].used && t->nodes[i].node == node) {
+            return &t->nodes[i];
+        }
+    }
+    return NULL;
+}
+
+static bool is_old_boot(const replay_node_t *n, uint32_t boot_id)
+{
+    for (int i = 0; i < REPLAY_OLD_BOOTS; i++) {
+        if (n->old_boots[i] == boot_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+replay_boot_t replay_table_check_boot(replay_table_t *t, uint16_t node, uint32_t boot_id)
+{
+    const replay_node_t *n = replay_table_find(t, node);
+
+    if (boot_id == 0 || (n != NULL && boot_id != n->boot_id && is_old_boot(n, boot_id))) {
+        t->stale_boots++;
+        return REPLAY_BOOT_STALE;
+    }
+    if (n == NULL || boot_id != n->boot_id) {
+        return REPLAY_BOOT_NEW;
+    }
+    return REPLAY_BOOT_SAME;
+}
+
+replay_node_t *replay_table_set_boot(replay_table_t *t, uint16_t node, uint32_t boot_id, uint32_t now_ms)
+{
+    replay_node_t *n = replay_table_find(t, node);
+
+    if (n == NULL) {
+        // Вільний запис або найдавніший
+        n = &t->nodes[0];
+        for (int i = 0; i < REPLAY_NODES; i++) {
+            if (!t->nodes[i].used) {
+                n = &t->nodes[i];
+                break;
+            }
+            if ((int32_t)(t->nodes[i].last_ms - n->last_ms) < 0) {
+                n = &t->nodes[i];
+            }
+        }
+        if (n->used) {
+            t->evicted++;
+        }
+        memset(n, 0, sizeof(*n));
+        n->used = true;
+        n->node = node;
+        n->boot_id = boot_id;
+    } else if (n->boot_id != boot_id) {
+        // Номери почались з нуля: старі вікна відкидали б новий потік
+        n->old_boots[n->old_next] = n->boot_id;
+        n->old_next = (uint8_t)((n->old_next + 1) % REPLAY_OLD_BOOTS);
+        n->boot_id = boot_id;
+        replay_init(&n->audio);
+        replay_init(&n->control);
+        replay_init(&n->beacon);
+    }
+    n->last_ms = now_ms;
+    return n;
+}
@@ -0,0 +1,99 @@
+#ifndef MAIN_REPLAY_H_
+#define MAIN_REPLAY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Захист від повторення пакетів: ковзне вікно за номером пакета з бітовою
+// маскою вже прийнятих (як в IPsec, RFC 4303). Перевірка - кілька інструкцій
+// і робиться до автентифікації; стан оновлюється лише після неї, тож
+// підроблений пакет вікно не зсуває.
+//
+// Вікно прив'язане до сеансу відправника і скидається, коли той
+// перезапускається (новий ідентифікатор запуску в маяку).
+//
+// 16-бітний номер обертається за кілька хвилин аудіо, і записаний пакет тоді
+// знову виглядав би новішим за вікно. Тому ще й мітка часу пакета (її покриває
+// тег) не може бути старшою за найновішу прийняту більш ніж на
+// REPLAY_WINDOW_MS: так довго мережа пакети не тримає, а повторений після
+// оберту номера пакет старший на хвилини.
+//
+// Вікна відправників тримає replay_table_t окремо від таблиці сусідів: сусід,
+// якого видалено за мовчанням або витіснено, повертається зі старим вікном, а
+// не з порожнім, яке прийняло б будь-який записаний пакет. Запис створює і
+// переводить на новий запуск лише автентифікований маяк, тож витіснити чужі
+// записи може тільки той, хто знає груповий ключ. Попередні запуски
+// запам'ятовуються: записаний маяк старого запуску вікна не скидає.
+
+#define REPLAY_WINDOW 64
+#define REPLAY_WINDOW_MS 1000   // Вікно аудіо пакетів у часі (64 x 11.6 мс) з запасом на перестановки
+#define REPLAY_NODES 16         // Відправників з вікнами, вдвічі більше за таблицю сусідів
+#define REPLAY_OLD_BOOTS 4      // Попередніх запусків на відправника
+
+typedef enum {
+    REPLAY_OK = 0,
+    REPLAY_DUPLICATE,           // Цей номер уже прийнято
+    REPLAY_TOO_OLD,             // Старіший за вікно за номером або за часом
+} replay_result_t;
+
+typedef struct {
+    bool valid;
+    uint16_t top;               // Найбільший прийнятий номер
+    uint64_t seen;              // Біт i - прийнято top - i
+    uint32_t newest_ts;         // Найновіша мітка часу серед прийнятих, годинник відправника
+
+    // Лічильники
+    uint32_t duplicates;
+    uint32_t too_old;
+} replay_t;
+
+// Стан одного відправника: його запуск і вікна за видами пакетів - у кожного
+// виду свій лічильник номерів
+typedef struct {
+    bool used;
+    uint16_t node;
+    uint32_t boot_id;
+    uint32_t old_boots[REPLAY_OLD_BOOTS];
+    uint8_t old_next;
+    uint32_t last_ms;           // Останній автентифікований пакет, для витіснення
+    replay_t audio;
+    replay_t control;           // Звіти, слово, ключі
+    replay_t beacon;
+} replay_node_t;
+
+typedef enum {
+    REPLAY_BOOT_SAME = 0,       // Поточний запуск відправника
+    REPLAY_BOOT_NEW,            // Перший маяк від нього або новий запуск
+    REPLAY_BOOT_STALE,          // Запуск, що вже змінився, або невідомий (0)
+} replay_boot_t;
+
+typedef struct {
+    replay_node_t nodes[REPLAY_NODES];
+
+    // Лічильники
+    uint32_t stale_boots;
+    uint32_t evicted;
+} replay_table_t;
+
+void replay_init(replay_t *r);
+
+// Перевірка без зміни стану (лічильники відмов оновлюються).
+// timestamp - мітка часу з заголовка пакета
+replay_result_t replay_check(replay_t *r, uint16_t seq, uint32_t timestamp);
+
+// Пакет seq з міткою timestamp пройшов автентифікацію
+void replay_accept(replay_t *r, uint16_t seq, uint32_t timestamp);
+
+void replay_table_init(replay_table_t *t);
+
+// NULL - від відправника ще не було автентифікованого маяка
+replay_node_t *replay_table_find(replay_table_t *t, uint16_t node);
+
+// Запуск з автентифікованого маяка, без зміни стану (лічильник старих оновлюється)
+replay_boot_t replay_table_check_boot(replay_table_t *t, uint16_t node, uint32_t boot_id);
+
+// Маяк пройшов перевірки: запис відправника, новий запуск скидає його вікна.
+// Якщо місця немає, витісняється відправник, якого найдовше не було чути
+replay_node_t *replay_table_set_boot(replay_table_t *t, uint16_t node, uint32_t boot_id, uint32_t now_ms);
+
+#endif /* MAIN_REPLAY_H_ */
@@ -0,0 +1,134 @@
+#include <string.h>
+
+#include "status_view.h"
+
+void status_view_init(status_view_t *v, TFT_t *dev, FontxFile *fx, uint16_t width, uint16_t height, uint16_t bg)
+{
+    uint8_t glyph[FontxGlyphBufSize];
+
+    memset(v, 0, sizeof(*v));
+    v->dev = dev;
+    v->fx = fx;
+    v->width = width;
+    v->height = height;
+    v->bg = bg;
+    v->full = true;
+    GetFontx(fx, 0, glyph, &v->fw, &v->fh);
+
+    for (int i = 0; i < STATUS_VIEW_LINES; i++) {
+        v->w[i].fg = WHITE;
+        v->w[i].bg = bg;
+        v->w[i].shown_bg = bg;
+        v->w[i].x0 = 0;
+        v->w[i].x1 = -1;
+    }
+    // Смуга стану - чверть рядка над і під текстом, у проміжках між рядками
+    v->w[STATUS_STATE].pad = v->fh / 4;
+}
+
+void status_view_set(status_view_t *v, int line, const char *text, uint16_t fg, uint16_t bg)
+{
+    status_widget_t *w = &v->w[line];
+
+    if (strncmp(w->text, text, sizeof(w->text) - 1) == 0 && w->fg == fg && w->bg == bg) {
+        return;
+    }
+    strncpy(w->text, text, sizeof(w->text) - 1);
+    w->text[sizeof(w->text) - 1] = '\0';
+    w->fg = fg;
+    w->bg = bg;
+    w->dirty = true;
+}
+
+static void fill(status_view_t *v, int x0, int y0, int x1, int y1, uint16_t color)
+{
+    if (x1 < x0 || y1 < y0) {
+        return;
+    }
+    lcdDrawFillRect(v->dev, x0, y0, x1, y1, color);
+}
+
+static void draw_widget(status_view_t *v, int line)
+{
+    status_widget_t *w = &v->w[line];
+    // Рядки розставлені, як у попередньому DrawText: через два рядки шрифту
+    int y = v->height / 2 + (2 * line - 3) * v->fh;
+    int top = y - (v->fh - 1);
+    int bottom = y;
+
+    // Новий текст по центру, обрізаний до ширини екрана
+    uint8_t text[STATUS_VIEW_TEXT];
+    size_t len = strlen(w->text);
+    if (len > (size_t)(v->width / v->fw)) {
+        len = v->width / v->fw;
+    }
+    memcpy(text, w->text, len);
+    text[len] = '\0';
+    int nx0 = (v->width - (int)len * v->fw) / 2;
+    int nx1 = nx0 + (int)len * v->fw - 1;
+
+    // Межі перемальовки: весь рядок при зміні фону, інакше старий і новий текст
+    int sx0, sx1;
+    if (w->bg != w->shown_bg) {
+        sx0 = 0;
+        sx1 = v->width - 1;
+    } else {
+        sx0 = nx0;
+        sx1 = nx1;
+        if (w->x1 >= w->x0) {
+            if (w->x0 < sx0) sx0 = w->x0;
+            if (w->x1 > sx1) sx1 = w->x1;
+        }
+    }
+
+    // Фон навколо тексту; сам текст малюється з фоном одним вікном на символ
+    if (sx1 >= sx0) {
+        fill(v, sx0, top - w->pad, sx1, top - 1, w->bg);
+        fill(v, sx0, bottom + 1, sx1, bottom + w->pad, w->bg);
+        if (len == 0) {
+            fill(v, sx0, top, sx1, bottom, w->bg);
+        } else {
+            fill(v, sx0, top, nx0 - 1, bottom, w->bg);
+            fill(v, nx1 + 1, top, sx1, bottom, w->bg);
+        }
+    }
+    if (len > 0) {
+        lcdSetFontDirection(v->dev, DIRECTION0);
+        lcdSetFontFill(v->dev, w->bg);
+        lcdDrawString(v->dev, v->fx, nx0, y, text, w->fg);
+    }
+
+    w->shown_bg = w->bg;
+    w->x0 = nx0;
+    w->x1 = nx1;
+    w->dirty = false;
+}
+
+int status_view_flush(status_view_t *v)
+{
+    int drawn = 0;
+
+    if (v->full) {
+        lcdFillScreen(v->dev, v->bg);
+        for (int i = 0; i < STATUS_VIEW_LINES; i++) {
+            // Екран щойно залитий: віджети з фоном екрана малюють лише текст
+            v->w[i].shown_bg = v->bg;
+            v->w[i].x0 = 0;
+            v->w[i].x1 = -1;
+            v->w[i].dirty = true;
+        }
+        v->full = false;
+    }
+    for (int i = 0; i < STATUS_VIEW_LINES; i++) {
+        if (v->w[i].dirty) {
+            draw_widget(v, i);
+            drawn++;
+        }
+    }
+    if (drawn > 0) {
+        lcdDrawFinish(v->dev);
+        v->flushes++;
+        v->widgets_drawn += drawn;
+    }
+    return drawn;
+}
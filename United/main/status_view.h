@@ -0,0 +1,65 @@
+#ifndef MAIN_STATUS_VIEW_H_
+#define MAIN_STATUS_VIEW_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "st7789.h"
+
+// Екран стану з пам'яттю показаного. Кожен рядок - віджет: поки текст і
+// кольори ті самі, він не малюється. Змінений віджет перемальовується лише в
+// межах старого і нового тексту, а не весь екран.
+//
+// Стан (передача, прийом) показується смугою власного кольору навколо рядка
+// стану, тож його зміна - це одна смуга, а не заливка всього екрана.
+
+enum {
+    STATUS_TITLE,
+    STATUS_ROLE,
+    STATUS_STATE,
+    STATUS_CRYPTO,
+    STATUS_LINK,
+    STATUS_VIEW_LINES
+};
+
+#define STATUS_VIEW_TEXT 24
+
+typedef struct {
+    char text[STATUS_VIEW_TEXT];
+    uint16_t fg;
+    uint16_t bg;
+    uint8_t pad;                // Рядків фону над і під текстом
+    bool dirty;
+
+    // Що зараз на екрані
+    uint16_t shown_bg;
+    int16_t x0, x1;             // Стовпці тексту, x1 < x0 - порожньо
+} status_widget_t;
+
+typedef struct {
+    TFT_t *dev;
+    FontxFile *fx;
+    uint16_t width;
+    uint16_t height;
+    uint8_t fw;
+    uint8_t fh;
+    uint16_t bg;                // Фон екрана
+    bool full;                  // Потрібна повна перемальовка
+    status_widget_t w[STATUS_VIEW_LINES];
+
+    // Лічильники
+    uint32_t flushes;
+    uint32_t widgets_drawn;
+} status_view_t;
+
+// Перше status_view_flush заливає екран кольором bg і малює всі віджети
+void status_view_init(status_view_t *v, TFT_t *dev, FontxFile *fx, uint16_t width, uint16_t height, uint16_t bg);
+
+// Новий вміст рядка. Віджет стає брудним, лише якщо щось змінилось
+void status_view_set(status_view_t *v, int line, const char *text, uint16_t fg, uint16_t bg);
+
+// Малює брудні віджети. Повертає їх кількість
+int status_view_flush(status_view_t *v);
+
+#endif /* MAIN_STATUS_VIEW_H_ */
@@ -0,0 +1,63 @@
+#include <string.h>
+
+#include "nvs.h"
+
+#include "wifi_cache.h"
+
+#define WIFI_CACHE_NAMESPACE "wifi_cache"
+#define WIFI_CACHE_KEY "ap"
+
+esp_err_t wifi_cache_load(wifi_cache_t *cache)
+{
+    nvs_handle_t nvs;
+    size_t len = sizeof(*cache);
+
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    err = nvs_get_blob(nvs, WIFI_CACHE_KEY, cache, &len);
+    nvs_close(nvs);
+
+    if (err != ESP_OK || len != sizeof(*cache) || cache->version != WIFI_CACHE_VERSION ||
+        cache->channel == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t wifi_cache_save(const wifi_cache_t *cache)
+{
+    wifi_cache_t stored;
+    wifi_cache_t fresh = *cache;
+
+    fresh.version = WIFI_CACHE_VERSION;
+    if (wifi_cache_load(&stored) == ESP_OK && memcmp(&stored, &fresh, sizeof(fresh)) == 0) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs, WIFI_CACHE_KEY, &fresh, sizeof(fresh));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+esp_err_t wifi_cache_clear(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    nvs_erase_key(nvs, WIFI_CACHE_KEY);
+    err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
@@ -0,0 +1,28 @@
+#ifndef MAIN_WIFI_CACHE_H_
+#define MAIN_WIFI_CACHE_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Параметри останнього підключення до точки доступу, збережені в NVS.
+// На наступному старті станція підключається до відомого BSSID на відомому
+// каналі без сканування. Адресу не зберігаємо: DHCP клієнт сам пам'ятає
+// останню оренду (CONFIG_LWIP_DHCP_RESTORE_LAST_IP) і підтверджує її одним
+// запитом INIT-REBOOT без перевірки ARP, а далі продовжує її як завжди.
+
+#define WIFI_CACHE_VERSION 2
+
+typedef struct {
+    uint8_t version;
+    uint8_t channel;
+    uint8_t bssid[6];
+} wifi_cache_t;
+
+// ESP_ERR_NOT_FOUND, якщо збережених параметрів немає або вони іншого формату
+esp_err_t wifi_cache_load(wifi_cache_t *cache);
+// Запис лише за зміни, щоб не зношувати флеш при кожному підключенні
+esp_err_t wifi_cache_save(const wifi_cache_t *cache);
+esp_err_t wifi_cache_clear(void);
+
+#endif /* MAIN_WIFI_CACHE_H_ */
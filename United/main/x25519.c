@@ -0,0 +1,188 @@
+#include <string.h>
+
+#include "x25519.h"
+
+// Елемент поля GF(2^255 - 19): 16 розрядів по 16 біт із запасом на перенесення
+typedef int64_t fe_t[16];
+
+static const fe_t fe_121665 = { 0xDB41, 1 };
+
+static void fe_carry(fe_t o)
+{
+    for (int i = 0; i < 16; i++) {
+        o[i] += 1 << 16;
+        int64_t c = o[i] >> 16;
+        // Перенесення зі старшого розряду повертається в молодший помноженим на 38 (2^256 = 38)
+        if (i < 15) {
+            o[i + 1] += c - 1;
+        } else {
+            o[0] += 38 * (c - 1);
+        }
+        o[i] -= c * 65536;
+    }
+}
+
+// Обмін p і q, якщо b = 1, без розгалужень
+static void fe_cswap(fe_t p, fe_t q, int b)
+{
+    int64_t mask = ~((int64_t)b - 1);
+
+    for (int i = 0; i < 16; i++) {
+        int64_t t = mask & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+static void fe_pack(uint8_t *out, const fe_t n)
+{
+    fe_t m, t;
+
+    memcpy(t, n, sizeof(fe_t));
+    fe_carry(t);
+    fe_carry(t);
+    fe_carry(t);
+    // Дворазове віднімання модуля, якщо значення не менше за нього
+    for (int j = 0; j < 2; j++) {
+        m[0] = t[0] - 0xffed;
+        for (int i = 1; i < 15; i++) {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        int b = (int)((m[15] >> 16) & 1);
+        m[14] &= 0xffff;
+        fe_cswap(t, m, 1 - b);
+    }
+    for (int i = 0; i < 16; i++) {
+        out[2 * i] = (uint8_t)t[i];
+        out[2 * i + 1] = (uint8_t)(t[i] >> 8);
+    }
+}
+
+static void fe_unpack(fe_t o, const uint8_t *in)
+{
+    for (int i = 0; i < 16; i++) {
+        o[i] = in[2 * i] + ((int64_t)in[2 * i + 1] << 8);
+    }
+    o[15] &= 0x7fff;
+}
+
+static void fe_add(fe_t o, const fe_t a, const fe_t b)
+{
+    for (int i = 0; i < 16; i++) {
+        o[i] = a[i] + b[i];
+    }
+}
+
+static void fe_sub(fe_t o, const fe_t a, const fe_t b)
+{
+    for (int i = 0; i < 16; i++) {
+        o[i] = a[i] - b[i];
+    }
+}
+
+static void fe_mul(fe_t o, const fe_t a, const fe_t b)
+{
+    int64_t t[31] = { 0 };
+
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 16; j++) {
+            t[i + j] += a[i] * b[j];
+        }
+    }
+    for (int i = 0; i < 15; i++) {
+        t[i] += 38 * t[i + 16];
+    }
+    memcpy(o, t, sizeof(fe_t));
+    fe_carry(o);
+    fe_carry(o);
+}
+
+static void fe_sq(fe_t o, const fe_t a)
+{
+    fe_mul(o, a, a);
+}
+
+// Обернений елемент: a^(p-2)
+static void fe_inv(fe_t o, const fe_t a)
+{
+    fe_t c;
+
+    memcpy(c, a, sizeof(fe_t));
+    for (int i = 253; i >= 0; i--) {
+        fe_sq(c, c);
+        if (i != 2 && i != 4) {
+            fe_mul(c, c, a);
+        }
+    }
+    memcpy(o, c, sizeof(fe_t));
+}
+
+// Сходи Монтгомері по координаті u
+static void scalarmult(uint8_t out[X25519_KEY_SIZE], const uint8_t scalar[X25519_KEY_SIZE],
+                       const uint8_t point[X25519_KEY_SIZE])
+{
+    uint8_t z[X25519_KEY_SIZE];
+    fe_t x, a, b, c, d, e, f;
+
+    memcpy(z, scalar, sizeof(z));
+    z[31] = (z[31] & 127) | 64;
+    z[0] &= 248;
+    fe_unpack(x, point);
+    memcpy(b, x, sizeof(fe_t));
+    memset(a, 0, sizeof(fe_t));
+    memset(c, 0, sizeof(fe_t));
+    memset(d, 0, sizeof(fe_t));
+    a[0] = 1;
+    d[0] = 1;
+
+    for (int i = 254; i >= 0; i--) {
+        int bit = (z[i >> 3] >> (i & 7)) & 1;
+        fe_cswap(a, b, bit);
+        fe_cswap(c, d, bit);
+        fe_add(e, a, c);
+        fe_sub(a, a, c);
+        fe_add(c, b, d);
+        fe_sub(b, b, d);
+        fe_sq(d, e);
+        fe_sq(f, a);
+        fe_mul(a, c, a);
+        fe_mul(c, b, e);
+        fe_add(e, a, c);
+        fe_sub(a, a, c);
+        fe_sq(b, a);
+        fe_sub(c, d, f);
+        fe_mul(a, c, fe_121665);
+        fe_add(a, a, d);
+        fe_mul(c, c, a);
+        fe_mul(a, d, f);
+        fe_mul(d, b, x);
+        fe_sq(b, e);
+        fe_cswap(a, b, bit);
+        fe_cswap(c, d, bit);
+    }
+    fe_inv(c, c);
+    fe_mul(a, a, c);
+    fe_pack(out, a);
+    memset(z, 0, sizeof(z));
+}
+
+void x25519_public(uint8_t pub[X25519_KEY_SIZE], const uint8_t secret[X25519_KEY_SIZE])
+{
+    static const uint8_t base[X25519_KEY_SIZE] = { 9 };
+
+    scalarmult(pub, secret, base);
+}
+
+bool x25519_shared(uint8_t shared[X25519_KEY_SIZE], const uint8_t secret[X25519_KEY_SIZE],
+                   const uint8_t peer_pub[X25519_KEY_SIZE])
+{
+    uint8_t acc = 0;
+
+    scalarmult(shared, secret, peer_pub);
+    for (int i = 0; i < X25519_KEY_SIZE; i++) {
+        acc |= shared[i];
+    }
+    return acc != 0;
+}
@@ -0,0 +1,20 @@
+#ifndef MAIN_X25519_H_
+#define MAIN_X25519_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Обмін ключами X25519 (RFC 7748). Компактна реалізація зі сталим часом
+// виконання, без таблиць і динамічної пам'яті. Одне множення займає десятки
+// мілісекунд на ESP32, тому викликається лише з фонової задачі.
+
+#define X25519_KEY_SIZE 32
+
+// Відкритий ключ з таємного (32 випадкові байти)
+void x25519_public(uint8_t pub[X25519_KEY_SIZE], const uint8_t secret[X25519_KEY_SIZE]);
+
+// Спільний секрет. Повертає false для відкритого ключа малого порядку (нульовий результат)
+bool x25519_shared(uint8_t shared[X25519_KEY_SIZE], const uint8_t secret[X25519_KEY_SIZE],
+                   const uint8_t peer_pub[X25519_KEY_SIZE]);
+
+#endif /* MAIN_X25519_H_ */
@@ -0,0 +1,152 @@
+// Пакетне AES-128-ECB: випадкові набори фрагментів (зокрема на місці)
+// звіряються з EVP_aes_128_ecb з OpenSSL і розшифровуються назад, довжина
+// не кратна блоку відкидається без запису. Друкує вартість шифрування
+// пакета з кадром 1 КБ і копією FEC проти окремого ключа на кожен фрагмент.
+#include <string.h>
+#include <stdlib.h>
+#include <openssl/evp.h>
+
+#include "check.h"
+#include "aes_batch.h"
+
+#define SEGS 8
+#define SEG_MAX 1024
+#define ROUNDS 2000
+
+static uint8_t in[SEGS][SEG_MAX], out[SEGS][SEG_MAX], ref[SEGS][SEG_MAX];
+
+static void hex(uint8_t *dst, const char *s)
+{
+    for (size_t i = 0; s[2 * i]; i++) {
+        sscanf(s + 2 * i, "%2hhx", &dst[i]);
+    }
+}
+
+static void evp_ecb(const uint8_t *key, const uint8_t *src, uint8_t *dst, size_t len)
+{
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int n = 0;
+    CHECK(ctx != NULL);
+    CHECK(EVP_EncryptInit_ex(ctx, EVP_aes_128_ecb(), NULL, key, NULL));
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
+    CHECK(EVP_EncryptUpdate(ctx, dst, &n, src, (int)len));
+    CHECK_EQ(n, len);
+    EVP_CIPHER_CTX_free(ctx);
+}
+
+// Як було до пакетного шифрування: розклад ключа на кожен фрагмент
+static void per_segment(const uint8_t *key, const uint8_t *src, uint8_t *dst, size_t len)
+{
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key, AES_BATCH_KEY_SIZE * 8);
+    for (size_t off = 0; off < len; off += AES_BATCH_BLOCK) {
+        mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, src + off, dst + off);
+    }
+    mbedtls_aes_free(&aes);
+}
+
+static void check_batches(void)
+{
+    uint8_t keys[2][AES_BATCH_KEY_SIZE];
+    aes_batch_t enc, dec;
+    aes_batch_seg_t segs[SEGS];
+
+    // FIPS-197, додаток C.1
+    uint8_t block[AES_BATCH_BLOCK], expect[AES_BATCH_BLOCK];
+    hex(keys[0], "000102030405060708090a0b0c0d0e0f");
+    hex(block, "00112233445566778899aabbccddeeff");
+    hex(expect, "69c4e0d86a7b0430d8cdb78070b4c55a");
+    aes_batch_init(&enc);
+    aes_batch_setkey(&enc, keys[0], AES_BATCH_ENCRYPT);
+    CHECK(aes_batch_crypt(&enc, block, block, sizeof(block)));
+    CHECK(memcmp(block, expect, sizeof(block)) == 0);
+
+    for (int i = 0; i < AES_BATCH_KEY_SIZE; i++) {
+        keys[1][i] = (uint8_t)(i * 3 + 1);
+    }
+    aes_batch_init(&dec);
+    srand(5);
+
+    for (int round = 0; round < ROUNDS; round++) {
+        const uint8_t *key = keys[(round / 4) & 1];
+        int count = 1 + rand() % SEGS;
+
+        for (int j = 0; j < count; j++) {
+            size_t len = AES_BATCH_BLOCK * (rand() % (SEG_MAX / AES_BATCH_BLOCK + 1));
+            for (size_t k = 0; k < len; k++) {
+                in[j][k] = (uint8_t)rand();
+            }
+            evp_ecb(key, in[j], ref[j], len);
+            bool in_place = rand() & 1;
+            if (in_place) {
+                memcpy(out[j], in[j], len);
+            }
+            segs[j] = (aes_batch_seg_t){ .in = in_place ? out[j] : in[j], .out = out[j], .len = len };
+        }
+
+        aes_batch_setkey(&enc, key, AES_BATCH_ENCRYPT);
+        CHECK(aes_batch_run(&enc, segs, count));
+        for (int j = 0; j < count; j++) {
+            CHECK(memcmp(out[j], ref[j], segs[j].len) == 0);
+            segs[j].in = out[j];
+        }
+        aes_batch_setkey(&dec, key, AES_BATCH_DECRYPT);
+        CHECK(aes_batch_run(&dec, segs, count));
+        for (int j = 0; j < count; j++) {
+            CHECK(memcmp(out[j], in[j], segs[j].len) == 0);
+        }
+    }
+    // Ключ змінюється кожні чотири раунди; перші чотири - з ключем вектора FIPS
+    CHECK_EQ(enc.key_loads, ROUNDS / 4);
+
+    // Другий фрагмент не кратний блоку - не змінюється жоден
+    uint32_t blocks = enc.blocks;
+    memset(out[0], 0xEE, 32);
+    memset(out[1], 0xEE, 32);
+    segs[0] = (aes_batch_seg_t){ .in = in[0], .out = out[0], .len = 32 };
+    segs[1] = (aes_batch_seg_t){ .in = in[1], .out = out[1], .len = 15 };
+    CHECK(!aes_batch_run(&enc, segs, 2));
+    CHECK_EQ(enc.blocks, blocks);
+    for (int k = 0; k < 32; k++) {
+        CHECK_EQ(out[0][k], 0xEE);
+        CHECK_EQ(out[1][k], 0xEE);
+    }
+
+    aes_batch_free(&enc);
+    aes_batch_free(&dec);
+    printf("aes_batch: %d random batches match OpenSSL and decrypt back\n", ROUNDS);
+}
+
+int main(int argc, char **argv)
+{
+    long packets = bench_iters(argc, argv, 20000);
+    uint8_t key[AES_BATCH_KEY_SIZE] = {7};
+    aes_batch_t enc;
+
+    check_batches();
+
+    // Пакет: кадр 1 КБ і копія попереднього кадру для FEC одним ключем
+    double t0 = now_us();
+    for (long i = 0; i < packets; i++) {
+        per_segment(key, in[0], out[0], SEG_MAX);
+        per_segment(key, in[1], out[1], SEG_MAX);
+    }
+    double t1 = now_us();
+    aes_batch_init(&enc);
+    for (long i = 0; i < packets; i++) {
+        aes_batch_seg_t segs[2] = {
+            { .in = in[0], .out = out[0], .len = SEG_MAX },
+            { .in = in[1], .out = out[1], .len = SEG_MAX },
+        };
+        aes_batch_setkey(&enc, key, AES_BATCH_ENCRYPT);
+        CHECK(aes_batch_run(&enc, segs, 2));
+    }
+    double t2 = now_us();
+    CHECK_EQ(enc.key_loads, 1);
+    aes_batch_free(&enc);
+
+    printf("aes_batch: 1 KB frame + FEC copy, key per segment %.2f us, batch %.2f us per packet\n",
+           (t1 - t0) / packets, (t2 - t1) / packets);
+    return 0;
+}
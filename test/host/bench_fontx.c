@@ -0,0 +1,146 @@
+// Гліфи шрифту FONTX: з таблиці в RAM, з LRU-кешу великого шрифту і
+// напряму з файлу (fseek і fread на кожен символ, як було раніше). Усі 256
+// гліфів мають збігатися з файлом у кожному режимі. Друкує читання файлу і
+// час на один екран стану (п'ять рядків).
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "fontx.h"
+#include "test_font.h"
+
+#define BIG_W 32
+#define BIG_H 32
+#define BIG_FSZ ((BIG_W + 7) / 8 * BIG_H)
+
+static const char *screen[] = {
+    "Walkie-Talkie",
+    "Role: client",
+    "RX 3 peers",
+    "AES group key",
+    "Link 98% -71dBm",
+};
+#define SCREEN_LINES (sizeof(screen) / sizeof(screen[0]))
+
+static char small_path[] = "/tmp/fontx_small_XXXXXX";
+static char big_path[] = "/tmp/fontx_big_XXXXXX";
+
+static void write_file(char *path, const uint8_t *data, size_t size)
+{
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    CHECK_EQ(write(fd, data, size), (long)size);
+    close(fd);
+}
+
+// Кількість гліфів, отриманих за екран
+static int draw_screen(FontxFile *fx)
+{
+    uint8_t glyph[FontxGlyphBufSize];
+    uint8_t w, h;
+    int n = 0;
+    for (size_t l = 0; l < SCREEN_LINES; l++) {
+        for (const char *p = screen[l]; *p; p++, n++) {
+            CHECK(GetFontx(fx, (uint8_t)*p, glyph, &w, &h));
+        }
+    }
+    return n;
+}
+
+// Усі гліфи збігаються з байтами файлу data
+static void check_glyphs(FontxFile *fx, const uint8_t *data, int fsz)
+{
+    uint8_t glyph[FontxGlyphBufSize];
+    uint8_t w, h;
+    for (int c = 0; c < FontxAnkGlyphs; c++) {
+        CHECK(GetFontx(fx, (uint8_t)c, glyph, &w, &h));
+        CHECK(memcmp(glyph, data + 17 + c * fsz, fsz) == 0);
+    }
+}
+
+static double time_screens(FontxFile *fx, long screens, uint32_t *reads)
+{
+    uint32_t reads0 = fx[0].reads;
+    double t0 = now_us();
+    for (long i = 0; i < screens; i++) {
+        draw_screen(fx);
+    }
+    double us = (now_us() - t0) / screens;
+    *reads = (fx[0].reads - reads0) / screens;
+    return us;
+}
+
+int main(int argc, char **argv)
+{
+    long screens = bench_iters(argc, argv, 2000);
+    FontxFile fx[2];
+    uint32_t reads;
+
+    test_font_init();
+    const FontxEmbedded *small = FindFontxEmbedded("ILGH16XB");
+    CHECK(small != NULL);
+    write_file(small_path, small->data, small->size);
+
+    // Великий шрифт 32x32: таблиця більша за FontxTableMax, тож LRU-кеш
+    size_t big_size = 17 + (size_t)FontxAnkGlyphs * BIG_FSZ;
+    uint8_t *big = malloc(big_size);
+    CHECK(big != NULL);
+    memcpy(big, small->data, 14);
+    big[14] = BIG_W;
+    big[15] = BIG_H;
+    big[16] = 0;
+    for (size_t i = 17; i < big_size; i++) {
+        big[i] = (uint8_t)(i * 131 + (i >> 7));
+    }
+    write_file(big_path, big, big_size);
+
+    // Напряму з файлу, без LoadFontx: по fseek і fread на кожен символ
+    memset(fx, 0, sizeof(fx));
+    fx[0].path = small_path;
+    fx[1].path = "";
+    check_glyphs(fx, small->data, fx[0].fsz);
+    double file_us = time_screens(fx, screens, &reads);
+    CHECK_EQ(reads, draw_screen(fx));
+    printf("fontx: from file    %3u glyph reads (fseek+fread) per screen, %.2f us\n", reads, file_us);
+    CloseFontx(&fx[0]);
+
+    // Файл 8x16 цілком у таблиці в RAM, файл закрито
+    InitFontx(fx, small_path, "");
+    CHECK(fx[0].table != NULL);
+    CHECK(!fx[0].opened);
+    check_glyphs(fx, small->data, fx[0].fsz);
+    double table_us = time_screens(fx, screens, &reads);
+    CHECK_EQ(reads, 0);
+    printf("fontx: RAM table    %3u glyph reads (fseek+fread) per screen, %.2f us\n", reads, table_us);
+    FreeFontx(fx);
+
+    // Вбудований шрифт: таблиця на місці у флеш-пам'яті
+    InitFontxMem(fx, "ILGH16XB", "");
+    CHECK(fx[0].table == small->data + 17);
+    check_glyphs(fx, small->data, fx[0].fsz);
+    double mem_us = time_screens(fx, screens, &reads);
+    CHECK_EQ(reads, 0);
+    printf("fontx: embedded     %3u glyph reads (fseek+fread) per screen, %.2f us\n", reads, mem_us);
+    FreeFontx(fx);
+
+    // 32x32: з файлу лише різні символи першого екрана, далі - з кешу
+    InitFontx(fx, big_path, "");
+    CHECK(fx[0].table == NULL);
+    CHECK(fx[0].cache != NULL);
+    int glyphs = draw_screen(fx);
+    uint32_t cold = fx[0].reads;
+    CHECK(cold < (uint32_t)glyphs);
+    CHECK(cold <= FontxCacheSlots);
+    double lru_us = time_screens(fx, screens, &reads);
+    CHECK_EQ(reads, 0);
+    check_glyphs(fx, big, BIG_FSZ);
+    printf("fontx: 32x32 LRU    %3u glyph reads (fseek+fread) per screen once warm (%u cold), %.2f us\n", reads, cold, lru_us);
+    FreeFontx(fx);
+
+    unlink(small_path);
+    unlink(big_path);
+    free(big);
+    return 0;
+}
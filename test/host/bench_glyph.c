@@ -0,0 +1,97 @@
+// Текст на справжньому st7789.c з емулятором панелі: символ одним вікном
+// (задано заливку шрифту) проти попіксельного шляху (прозорий текст) у всіх
+// чотирьох напрямках. Текст має збігатися, кожен символ вікном - не більше
+// шести транзакцій. Друкує транзакції, байти і час на рядок.
+#include <string.h>
+
+#include "check.h"
+#include "lcd_emu.h"
+#include "test_font.h"
+#include "st7789.h"
+
+#define WIDTH 240
+#define HEIGHT 240
+#define TEXT "Walkie-Talkie"
+#define TX_PER_CHAR 6                   // CASET, дві адреси, RASET, RAMWR, дані
+
+static TFT_t dev;
+static FontxFile fx[2];
+static uint16_t per_pixel[LCD_EMU_SIZE][LCD_EMU_SIZE];
+
+// Попіксельний шлях на 90 і 180 градусів кладе символ на 1 і 2 пікселі
+// за межі власного прямокутника заливки, вікно лишається в ньому
+static const int per_pixel_shift[4][2] = { {0, 0}, {1, 0}, {0, 2}, {0, 0} };
+
+// Пікселі тексту, що не збігаються між шляхами з урахуванням зсуву
+static int ink_diff(int dir)
+{
+    int dx = per_pixel_shift[dir][0], dy = per_pixel_shift[dir][1];
+    int diff = 0, ink = 0;
+    for (int y = 0; y + dy < HEIGHT; y++) {
+        for (int x = 0; x + dx < WIDTH; x++) {
+            diff += (per_pixel[y + dy][x + dx] == WHITE) != (lcd_emu.gram[y][x] == WHITE);
+            ink += lcd_emu.gram[y][x] == WHITE;
+        }
+    }
+    CHECK(ink > 0);
+    return diff;
+}
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    double us;
+} draw_cost_t;
+
+static draw_cost_t draw(int dir, bool fill, long repeats)
+{
+    draw_cost_t cost;
+
+    lcd_emu_reset(0);
+    lcdFillScreen(&dev, BLUE);
+    lcdSetFontDirection(&dev, dir);
+    if (fill) {
+        lcdSetFontFill(&dev, BLUE);
+    } else {
+        lcdUnsetFontFill(&dev);
+    }
+
+    lcd_emu_reset_counters();
+    lcdDrawString(&dev, fx, WIDTH / 2, HEIGHT / 2, (uint8_t *)TEXT, WHITE);
+    cost.transactions = lcd_emu.transactions;
+    cost.bytes = lcd_emu.bytes;
+
+    double t0 = now_us();
+    for (long i = 0; i < repeats; i++) {
+        lcdDrawString(&dev, fx, WIDTH / 2, HEIGHT / 2, (uint8_t *)TEXT, WHITE);
+    }
+    cost.us = (now_us() - t0) / repeats;
+    return cost;
+}
+
+int main(int argc, char **argv)
+{
+    long repeats = bench_iters(argc, argv, 200);
+    size_t chars = strlen(TEXT);
+
+    test_font_init();
+    InitFontxMem(fx, "ILGH16XB", "");
+    CHECK(fx[0].valid);
+    spi_master_init(&dev, 23, 18, -1, LCD_EMU_DC, -1, -1);
+    lcdInit(&dev, WIDTH, HEIGHT, 0, 0);
+
+    for (int dir = 0; dir < 4; dir++) {
+        draw_cost_t slow = draw(dir, false, repeats);
+        memcpy(per_pixel, lcd_emu.gram, sizeof(per_pixel));
+        draw_cost_t fast = draw(dir, true, repeats);
+
+        CHECK(fast.transactions <= chars * TX_PER_CHAR);
+        CHECK_EQ(ink_diff(dir), 0);
+        CHECK(fast.bytes * 2 < slow.bytes);
+
+        printf("glyph: direction %d, \"%s\": per pixel %u transactions %u B %.1f us, "
+               "window %u transactions %u B %.1f us\n",
+               dir, TEXT, slow.transactions, slow.bytes, slow.us, fast.transactions, fast.bytes, fast.us);
+    }
+    return 0;
+}
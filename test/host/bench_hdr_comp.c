@@ -0,0 +1,136 @@
+// Стиснення заголовків: поток через 20% випадкових втрат і паузи довші за
+// HDR_COMP_CONTEXT_TIMEOUT_MS, кожен прийнятий заголовок має відновитися точно.
+// Друкує вартість запису і відновлення заголовка та байти заголовків за
+// секунду на кожному рівні якості до і після стиснення.
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "hdr_comp.h"
+#include "rate_ctl.h"
+
+#define FRAME_SAMPLES 512
+#define FRAME_BYTES (FRAME_SAMPLES * 2)
+#define FRAME_MS 12                     // 512 відліків при 44100 Гц, округлено
+#define LOSS_PERCENT 20
+#define PAUSE_EVERY 5000
+#define PAUSE_MS 3000
+#define UDP_IP_OVERHEAD 28
+
+int main(int argc, char **argv)
+{
+    long packets = bench_iters(argc, argv, 200000);
+    hdr_comp_tx_t tx;
+    hdr_comp_rx_t rx;
+    uint8_t buf[PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE];
+    uint32_t ts = 0xFFFFF000u;          // Переповнення часу і номера по дорозі
+    uint16_t seq = 65000;
+    long ok = 0, lost = 0, no_context = 0;
+
+    hdr_comp_tx_init(&tx);
+    hdr_comp_rx_init(&rx);
+    srand(1);
+
+    for (long i = 0; i < packets; i++) {
+        pkt_header_t h = {.type = PKT_TYPE_AUDIO, .group = 3, .node = 0x1234, .seq = seq++, .timestamp = ts};
+        pkt_audio_desc_t d = {.decim_shift = i & 1, .fec = (i >> 1) & 1, .frames = 1 + (i % 2), .key = i % 4};
+        ts += FRAME_MS;
+        if (i % PAUSE_EVERY == PAUSE_EVERY - 1) {
+            ts += PAUSE_MS;
+        }
+
+        size_t n = hdr_comp_write(&tx, buf, &h, &d);
+        if (rand() % 100 < LOSS_PERCENT) {
+            lost++;
+            continue;
+        }
+
+        pkt_header_t o;
+        pkt_audio_desc_t od;
+        pkt_compact_t c;
+        if (pkt_read_compact(buf, n, &c)) {
+            CHECK_EQ(n, PKT_COMPACT_SIZE);
+            if (!hdr_comp_rx_expand(&rx, &c, h.timestamp, &o, &od)) {
+                no_context++;
+                continue;
+            }
+        } else {
+            CHECK(pkt_read_header(buf, n, &o));
+            CHECK(pkt_read_audio_desc(buf + PKT_HEADER_SIZE, n - PKT_HEADER_SIZE, &od));
+        }
+        hdr_comp_rx_update(&rx, &o, h.timestamp);
+
+        CHECK_EQ(o.seq, h.seq);
+        CHECK_EQ(o.timestamp, h.timestamp);
+        CHECK_EQ(o.node, h.node);
+        CHECK_EQ(o.group, h.group);
+        CHECK_EQ(od.frames, d.frames);
+        CHECK_EQ(od.decim_shift, d.decim_shift);
+        CHECK_EQ(od.fec, d.fec);
+        CHECK_EQ(od.key, d.key);
+        ok++;
+    }
+    // Без контексту лишаються тільки пакети після пауз, доки не дійде повний заголовок
+    CHECK(no_context < (packets / PAUSE_EVERY + 1) * HDR_COMP_REFRESH_PACKETS * 2);
+    CHECK(tx.compact_sent > tx.full_sent * (HDR_COMP_REFRESH_PACKETS - 2));
+    printf("hdr_comp: %ld packets, %ld lost, %ld without context, %ld restored; full %u compact %u\n",
+           packets, lost, no_context, ok, tx.full_sent, tx.compact_sent);
+
+    // Межа поля кадрів: 8 кадрів ще стиснутим заголовком, 9 - вже повним.
+    // Перший пакет після ініціалізації завжди повний, далі до оновлення далеко
+    hdr_comp_tx_init(&tx);
+    for (int frames = 1; frames <= PKT_COMPACT_MAX_FRAMES + 1; frames++) {
+        pkt_header_t h = {.type = PKT_TYPE_AUDIO, .group = 3, .node = 0x1234, .seq = seq++, .timestamp = ts};
+        pkt_audio_desc_t d = {.frames = frames};
+        pkt_audio_desc_t od;
+        pkt_compact_t c;
+        ts += FRAME_MS;
+        size_t n = hdr_comp_write(&tx, buf, &h, &d);
+        if (frames > PKT_COMPACT_MAX_FRAMES) {
+            CHECK_EQ(n, PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE);
+            CHECK(pkt_read_audio_desc(buf + PKT_HEADER_SIZE, n - PKT_HEADER_SIZE, &od));
+            CHECK_EQ(od.frames, frames);
+        } else if (frames > 1) {
+            CHECK(pkt_read_compact(buf, n, &c));
+            CHECK_EQ(c.desc.frames, frames);
+        }
+    }
+
+    // Вартість запису і відновлення стиснутого заголовка
+    pkt_header_t h = {.type = PKT_TYPE_AUDIO, .group = 3, .node = 0x1234, .seq = 1, .timestamp = 1000};
+    pkt_audio_desc_t d = {.frames = 1};
+    pkt_header_t o;
+    pkt_audio_desc_t od;
+    pkt_compact_t c;
+    hdr_comp_tx_init(&tx);
+    hdr_comp_rx_init(&rx);
+    hdr_comp_write(&tx, buf, &h, &d);
+    hdr_comp_rx_update(&rx, &h, h.timestamp);
+    double t0 = now_us();
+    for (long i = 0; i < packets; i++) {
+        h.seq++;
+        h.timestamp += FRAME_MS;
+        size_t n = hdr_comp_write(&tx, buf, &h, &d);
+        if (pkt_read_compact(buf, n, &c)) {
+            CHECK(hdr_comp_rx_expand(&rx, &c, h.timestamp, &o, &od));
+        } else {
+            CHECK(pkt_read_header(buf, n, &o));
+        }
+        hdr_comp_rx_update(&rx, &o, h.timestamp);
+    }
+    printf("hdr_comp: write+expand %.1f ns per packet\n", (now_us() - t0) * 1e3 / packets);
+
+    // Байти заголовків за секунду: кожен HDR_COMP_REFRESH_PACKETS-й пакет повний
+    double full = PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE;
+    double comp = (full + (HDR_COMP_REFRESH_PACKETS - 1) * (double)PKT_COMPACT_SIZE) / HDR_COMP_REFRESH_PACKETS;
+    for (int l = 0; l < RATE_LEVEL_COUNT; l++) {
+        const rate_level_t *lvl = &rate_levels[l];
+        double pps = 1000.0 / (FRAME_MS * lvl->frames_per_packet);
+        double body = (FRAME_BYTES >> lvl->decim_shift) * lvl->frames_per_packet * (lvl->fec ? 2 : 1);
+        double before = pps * (UDP_IP_OVERHEAD + full + body);
+        double after = pps * (UDP_IP_OVERHEAD + comp + body);
+        printf("level %d: %.1f pkt/s, headers %.0f -> %.1f B/s, on air %.0f -> %.0f B/s (-%.2f%%)\n",
+               l, pps, pps * full, pps * comp, before, after, 100 * (before - after) / before);
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+// Сеансові ключі: X25519 на векторах RFC 7748 (розділ 6.1), відмова від
+// відкритого ключа малого порядку, зміна ключа відправника без втрачених
+// кадрів при 10% втрат аудіо. Друкує вартість множення X25519 і вибору
+// ключа для одного пакета на передачі та прийомі.
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "keyx.h"
+#include "x25519.h"
+
+#define FRAME_MS 12
+#define CONTROL_EVERY 9                 // keyx оновлюється раз на стільки кадрів
+#define AUDIO_LOSS_PERCENT 10
+#define SIM_MS (10 * KEYX_REKEY_PERIOD_MS + 5000)
+
+static void hex(uint8_t *out, const char *s)
+{
+    for (size_t i = 0; s[2 * i]; i++) {
+        sscanf(s + 2 * i, "%2hhx", &out[i]);
+    }
+}
+
+static void check_rfc7748(void)
+{
+    uint8_t a[X25519_KEY_SIZE], b[X25519_KEY_SIZE], a_pub[X25519_KEY_SIZE], b_pub[X25519_KEY_SIZE];
+    uint8_t s1[X25519_KEY_SIZE], s2[X25519_KEY_SIZE], expect[X25519_KEY_SIZE];
+
+    hex(a, "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a");
+    hex(b, "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb");
+    x25519_public(a_pub, a);
+    x25519_public(b_pub, b);
+    hex(expect, "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a");
+    CHECK(memcmp(a_pub, expect, X25519_KEY_SIZE) == 0);
+    hex(expect, "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f");
+    CHECK(memcmp(b_pub, expect, X25519_KEY_SIZE) == 0);
+
+    CHECK(x25519_shared(s1, a, b_pub));
+    CHECK(x25519_shared(s2, b, a_pub));
+    hex(expect, "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742");
+    CHECK(memcmp(s1, expect, X25519_KEY_SIZE) == 0);
+    CHECK(memcmp(s2, expect, X25519_KEY_SIZE) == 0);
+
+    uint8_t zero[X25519_KEY_SIZE] = {0};
+    CHECK(!x25519_shared(s1, a, zero));
+}
+
+// Один відправник і один приймач: кожен прийнятий зашифрований пакет має
+// знайти рівно той ключ, яким його зашифровано
+static void check_rotation(void)
+{
+    keyx_tx_t tx;
+    keyx_peer_t at_tx, rx;
+    uint16_t seq = 0;
+    uint8_t ctr = 1;
+    long received = 0;
+
+    keyx_tx_init(&tx);
+    keyx_peer_init(&at_tx);
+    keyx_peer_init(&rx);
+    srand(7);
+
+    for (uint32_t now = 0; now < SIM_MS; now += FRAME_MS, seq++) {
+        if ((now / FRAME_MS) % CONTROL_EVERY == 0) {
+            if (keyx_tx_rekey_due(&tx, now)) {
+                uint8_t key[KEYX_KEY_SIZE], mac_key[KEYX_KEY_SIZE];
+                memset(key, ctr, sizeof(key));
+                memset(mac_key, ctr ^ 0xFF, sizeof(mac_key));
+                ctr++;
+                keyx_tx_prepare(&tx, key, mac_key);
+            }
+            const keyx_key_t *target = tx.next.valid ? &tx.next : &tx.cur;
+            if (target->valid && !keyx_peer_has(&at_tx, target)) {
+                keyx_peer_install(&rx, target->id, target->key, target->mac_key);
+                keyx_peer_ack(&at_tx, target->id);
+            }
+            keyx_tx_update(&tx, true, keyx_peer_has(&at_tx, &tx.cur), keyx_peer_has(&at_tx, &tx.next));
+        }
+
+        const keyx_key_t *k = keyx_tx_packet_key(&tx, seq, now);
+        if (!k || rand() % 100 < AUDIO_LOSS_PERCENT) {
+            continue;
+        }
+        const keyx_key_t *rk = keyx_peer_lookup(&rx, keyx_key_code(k));
+        CHECK(rk != NULL);
+        CHECK_EQ(rk->id, k->id);
+        CHECK(memcmp(rk->key, k->key, KEYX_KEY_SIZE) == 0);
+        CHECK(memcmp(rk->mac_key, k->mac_key, KEYX_KEY_SIZE) == 0);
+        keyx_peer_confirm(&rx, rk, seq);
+        received++;
+    }
+    CHECK_EQ(tx.rekeys, SIM_MS / KEYX_REKEY_PERIOD_MS + 1);
+    CHECK_EQ(rx.unknown_key, 0);
+    printf("keyx: %u sender keys over %d s, %ld packets received, none without a key\n",
+           tx.rekeys, SIM_MS / 1000, received);
+}
+
+int main(int argc, char **argv)
+{
+    long ops = bench_iters(argc, argv, 200);
+    uint8_t secret[X25519_KEY_SIZE], peer[X25519_KEY_SIZE], pub[X25519_KEY_SIZE], shared[X25519_KEY_SIZE];
+
+    check_rfc7748();
+    check_rotation();
+
+    for (int i = 0; i < X25519_KEY_SIZE; i++) {
+        secret[i] = (uint8_t)(i * 3 + 1);
+    }
+    x25519_public(peer, secret);
+    secret[0] ^= 0x55;
+
+    double t0 = now_us();
+    for (long i = 0; i < ops; i++) {
+        secret[1] = (uint8_t)i;
+        x25519_public(pub, secret);
+    }
+    double t1 = now_us();
+    for (long i = 0; i < ops; i++) {
+        secret[1] = (uint8_t)i;
+        CHECK(x25519_shared(shared, secret, peer));
+    }
+    double t2 = now_us();
+    printf("x25519: public %.1f us, shared %.1f us per operation\n", (t1 - t0) / ops, (t2 - t1) / ops);
+
+    // Вибір ключа на кожен пакет: передача, пошук на прийомі і підтвердження
+    keyx_tx_t tx;
+    keyx_peer_t rx;
+    uint8_t key[KEYX_KEY_SIZE] = {1};
+    long packets = ops * 50000;
+    keyx_tx_init(&tx);
+    keyx_peer_init(&rx);
+    keyx_tx_prepare(&tx, key, key);
+    keyx_tx_update(&tx, true, false, true);
+    keyx_peer_install(&rx, 0, key, key);
+
+    long found = 0;
+    t0 = now_us();
+    for (long i = 0; i < packets; i++) {
+        const keyx_key_t *k = keyx_tx_packet_key(&tx, (uint16_t)i, 0);
+        const keyx_key_t *rk = keyx_peer_lookup(&rx, keyx_key_code(k));
+        found += keyx_peer_confirm(&rx, rk, (uint16_t)i) == &rx.cur;
+    }
+    t1 = now_us();
+    CHECK_EQ(found, packets);
+    printf("keyx: key selection %.1f ns per packet (send+receive)\n", (t1 - t0) * 1e3 / packets);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Мікшер конференції: для 1..MIXER_MAX_SOURCES учасників міряє вартість
+// кадру - mixer_put_packet від кожного, mixer_tick і mixer_output для кожного.
+// Перед заміром суміш без власного голосу звіряється з прямим підсумовуванням
+// інших джерел (O(N^2)) з тим самим обмежувачем.
+#include <math.h>
+#include <string.h>
+
+#include "check.h"
+#include "mixer.h"
+
+static mixer_t mixer;
+static int16_t pcm[MIXER_MAX_SOURCES][MIXER_FRAME_SAMPLES];
+static int16_t out[MIXER_FRAME_SAMPLES];
+
+static int16_t saturate16(int64_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+static void check_outputs(int n)
+{
+    for (int ex = 0; ex < n; ex++) {
+        bool heard = mixer_output(&mixer, ex, out);
+        CHECK_EQ(heard, n > 1);
+        if (!heard) {
+            continue;
+        }
+        for (int k = 0; k < MIXER_FRAME_SAMPLES; k++) {
+            int32_t v = 0;
+            for (int s = 0; s < n; s++) {
+                if (s != ex) {
+                    v += pcm[s][k];
+                }
+            }
+            CHECK_EQ(out[k], saturate16(((int64_t)v * mixer.limiter_q15) >> 15));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long iters = bench_iters(argc, argv, 20000);
+
+    // Гучні різні тони: при чотирьох учасниках суміш перевантажена і працює обмежувач
+    for (int s = 0; s < MIXER_MAX_SOURCES; s++) {
+        for (int k = 0; k < MIXER_FRAME_SAMPLES; k++) {
+            pcm[s][k] = (int16_t)(12000 * sin(k * 0.03 * (s + 1)));
+        }
+    }
+
+    for (int n = 1; n <= MIXER_MAX_SOURCES; n++) {
+        uint16_t seq = 1;
+        mixer_init(&mixer);
+
+        // Заповнення джиттер-буфера: перші MIXER_JB_PREFILL кадрів тиші
+        for (int t = 0; t < MIXER_JB_PREFILL + 2; t++, seq++) {
+            for (int s = 0; s < n; s++) {
+                mixer_put_packet(&mixer, s, seq, 1, pcm[s], NULL);
+            }
+            CHECK_EQ(mixer_tick(&mixer), t < MIXER_JB_PREFILL ? 0 : n);
+        }
+        check_outputs(n);
+
+        double put_us = 0, mix_us = 0;
+        for (long it = 0; it < iters; it++, seq++) {
+            double t0 = now_us();
+            for (int s = 0; s < n; s++) {
+                mixer_put_packet(&mixer, s, seq, 1, pcm[s], NULL);
+            }
+            double t1 = now_us();
+            CHECK_EQ(mixer_tick(&mixer), n);
+            for (int s = 0; s < n; s++) {
+                mixer_output(&mixer, s, out);
+            }
+            mix_us += now_us() - t1;
+            put_us += t1 - t0;
+        }
+        check_outputs(n);
+        for (int s = 0; s < n; s++) {
+            CHECK_EQ(mixer.src[s].late, 0);
+            CHECK_EQ(mixer.src[s].resyncs, 0);
+        }
+        if (n == MIXER_MAX_SOURCES) {
+            CHECK(mixer.clipped > 0);
+        }
+
+        printf("mixer: N=%d put %.2f us, tick+outputs %.2f us per frame (%d samples)\n",
+               n, put_us / iters, mix_us / iters, MIXER_FRAME_SAMPLES);
+    }
+    return 0;
+}
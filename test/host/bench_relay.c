@@ -0,0 +1,100 @@
+// Навантаження на ретранслятор точки доступу: RELAY_MAX_STATIONS станцій на
+// loopback по черзі шлють аудіо кадри, ретранслятор у тому ж потоці
+// пересилає кожен усім іншим. Перевіряється, що кожна копія дійшла, пул не
+// переповнювався, а станція понад ліміт відкидається. Друкує пропускну
+// здатність пересилання в пакетах за секунду.
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "check.h"
+#include "relay.h"
+
+#define PORT 47310
+#define FRAME_LEN 1036          // Кадр повної частоти з заголовком і тегом
+#define SKIP_RC 77
+
+static int stations[RELAY_MAX_STATIONS + 1];
+static long delivered;
+
+static int station_socket(void)
+{
+    int big = 1 << 22;
+    int s = socket(AF_INET, SOCK_DGRAM, 0);
+    CHECK(s >= 0);
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, &big, sizeof(big));
+    fcntl(s, F_SETFL, O_NONBLOCK);
+    return s;
+}
+
+static void drain(void)
+{
+    uint8_t buf[RELAY_MAX_DATAGRAM];
+    for (int i = 0; i < RELAY_MAX_STATIONS; i++) {
+        while (recv(stations[i], buf, sizeof(buf), 0) > 0) {
+            delivered++;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long frames = bench_iters(argc, argv, 20000);
+    relay_t relay;
+    struct sockaddr_in hub = { .sin_family = AF_INET, .sin_port = htons(PORT) };
+    uint8_t frame[FRAME_LEN];
+
+    if (relay_init(&relay, PORT) < 0) {
+        return SKIP_RC;
+    }
+    hub.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    memset(frame, 0xA5, sizeof(frame));
+
+    // Реєстрація: перша датаграма кожної станції, п'ята - зайва
+    for (int i = 0; i <= RELAY_MAX_STATIONS; i++) {
+        stations[i] = station_socket();
+        CHECK_EQ(sendto(stations[i], frame, 16, 0, (struct sockaddr *)&hub, sizeof(hub)), 16);
+        while (relay.rx_packets < (uint32_t)i + 1) {
+            CHECK_EQ(relay_poll(&relay, 10), 0);
+        }
+    }
+    CHECK_EQ(relay.station_count, RELAY_MAX_STATIONS);
+    CHECK_EQ(relay.rejected, 1);
+    usleep(10000);
+    drain();
+    delivered = 0;
+    uint32_t forwarded0 = relay.forwarded;
+    uint32_t rx0 = relay.rx_packets;
+
+    double t0 = now_us();
+    for (long k = 0; k < frames; k++) {
+        CHECK_EQ(sendto(stations[k % RELAY_MAX_STATIONS], frame, sizeof(frame), 0, (struct sockaddr *)&hub, sizeof(hub)),
+                 (long)sizeof(frame));
+        while (relay.rx_packets - rx0 < (uint32_t)k + 1 || relay.pool_count > 0) {
+            CHECK_EQ(relay_poll(&relay, 10), 0);
+        }
+        drain();
+    }
+    double elapsed_us = now_us() - t0;
+    for (int tries = 0; tries < 100 && delivered < frames * (RELAY_MAX_STATIONS - 1); tries++) {
+        usleep(1000);
+        drain();
+    }
+
+    uint32_t forwarded = relay.forwarded - forwarded0;
+    CHECK_EQ(forwarded, frames * (RELAY_MAX_STATIONS - 1));
+    CHECK_EQ(delivered, frames * (RELAY_MAX_STATIONS - 1));
+    CHECK_EQ(relay.pool_overflows, 0);
+    CHECK_EQ(relay.tx_errors, 0);
+
+    printf("relay: %d stations, %ld frames of %d B, %u copies forwarded: %.0f packets/s, %.1f us per frame\n",
+           RELAY_MAX_STATIONS, frames, FRAME_LEN, forwarded, forwarded * 1e6 / elapsed_us, elapsed_us / frames);
+
+    for (int i = 0; i <= RELAY_MAX_STATIONS; i++) {
+        close(stations[i]);
+    }
+    relay_close(&relay);
+    return 0;
+}
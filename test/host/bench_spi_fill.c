@@ -0,0 +1,112 @@
+// Заливки на справжньому st7789.c з емулятором панелі: блокуючий шлях
+// (транзакція на стовпчик) проти чергованого (CONFIG_ASYNC_SPI, подвійний
+// буфер по LCD_CHUNK_SIZE). Кадр - заливка всього екрана і смуги різних
+// кольорів через lcdDrawFillRect. Емулятор виводить черговану транзакцію на
+// дріт лише тоді, коли її результат забирають, тож буфер, перевикористаний
+// до того, фарбує кінець попередньої смуги кольором наступної, і GRAM
+// розходиться з блокуючим шляхом. Друкує транзакції і байти на заливку
+// екрана, швидкість на дроті при налаштованій частоті SPI і час CPU.
+#include <string.h>
+
+#include "check.h"
+#include "lcd_emu.h"
+#include "st7789.h"
+
+#define WIDTH 135
+#define HEIGHT 240
+#define OFFSETX 52
+#define OFFSETY 40
+#define BANDS 7
+
+// Оцінка паузи між транзакціями на ESP32: spi_device_transmit чекає
+// завершення і будить задачу, чергована стартує одразу з переривання
+#define TX_GAP_BLOCKING_US 20.0
+#define TX_GAP_QUEUED_US 2.0
+
+extern int clock_speed_hz;      // st7789.c, змінюється spi_clock_speed()
+
+static const uint16_t band_colors[BANDS] = {RED, GREEN, BLUE, YELLOW, CYAN, PURPLE, WHITE};
+
+static TFT_t dev;
+static uint16_t blocking_gram[LCD_EMU_SIZE][LCD_EMU_SIZE];
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t bus_waits;
+    double us;
+} fill_cost_t;
+
+static void frame(uint16_t bg)
+{
+    lcdFillScreen(&dev, bg);
+    for (int i = 0; i < BANDS; i++) {
+        uint16_t y = i * HEIGHT / BANDS;
+        lcdDrawFillRect(&dev, i * 3, y, WIDTH - 1 - i * 3, (i + 1) * HEIGHT / BANDS - 1, band_colors[i]);
+    }
+}
+
+static fill_cost_t run(bool async, long repeats)
+{
+    fill_cost_t cost;
+
+    dev._async = async;
+    lcd_emu_reset(0);
+
+    // Одна заливка екрана: що йде по шині
+    lcdFillScreen(&dev, BLACK);
+    spi_master_wait(&dev);
+    cost.transactions = lcd_emu.transactions;
+    cost.bytes = lcd_emu.bytes;
+
+    dev._bus_waits = 0;
+    double t0 = now_us();
+    for (long i = 0; i < repeats; i++) {
+        lcdFillScreen(&dev, i & 1 ? BLACK : GRAY);
+    }
+    spi_master_wait(&dev);
+    cost.us = (now_us() - t0) / repeats;
+    cost.bus_waits = dev._bus_waits;
+
+    frame(BLUE);
+    spi_master_wait(&dev);
+    return cost;
+}
+
+// Байти на мікросекунду - це MB/s
+static double wire_mbps(const fill_cost_t *c, double gap_us)
+{
+    double wire_us = c->bytes * 8.0 / (clock_speed_hz / 1e6) + c->transactions * gap_us;
+    return c->bytes / wire_us;
+}
+
+int main(int argc, char **argv)
+{
+    long repeats = bench_iters(argc, argv, 200);
+
+    spi_master_init(&dev, 23, 18, -1, LCD_EMU_DC, -1, -1);
+    lcdInit(&dev, WIDTH, HEIGHT, OFFSETX, OFFSETY);
+    CHECK(dev._async);
+
+    fill_cost_t blocking = run(false, repeats);
+    memcpy(blocking_gram, lcd_emu.gram, sizeof(blocking_gram));
+    CHECK_EQ(lcd_emu.queued, 0);
+
+    fill_cost_t queued = run(true, repeats);
+    CHECK(lcd_emu.queued > 0);
+    CHECK_EQ(memcmp(blocking_gram, lcd_emu.gram, sizeof(blocking_gram)), 0);
+
+    uint32_t pixel_bytes = WIDTH * HEIGHT * 2;
+    CHECK_EQ(blocking.bytes, queued.bytes);
+    CHECK(blocking.bytes >= pixel_bytes);
+    CHECK_EQ(queued.transactions, 5 + (pixel_bytes + LCD_CHUNK_SIZE - 1) / LCD_CHUNK_SIZE);
+    CHECK(queued.transactions * 4 < blocking.transactions);
+
+    printf("spi_fill: %dx%d at %d MHz, wire limit %.2f MB/s\n",
+           WIDTH, HEIGHT, clock_speed_hz / 1000000, clock_speed_hz / 8e6);
+    printf("spi_fill: blocking %u transactions %u B, %.2f MB/s on the wire, %.1f us CPU per fill\n",
+           blocking.transactions, blocking.bytes, wire_mbps(&blocking, TX_GAP_BLOCKING_US), blocking.us);
+    printf("spi_fill: queued   %u transactions %u B, %.2f MB/s on the wire, %.1f us CPU per fill, %u bus waits\n",
+           queued.transactions, queued.bytes, wire_mbps(&queued, TX_GAP_QUEUED_US), queued.us, queued.bus_waits);
+    return 0;
+}
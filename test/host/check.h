@@ -0,0 +1,42 @@
+#ifndef TEST_HOST_CHECK_H_
+#define TEST_HOST_CHECK_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+// Мінімальні перевірки для хостових тестів: перша невдала перевірка
+// друкує місце і завершує процес з кодом 1, ctest вважає тест проваленим.
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ != b_) { \
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+                __FILE__, __LINE__, #a, #b, a_, b_); \
+        exit(1); \
+    } \
+} while (0)
+
+// Монотонний час для бенчмарків, мікросекунди
+static inline double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Кількість повторів бенчмарка: перший аргумент або значення за замовчуванням
+static inline long bench_iters(int argc, char **argv, long def)
+{
+    return argc > 1 ? strtol(argv[1], NULL, 0) : def;
+}
+
+#endif /* TEST_HOST_CHECK_H_ */
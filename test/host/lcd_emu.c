@@ -0,0 +1,161 @@
+#include <string.h>
+
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "lcd_emu.h"
+
+#define LCD_EMU_FIFO 16
+
+lcd_emu_t lcd_emu;
+
+static int dc;
+static uint8_t cmd;
+static uint8_t args[4];
+static int nargs;
+static int xs, xe, ys, ye, cx, cy;
+static int high = -1;
+
+static transaction_cb_t pre_cb;
+static spi_transaction_t *fifo[LCD_EMU_FIFO];
+static int fifo_head, fifo_count;
+
+void lcd_emu_reset_counters(void)
+{
+    lcd_emu.transactions = 0;
+    lcd_emu.bytes = 0;
+    lcd_emu.pixels = 0;
+    lcd_emu.queued = 0;
+    lcd_emu.max_depth = 0;
+}
+
+void lcd_emu_reset(uint16_t fill)
+{
+    for (int y = 0; y < LCD_EMU_SIZE; y++) {
+        for (int x = 0; x < LCD_EMU_SIZE; x++) {
+            lcd_emu.gram[y][x] = fill;
+        }
+    }
+    lcd_emu_reset_counters();
+}
+
+static void wire(spi_transaction_t *t)
+{
+    if (pre_cb) {
+        pre_cb(t);
+    }
+    const uint8_t *b = (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data : t->tx_buffer;
+    size_t n = t->length / 8;
+
+    lcd_emu.transactions++;
+    lcd_emu.bytes += n;
+    if (!dc) {
+        cmd = b[0];
+        nargs = 0;
+        if (cmd == 0x2C) {
+            cx = xs;
+            cy = ys;
+            high = -1;
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (cmd == 0x2A || cmd == 0x2B) {
+            if (nargs < 4) {
+                args[nargs++] = b[i];
+            }
+            if (nargs == 4) {
+                int a = args[0] << 8 | args[1];
+                int e = args[2] << 8 | args[3];
+                if (cmd == 0x2A) {
+                    xs = a;
+                    xe = e;
+                } else {
+                    ys = a;
+                    ye = e;
+                }
+            }
+        } else if (cmd == 0x2C) {
+            if (high < 0) {
+                high = b[i];
+                continue;
+            }
+            if (cx < LCD_EMU_SIZE && cy < LCD_EMU_SIZE) {
+                lcd_emu.gram[cy][cx] = (uint16_t)(high << 8 | b[i]);
+            }
+            high = -1;
+            lcd_emu.pixels++;
+            if (++cx > xe) {
+                cx = xs;
+                if (++cy > ye) {
+                    cy = ys;
+                }
+            }
+        }
+    }
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t pin)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    if (pin == LCD_EMU_DC) {
+        dc = level;
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *cfg, int dma)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg, spi_device_handle_t *handle)
+{
+    pre_cb = cfg->pre_cb;
+    fifo_head = 0;
+    fifo_count = 0;
+    *handle = (spi_device_handle_t)&lcd_emu;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    // Блокуюча передача не може обігнати чергу
+    assert(fifo_count == 0);
+    wire(trans);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    return spi_device_transmit(handle, trans);
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t wait)
+{
+    assert(fifo_count < 7);
+    fifo[(fifo_head + fifo_count++) % LCD_EMU_FIFO] = trans;
+    lcd_emu.queued++;
+    if ((uint32_t)fifo_count > lcd_emu.max_depth) {
+        lcd_emu.max_depth = fifo_count;
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t wait)
+{
+    assert(fifo_count > 0);
+    *trans = fifo[fifo_head];
+    wire(*trans);
+    fifo_head = (fifo_head + 1) % LCD_EMU_FIFO;
+    fifo_count--;
+    return ESP_OK;
+}
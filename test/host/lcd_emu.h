@@ -0,0 +1,29 @@
+#ifndef TEST_HOST_LCD_EMU_H_
+#define TEST_HOST_LCD_EMU_H_
+
+#include <stdint.h>
+
+// Емулятор панелі ST7789 на місці шини SPI: розбирає CASET/RASET/RAMWR і
+// записує пікселі в GRAM. Черговані транзакції "йдуть по дроту" лише тоді,
+// коли st7789.c забирає їх результат - найгірший випадок для повторного
+// використання буферів. Рівень D/C береться з gpio_set_level(LCD_EMU_DC, ...).
+
+#define LCD_EMU_SIZE 320
+#define LCD_EMU_DC 27
+
+typedef struct {
+    uint16_t gram[LCD_EMU_SIZE][LCD_EMU_SIZE];  // [y][x], байти як на шині
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t pixels;
+    uint32_t queued;
+    uint32_t max_depth;
+} lcd_emu_t;
+
+extern lcd_emu_t lcd_emu;
+
+// Очищення GRAM значенням fill і скидання лічильників
+void lcd_emu_reset(uint16_t fill);
+void lcd_emu_reset_counters(void);
+
+#endif /* TEST_HOST_LCD_EMU_H_ */
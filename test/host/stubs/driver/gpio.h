@@ -0,0 +1,16 @@
+#ifndef TEST_HOST_DRIVER_GPIO_H_
+#define TEST_HOST_DRIVER_GPIO_H_
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+typedef enum { GPIO_MODE_INPUT, GPIO_MODE_OUTPUT } gpio_mode_t;
+
+// Реалізація в lcd_emu.c: рівень D/C визначає, команда чи дані на шині
+esp_err_t gpio_reset_pin(gpio_num_t pin);
+esp_err_t gpio_set_direction(gpio_num_t pin, gpio_mode_t mode);
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level);
+
+#endif /* TEST_HOST_DRIVER_GPIO_H_ */
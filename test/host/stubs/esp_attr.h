@@ -0,0 +1,6 @@
+#ifndef TEST_HOST_ESP_ATTR_H_
+#define TEST_HOST_ESP_ATTR_H_
+
+#define IRAM_ATTR
+
+#endif /* TEST_HOST_ESP_ATTR_H_ */
@@ -0,0 +1,11 @@
+#ifndef TEST_HOST_ESP_ERR_H_
+#define TEST_HOST_ESP_ERR_H_
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+#endif /* TEST_HOST_ESP_ERR_H_ */
@@ -0,0 +1,15 @@
+#ifndef TEST_HOST_ESP_HEAP_CAPS_H_
+#define TEST_HOST_ESP_HEAP_CAPS_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA (1 << 3)
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+#endif /* TEST_HOST_ESP_HEAP_CAPS_H_ */
@@ -0,0 +1,12 @@
+#ifndef TEST_HOST_ESP_LOG_H_
+#define TEST_HOST_ESP_LOG_H_
+
+#include <stdio.h>
+
+// Помилки і попередження видно у виводі тесту, решта мовчить
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { (void)(tag); } while (0)
+
+#endif /* TEST_HOST_ESP_LOG_H_ */
@@ -0,0 +1,14 @@
+#ifndef TEST_HOST_FREERTOS_H_
+#define TEST_HOST_FREERTOS_H_
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif /* TEST_HOST_FREERTOS_H_ */
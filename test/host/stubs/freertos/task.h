@@ -0,0 +1,12 @@
+#ifndef TEST_HOST_FREERTOS_TASK_H_
+#define TEST_HOST_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+// Затримки на хості не потрібні: емулятор панелі не має часу
+static inline void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
+
+#endif /* TEST_HOST_FREERTOS_TASK_H_ */
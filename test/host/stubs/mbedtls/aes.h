@@ -0,0 +1,47 @@
+#ifndef TEST_HOST_MBEDTLS_AES_H_
+#define TEST_HOST_MBEDTLS_AES_H_
+
+#include <openssl/aes.h>
+
+// Підмножина mbedTLS AES, яку використовують модулі пристрою, поверх OpenSSL.
+// Той самий AES-128, тож результати збігаються з пристроєм біт у біт
+
+#define MBEDTLS_AES_ENCRYPT 1
+#define MBEDTLS_AES_DECRYPT 0
+
+typedef struct {
+    AES_KEY key;
+} mbedtls_aes_context;
+
+static inline void mbedtls_aes_init(mbedtls_aes_context *ctx)
+{
+    (void)ctx;
+}
+
+static inline void mbedtls_aes_free(mbedtls_aes_context *ctx)
+{
+    (void)ctx;
+}
+
+static inline int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+    return AES_set_encrypt_key(key, (int)keybits, &ctx->key);
+}
+
+static inline int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+    return AES_set_decrypt_key(key, (int)keybits, &ctx->key);
+}
+
+static inline int mbedtls_aes_crypt_ecb(mbedtls_aes_context *ctx, int mode,
+                                        const unsigned char input[16], unsigned char output[16])
+{
+    if (mode == MBEDTLS_AES_ENCRYPT) {
+        AES_encrypt(input, output, &ctx->key);
+    } else {
+        AES_decrypt(input, output, &ctx->key);
+    }
+    return 0;
+}
+
+#endif /* TEST_HOST_MBEDTLS_AES_H_ */
@@ -0,0 +1,8 @@
+#ifndef TEST_HOST_SDKCONFIG_H_
+#define TEST_HOST_SDKCONFIG_H_
+
+// Мінімальна конфігурація для збирання компонента st7789 на хості.
+// CONFIG_ASYNC_SPI задається ціллю CMake, щоб перевіряти обидва режими.
+#define CONFIG_SPI2_HOST 1
+
+#endif /* TEST_HOST_SDKCONFIG_H_ */
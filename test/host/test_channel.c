@@ -0,0 +1,108 @@
+// channel: відсів за бітовою маскою підписок, утримання динаміка першим
+// почутим каналом і витіснення пріоритетним каналом.
+#include "check.h"
+#include "channel.h"
+
+static void test_subscriptions(void)
+{
+    channel_set_t c;
+    channel_init(&c, 1, 9, 1u << 3 | 1u);
+
+    CHECK(channel_subscribed(&c, 1));
+    CHECK(channel_subscribed(&c, 9));
+    CHECK(channel_subscribed(&c, 3));
+    CHECK(!channel_subscribed(&c, 2));
+    CHECK(!channel_subscribed(&c, 0));          // Службовий канал - не підписка
+    CHECK(!channel_subscribed(&c, CHANNEL_MAX + 1));
+    CHECK(!channel_subscribed(&c, 200));
+
+    // Пакети каналів без підписки відкидаються і не займають динамік
+    CHECK(!channel_accept_audio(&c, 2, 0));
+    CHECK(!channel_accept_audio(&c, 200, 0));
+    CHECK_EQ(c.unsubscribed, 2);
+    CHECK_EQ(c.active, 0);
+
+    channel_subscribe(&c, 2, true);
+    CHECK(channel_accept_audio(&c, 2, 10));
+    channel_subscribe(&c, 2, false);
+    CHECK(!channel_subscribed(&c, 2));
+
+    // Зміна власного каналу знімає підписку на старий, але не на fixed
+    channel_set_tx(&c, 4);
+    CHECK(channel_subscribed(&c, 4));
+    CHECK(!channel_subscribed(&c, 1));
+    channel_set_tx(&c, 3);
+    channel_set_tx(&c, 5);
+    CHECK(channel_subscribed(&c, 3));
+    CHECK(!channel_subscribed(&c, 4));
+
+    // Власний і пріоритетний канали не відписуються
+    channel_subscribe(&c, 5, false);
+    channel_subscribe(&c, 9, false);
+    CHECK(channel_subscribed(&c, 5));
+    CHECK(channel_subscribed(&c, 9));
+
+    // Некоректні номери не змінюють маску
+    uint32_t mask = c.subscribed;
+    channel_subscribe(&c, 0, true);
+    channel_subscribe(&c, CHANNEL_MAX + 1, true);
+    CHECK_EQ(c.subscribed, mask);
+}
+
+static void test_hold_and_preemption(void)
+{
+    channel_set_t c;
+    channel_init(&c, 1, 9, 1u << 3);
+
+    CHECK(channel_accept_audio(&c, 1, 0));
+    CHECK_EQ(c.active, 1);
+
+    // Динамік тримає канал 1: інший підписаний канал чекає
+    CHECK(!channel_accept_audio(&c, 3, 100));
+    CHECK_EQ(c.busy, 1);
+    CHECK(channel_accept_audio(&c, 1, 200));
+
+    // Пріоритетний канал перебиває одразу, і тепер чекає канал 1
+    CHECK(channel_accept_audio(&c, 9, 250));
+    CHECK_EQ(c.preemptions, 1);
+    CHECK_EQ(c.active, 9);
+    CHECK(!channel_accept_audio(&c, 1, 260));
+    CHECK(channel_accept_audio(&c, 9, 400));
+
+    // Канал звільняється лише після CHANNEL_HOLD_MS тиші
+    CHECK(!channel_accept_audio(&c, 1, 400 + CHANNEL_HOLD_MS));
+    CHECK(channel_accept_audio(&c, 1, 400 + CHANNEL_HOLD_MS + 1));
+    CHECK_EQ(c.active, 1);
+    CHECK_EQ(c.busy, 3);
+
+    // Вільний динамік бере будь-який підписаний канал без витіснення
+    CHECK(channel_accept_audio(&c, 3, 1200));
+    CHECK_EQ(c.preemptions, 1);
+
+    // Витіснення рахується раз, далі пріоритетний канал уже активний
+    CHECK(channel_accept_audio(&c, 9, 1300));
+    CHECK(channel_accept_audio(&c, 9, 1310));
+    CHECK_EQ(c.preemptions, 2);
+}
+
+static void test_no_priority(void)
+{
+    channel_set_t c;
+    channel_init(&c, 1, 0, 1u << 2);
+
+    // Без пріоритетного каналу (0) ніхто не перебиває активний
+    CHECK(channel_accept_audio(&c, 2, 0));
+    CHECK(!channel_accept_audio(&c, 1, 10));
+    CHECK(!channel_accept_audio(&c, 0, 20));
+    CHECK_EQ(c.preemptions, 0);
+    CHECK_EQ(c.active, 2);
+}
+
+int main(void)
+{
+    test_subscriptions();
+    test_hold_and_preemption();
+    test_no_priority();
+    printf("channel: ok\n");
+    return 0;
+}
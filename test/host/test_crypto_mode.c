@@ -0,0 +1,190 @@
+// crypto_mode: узгодження режиму через маяки і перемикання посеред потоку.
+// Режим кожного пакета їде в його описі (повний або стиснутий заголовок),
+// приймач розшифровує за пакетом, тож жодне перемикання не дає шуму, а
+// відкидається лише відкритий звук, коли приймач сам вимагає шифрування.
+#include <string.h>
+
+#include "check.h"
+#include "crypto_mode.h"
+#include "hdr_comp.h"
+#include "packet.h"
+
+#define FRAME_BYTES 64
+
+static void test_negotiation(void)
+{
+    crypto_mode_t m;
+
+    crypto_mode_init(&m, false);
+    CHECK(!crypto_mode_tx_encrypted(&m));
+    CHECK_EQ(crypto_mode_status(&m), CRYPTO_STATUS_OFF);
+    CHECK(crypto_mode_rx_accept(&m, false));
+
+    // Співрозмовник вимагає - передача шифрується, хоча тут вимкнено
+    crypto_mode_set_peers(&m, true);
+    CHECK(crypto_mode_tx_encrypted(&m));
+    CHECK_EQ(crypto_mode_status(&m), CRYPTO_STATUS_ON_PEER);
+    CHECK(crypto_mode_rx_accept(&m, false));
+    CHECK_EQ(m.tx_switches, 1);
+
+    // Власне бажання при вже шифрованій передачі режим не змінює
+    CHECK(crypto_mode_set_local(&m, true));
+    CHECK(!crypto_mode_set_local(&m, true));
+    CHECK_EQ(m.tx_switches, 1);
+    CHECK_EQ(crypto_mode_status(&m), CRYPTO_STATUS_ON);
+
+    crypto_mode_set_peers(&m, false);
+    CHECK(crypto_mode_tx_encrypted(&m));
+    CHECK(!crypto_mode_rx_accept(&m, false));
+    CHECK(crypto_mode_rx_accept(&m, true));
+    CHECK_EQ(m.plain_rejected, 1);
+
+    CHECK(crypto_mode_set_local(&m, false));
+    CHECK(!crypto_mode_tx_encrypted(&m));
+    CHECK_EQ(m.tx_switches, 2);
+}
+
+// Потік A -> B. Шифр для тесту - XOR з гамою, що залежить від номера пакета:
+// розшифровка не в тому режимі дає інші байти, тобто "шум"
+typedef struct {
+    crypto_mode_t cm;
+    hdr_comp_tx_t tx;
+    hdr_comp_rx_t rx;
+    uint16_t seq;
+} device_t;
+
+typedef enum { RX_PLAYED, RX_DROPPED, RX_NOISE } rx_result_t;
+
+static void cipher(uint8_t *data, uint16_t seq)
+{
+    for (int i = 0; i < FRAME_BYTES; i++) {
+        data[i] ^= (uint8_t)(seq * 7 + i * 13 + 0x5A);
+    }
+}
+
+static size_t send_audio(device_t *a, uint8_t *buf, const uint8_t *pcm, uint32_t now)
+{
+    pkt_header_t h = {.type = PKT_TYPE_AUDIO, .group = 1, .node = 1, .seq = a->seq++, .timestamp = now};
+    pkt_audio_desc_t d = {.frames = 1};
+    bool enc = crypto_mode_tx_encrypted(&a->cm);
+
+    d.key = enc ? PKT_AUDIO_KEY_GROUP : PKT_AUDIO_KEY_NONE;
+    size_t n = hdr_comp_write(&a->tx, buf, &h, &d);
+    memcpy(buf + n, pcm, FRAME_BYTES);
+    if (enc) {
+        cipher(buf + n, h.seq);
+    }
+    return n + FRAME_BYTES;
+}
+
+static rx_result_t receive_audio(device_t *b, uint8_t *buf, size_t len, const uint8_t *pcm, uint32_t now)
+{
+    pkt_header_t h;
+    pkt_audio_desc_t d;
+    pkt_compact_t c;
+    uint8_t *data;
+
+    if (pkt_read_compact(buf, len, &c)) {
+        CHECK(hdr_comp_rx_expand(&b->rx, &c, now, &h, &d));
+        data = buf + PKT_COMPACT_SIZE;
+    } else {
+        CHECK(pkt_read_header(buf, len, &h));
+        CHECK(pkt_read_audio_desc(buf + PKT_HEADER_SIZE, len - PKT_HEADER_SIZE, &d));
+        data = buf + PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE;
+    }
+    hdr_comp_rx_update(&b->rx, &h, now);
+
+    bool enc = d.key != PKT_AUDIO_KEY_NONE;
+    if (!crypto_mode_rx_accept(&b->cm, enc)) {
+        return RX_DROPPED;
+    }
+    if (enc) {
+        cipher(data, h.seq);
+    }
+    return memcmp(data, pcm, FRAME_BYTES) == 0 ? RX_PLAYED : RX_NOISE;
+}
+
+static uint32_t rng = 7;
+
+static uint32_t next_rand(void)
+{
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+static void test_mid_stream_switches(void)
+{
+    device_t a, b;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    crypto_mode_init(&a.cm, true);
+    crypto_mode_init(&b.cm, true);
+    hdr_comp_tx_init(&a.tx);
+    hdr_comp_rx_init(&b.rx);
+    // Перші маяки вже дійшли
+    crypto_mode_set_peers(&a.cm, b.cm.local);
+    crypto_mode_set_peers(&b.cm, a.cm.local);
+
+    // Кнопки перемикаються випадково, маяк з новим бажанням доходить за 1-4 пакети
+    int beacon_ab = -1, beacon_ba = -1;
+    int played = 0, dropped = 0, noise = 0, toggles = 0, disagree = 0, in_flight = 0;
+    for (int p = 0; p < 100000; p++) {
+        uint32_t now = p * 32;
+        if (next_rand() % 500 == 0) {
+            crypto_mode_set_local(&a.cm, !a.cm.local);
+            beacon_ab = p + 1 + next_rand() % 4;
+            toggles++;
+        }
+        if (next_rand() % 500 == 0) {
+            crypto_mode_set_local(&b.cm, !b.cm.local);
+            beacon_ba = p + 1 + next_rand() % 4;
+            toggles++;
+        }
+        if (p == beacon_ab) {
+            crypto_mode_set_peers(&b.cm, a.cm.local);
+        }
+        if (p == beacon_ba) {
+            crypto_mode_set_peers(&a.cm, b.cm.local);
+        }
+        bool beacons_pending = p < beacon_ab || p < beacon_ba;
+
+        uint8_t pcm[FRAME_BYTES], buf[PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE + FRAME_BYTES];
+        for (int i = 0; i < FRAME_BYTES; i++) {
+            pcm[i] = next_rand();
+        }
+        bool plain = !crypto_mode_tx_encrypted(&a.cm);
+        size_t n = send_audio(&a, buf, pcm, now);
+        switch (receive_audio(&b, buf, n, pcm, now)) {
+        case RX_PLAYED:
+            played++;
+            break;
+        case RX_DROPPED:
+            // Лише відкритий звук, коли приймач сам вимагає шифрування
+            CHECK(plain && b.cm.local);
+            dropped++;
+            break;
+        case RX_NOISE:
+            noise++;
+            break;
+        }
+        if (crypto_mode_tx_encrypted(&a.cm) != crypto_mode_tx_encrypted(&b.cm)) {
+            disagree++;
+            in_flight += beacons_pending;
+        }
+    }
+    printf("toggles %d: played %d, dropped %d, noise %d, modes disagree %d packets\n",
+           toggles, played, dropped, noise, disagree);
+    CHECK(toggles > 100);
+    CHECK_EQ(noise, 0);
+    CHECK_EQ(dropped, b.cm.plain_rejected);
+    // Режими розходяться лише поки маяк з новим бажанням ще в дорозі
+    CHECK_EQ(disagree, in_flight);
+}
+
+int main(void)
+{
+    test_negotiation();
+    test_mid_stream_switches();
+    printf("crypto_mode: ok\n");
+    return 0;
+}
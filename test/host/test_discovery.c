@@ -0,0 +1,194 @@
+// Виявлення пристроїв на loopback. Два пристрої на спільному порту в
+// multicast групі, третій приєднується пізніше на власному порту: multicast
+// маяки групи до нього не доходять, тож про інших він може дізнатись лише
+// з unicast відповідей на свій перший маяк. Час для discovery віртуальний
+// (крок STEP_MS), пакети ходять справжніми сокетами, тому перевірки на
+// період маяка і тайм-аут не залежать від навантаження машини.
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "check.h"
+#include "discovery.h"
+#include "net_engine.h"
+#include "packet.h"
+#include "peer_table.h"
+
+#define DEVICES 3
+#define LATE 2                  // Пристрій, що приєднується пізніше
+#define LEAVER 0                // Пристрій, що зникає
+#define PORT 47302
+#define LATE_PORT (PORT + 1)
+#define GROUP_ADDR "239.0.77.2"
+#define STEP_MS 10
+#define SKIP_RC 77
+
+typedef struct {
+    net_engine_t ne;
+    uint16_t node;
+    bool running;
+    peer_table_t peers;
+    discovery_t disc;
+} device_t;
+
+static device_t dev[DEVICES];
+static struct sockaddr_in group;
+static uint32_t clock_ms;
+
+static void on_rx(void *ctx, uint8_t *data, size_t len, const struct sockaddr_in *from)
+{
+    device_t *d = ctx;
+    pkt_header_t h;
+    pkt_beacon_t b;
+
+    if (!pkt_read_header(data, len, &h) || h.type != PKT_TYPE_BEACON || h.node == d->node) {
+        return;
+    }
+    if (!pkt_read_beacon(data + PKT_HEADER_SIZE, len - PKT_HEADER_SIZE, &b)) {
+        return;
+    }
+    peer_t *p = peer_table_touch(&d->peers, h.node, from, clock_ms);
+    discovery_on_beacon(&d->disc, p, &b, clock_ms);
+}
+
+static void start(device_t *d, uint16_t port)
+{
+    CHECK_EQ(net_engine_init(&d->ne, port, NET_OPT_REUSE), 0);
+    net_engine_set_rx(&d->ne, on_rx, d);
+    peer_table_init(&d->peers);
+    discovery_init(&d->disc, &d->ne, &d->peers, &group, 1, d->node);
+    d->disc.local.boot_id = 0xB0070000u | d->node;
+    d->disc.local.sample_rate = 44100;
+    d->running = true;
+}
+
+// Один крок віртуального часу: маяки і тайм-аути, потім прийом з відповідями
+static void step(void)
+{
+    clock_ms += STEP_MS;
+    for (int i = 0; i < DEVICES; i++) {
+        if (dev[i].running) {
+            discovery_tick(&dev[i].disc, clock_ms);
+        }
+    }
+    for (int round = 0; round < 3; round++) {
+        struct timespec ts = {0, 200000};
+        nanosleep(&ts, NULL);
+        for (int i = 0; i < DEVICES; i++) {
+            if (dev[i].running) {
+                CHECK_EQ(net_engine_poll(&dev[i].ne, 0), 0);
+            }
+        }
+    }
+}
+
+static bool knows(device_t *d, uint16_t node)
+{
+    peer_t *p = peer_table_find(&d->peers, node);
+    return p != NULL && p->info_valid;
+}
+
+static bool all_know_each_other(void)
+{
+    for (int i = 0; i < DEVICES; i++) {
+        for (int j = 0; j < DEVICES; j++) {
+            if (i != j && !knows(&dev[i], dev[j].node)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    group.sin_family = AF_INET;
+    group.sin_port = htons(PORT);
+    group.sin_addr.s_addr = inet_addr(GROUP_ADDR);
+    clock_ms = 100000;
+
+    for (int i = 0; i < DEVICES; i++) {
+        dev[i].node = 0x200 + i;
+    }
+    for (int i = 0; i < DEVICES; i++) {
+        if (i == LATE) {
+            continue;
+        }
+        start(&dev[i], PORT);
+        if (net_engine_join_multicast(&dev[i].ne, group.sin_addr.s_addr) != 0) {
+            printf("discovery: no multicast on this host, skipped\n");
+            return SKIP_RC;
+        }
+    }
+
+    // Перші два знаходять один одного з маяків групи
+    for (int t = 0; t < 2 * DISCOVERY_BEACON_PERIOD_MS; t += STEP_MS) {
+        step();
+    }
+    CHECK(knows(&dev[0], dev[1].node));
+    CHECK(knows(&dev[1], dev[0].node));
+    CHECK(!knows(&dev[0], dev[LATE].node));
+
+    // Пізній пристрій. Маяки групи до нього не доходять, лише відповіді
+    start(&dev[LATE], LATE_PORT);
+    uint32_t discovered_before[DEVICES];
+    for (int i = 0; i < DEVICES; i++) {
+        discovered_before[i] = dev[i].disc.discovered;
+    }
+    uint32_t join_ms = clock_ms;
+    uint32_t all_ms = 0;
+    while ((uint32_t)(clock_ms - join_ms) < DISCOVERY_BEACON_PERIOD_MS) {
+        step();
+        if (all_ms == 0 && all_know_each_other()) {
+            all_ms = clock_ms;
+        }
+    }
+    CHECK(all_ms != 0);
+    printf("discovery: late joiner known to all %u ms after joining\n", (unsigned)(all_ms - join_ms));
+    CHECK((uint32_t)(all_ms - join_ms) < DISCOVERY_BEACON_PERIOD_MS);
+
+    // Перший маяк новачка дійшов до групи, кожен відповів йому unicast,
+    // і тільки ці відповіді дійшли до нього
+    device_t *late = &dev[LATE];
+    CHECK_EQ(late->disc.beacons_received, DEVICES - 1);
+    CHECK_EQ(late->disc.discovered, DEVICES - 1);
+    for (int i = 0; i < DEVICES; i++) {
+        if (i == LATE) {
+            continue;
+        }
+        CHECK_EQ(dev[i].disc.discovered, discovered_before[i] + 1);
+        CHECK_EQ(ntohs(peer_table_find(&dev[i].peers, late->node)->addr.sin_port), LATE_PORT);
+        CHECK_EQ(ntohs(peer_table_find(&late->peers, dev[i].node)->addr.sin_port), PORT);
+    }
+
+    // Повторні маяки новачка не викликають нових відповідей
+    uint32_t late_rx = late->disc.beacons_received;
+    for (int t = 0; t < DISCOVERY_BEACON_PERIOD_MS; t += STEP_MS) {
+        step();
+    }
+    CHECK_EQ(late->disc.beacons_received, late_rx);
+    CHECK_EQ(dev[1].disc.discovered, discovered_before[1] + 1);
+
+    // Один пристрій зникає. Решта видаляють його через PEER_TIMEOUT_MS після
+    // останнього маяка, а того, кого чути, лишають
+    device_t *keeper = &dev[1];
+    dev[LEAVER].running = false;
+    uint32_t last_seen = peer_table_find(&keeper->peers, dev[LEAVER].node)->last_seen_ms;
+    while ((uint32_t)(clock_ms + STEP_MS - last_seen) <= PEER_TIMEOUT_MS) {
+        step();
+    }
+    CHECK(knows(keeper, dev[LEAVER].node));
+    CHECK_EQ(keeper->disc.expired, 0);
+    step();
+    step();
+    CHECK(peer_table_find(&keeper->peers, dev[LEAVER].node) == NULL);
+    CHECK_EQ(keeper->disc.expired, 1);
+    CHECK(knows(keeper, late->node));
+    printf("discovery: %04x expired after %u ms of silence\n",
+           dev[LEAVER].node, (unsigned)(clock_ms - last_seen));
+
+    for (int i = 0; i < DEVICES; i++) {
+        net_engine_close(&dev[i].ne);
+    }
+    printf("discovery: ok\n");
+    return 0;
+}
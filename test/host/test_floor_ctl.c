@@ -0,0 +1,124 @@
+// floor_ctl: арбітраж одночасних запитів, витіснення пріоритетом,
+// звільнення мовчазного власника і підрахунок згоди за різними вузлами.
+#include <string.h>
+
+#include "check.h"
+#include "floor_ctl.h"
+
+#define N 3
+
+static floor_ctl_t f[N];
+static const uint16_t id[N] = {10, 20, 30};
+
+// Доставка всіх вихідних повідомлень усім іншим вузлам, доки черги не спорожніють
+static void deliver(uint32_t now)
+{
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (int i = 0; i < N; i++) {
+            pkt_floor_t m;
+            while (floor_ctl_pop(&f[i], &m)) {
+                moved = true;
+                for (int j = 0; j < N; j++) {
+                    if (j != i) {
+                        floor_ctl_on_msg(&f[j], id[i], &m, now, N - 1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void reset(void)
+{
+    for (int i = 0; i < N; i++) {
+        floor_ctl_init(&f[i], id[i], 0);
+    }
+}
+
+static void test_collision(void)
+{
+    reset();
+    floor_ctl_press(&f[1], 0, N - 1);
+    floor_ctl_press(&f[2], 0, N - 1);
+    deliver(1);
+    // При рівних пріоритетах перемагає менший номер вузла
+    CHECK(floor_ctl_can_talk(&f[1]));
+    CHECK_EQ(f[2].state, FLOOR_TAKEN);
+    CHECK_EQ(f[2].holder, 20);
+    CHECK_EQ(f[0].holder, 20);
+    CHECK_EQ(f[2].collisions, 1);
+}
+
+static void test_preemption(void)
+{
+    reset();
+    floor_ctl_press(&f[2], 0, N - 1);
+    deliver(0);
+    CHECK(floor_ctl_can_talk(&f[2]));
+
+    f[0].priority = 5;
+    floor_ctl_press(&f[0], 10, N - 1);
+    deliver(10);
+    CHECK(floor_ctl_can_talk(&f[0]));
+    CHECK_EQ(f[2].state, FLOOR_TAKEN);
+    CHECK_EQ(f[2].preemptions, 1);
+
+    // Витіснений вузол досі тримає PTT і повертає слово після звільнення
+    floor_ctl_release(&f[0], 20);
+    deliver(20);
+    CHECK(floor_ctl_can_talk(&f[2]));
+}
+
+static void test_stuck_holder(void)
+{
+    reset();
+    floor_ctl_press(&f[1], 100, N - 1);
+    deliver(100);
+    for (uint32_t t = 100; t <= 100 + FLOOR_IDLE_TIMEOUT_MS; t += 20) {
+        floor_ctl_tick(&f[0], t, N - 1);
+    }
+    CHECK_EQ(f[0].state, FLOOR_IDLE);
+    CHECK_EQ(f[0].stuck_releases, 1);
+}
+
+static void test_optimistic(void)
+{
+    reset();
+    floor_ctl_press(&f[0], 0, N - 1);
+    f[0].out_count = 0; // Запит загубився
+    floor_ctl_tick(&f[0], FLOOR_GRANT_TIMEOUT_MS - 1, N - 1);
+    CHECK_EQ(f[0].state, FLOOR_REQUESTING);
+    floor_ctl_tick(&f[0], FLOOR_GRANT_TIMEOUT_MS, N - 1);
+    CHECK(floor_ctl_can_talk(&f[0]));
+    CHECK_EQ(f[0].optimistic, 1);
+}
+
+static void test_duplicate_grant(void)
+{
+    reset();
+    floor_ctl_press(&f[0], 0, N - 1);
+    pkt_floor_t grant = {.op = PKT_FLOOR_GRANT, .priority = 0, .target = 10, .holder = 10};
+
+    // Дубль GRANT від одного вузла не замінює згоду другого
+    floor_ctl_on_msg(&f[0], 20, &grant, 1, N - 1);
+    floor_ctl_on_msg(&f[0], 20, &grant, 2, N - 1);
+    CHECK_EQ(f[0].state, FLOOR_REQUESTING);
+    CHECK_EQ(f[0].grants, 1);
+
+    floor_ctl_on_msg(&f[0], 30, &grant, 3, N - 1);
+    CHECK(floor_ctl_can_talk(&f[0]));
+    CHECK_EQ(f[0].grants, 2);
+}
+
+int main(void)
+{
+    test_collision();
+    test_preemption();
+    test_stuck_holder();
+    test_optimistic();
+    test_duplicate_grant();
+    printf("floor_ctl: ok\n");
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "fontx.h"
+#include "test_font.h"
+
+#define TEST_FONT_W 8
+#define TEST_FONT_H 16
+#define TEST_FONT_SIZE (17 + FontxAnkGlyphs * TEST_FONT_H)
+
+static uint8_t font[TEST_FONT_SIZE];
+
+const FontxEmbedded FontxEmbeddedFonts[] = {
+    {"ILGH16XB", font, sizeof(font)},
+};
+const int FontxEmbeddedCount = 1;
+
+void test_font_init(void)
+{
+    uint32_t x = 12345;
+
+    memcpy(font, "FONTX2ILGH16XB", 14);
+    font[14] = TEST_FONT_W;
+    font[15] = TEST_FONT_H;
+    font[16] = 0; // ANK
+    for (size_t i = 17; i < sizeof(font); i++) {
+        x = x * 1103515245u + 12345u;
+        font[i] = x >> 24;
+    }
+}
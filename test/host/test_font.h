@@ -0,0 +1,9 @@
+#ifndef TEST_HOST_TEST_FONT_H_
+#define TEST_HOST_TEST_FONT_H_
+
+// Вбудований шрифт для хостових тестів замість fontx_embedded.c:
+// FONTX2 8x16 з іменем ILGH16XB і псевдовипадковими гліфами.
+// Викликається до InitFontxMem.
+void test_font_init(void);
+
+#endif /* TEST_HOST_TEST_FONT_H_ */
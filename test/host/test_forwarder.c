@@ -0,0 +1,265 @@
+// Ретранслятори на loopback: сегменти мережі - групи UDP сокетів, "широкомовна"
+// відправка в сегмент - копія кожному іншому сокету сегмента.
+//
+//   A -seg0- {R1, R2} -seg1- R3 -seg2- B,  R4: seg2 <-> seg0 (петля до A)
+//
+// Кожен пакет A має дійти до B, кеш дублікатів не дає петлі розгойдатися
+// (кожен ретранслятор пересилає пакет рівно раз), а лічильник переходів,
+// збільшений на місці, не ламає тег пакета. Другий прогін - з кешем, що
+// забуває все між пакетами: петлю тоді зупиняє лише FORWARDER_MAX_HOPS.
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "check.h"
+#include "cmac.h"
+#include "forwarder.h"
+#include "mbedtls/aes.h"
+#include "packet.h"
+
+#define RELAYS 4
+#define PACKETS 200
+#define FIRST_SEQ 65400         // Переповнення номера по дорозі
+#define IDLE_MS 5               // Тиша, після якої мережа вважається порожньою
+#define BODY_LEN 64
+#define BOOT_ID 0x2468ACE1u
+#define NODE_A 100
+#define SKIP_RC 77
+
+typedef struct {
+    int seg;
+    int sock;
+    struct sockaddr_in addr;
+    int relay;                  // 1..RELAYS, 0 - кінцевий пристрій
+} port_t;
+
+static port_t ports[2 + 2 * RELAYS];
+static int port_count;
+static forwarder_t fw[RELAYS + 1];
+static int relay_port[RELAYS + 1][2];
+static const int relay_segs[RELAYS + 1][2] = { {0, 0}, {0, 1}, {0, 1}, {1, 2}, {2, 0} };
+
+// Результат прогону для B
+typedef struct {
+    uint8_t copies[PACKETS];
+    long received;
+    long hops[FORWARDER_MAX_HOPS + 1];
+} delivery_t;
+
+static int port_a, port_b;
+static uint32_t fake_ms;        // Годинник ретрансляторів у прогоні без кешу
+static mbedtls_aes_context aes;
+static cmac_t cmac;
+
+static void aes_block(void *ctx, const uint8_t in[CMAC_BLOCK_SIZE], uint8_t out[CMAC_BLOCK_SIZE])
+{
+    mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT, in, out);
+}
+
+// Тег аудіо пакета, як у прошивці: префікс з нульовими переходами і тіло
+static void audio_tag(const pkt_header_t *h, const pkt_audio_desc_t *d, const uint8_t *body, uint8_t tag[PKT_AUDIO_MAC_SIZE])
+{
+    uint8_t prefix[PKT_MAC_PREFIX_SIZE];
+    uint8_t full[CMAC_BLOCK_SIZE];
+
+    cmac_start(&cmac);
+    cmac_update(&cmac, prefix, pkt_write_mac_prefix(prefix, h, d, BOOT_ID));
+    cmac_update(&cmac, body, BODY_LEN);
+    cmac_finish(&cmac, full);
+    memcpy(tag, full, PKT_AUDIO_MAC_SIZE);
+}
+
+static int open_port(int seg, int relay)
+{
+    port_t *p = &ports[port_count];
+    socklen_t alen = sizeof(p->addr);
+    int big = 1 << 20;
+
+    p->seg = seg;
+    p->relay = relay;
+    p->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&p->addr, 0, sizeof(p->addr));
+    p->addr.sin_family = AF_INET;
+    p->addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (p->sock < 0 || bind(p->sock, (struct sockaddr *)&p->addr, sizeof(p->addr)) != 0) {
+        return -1;
+    }
+    setsockopt(p->sock, SOL_SOCKET, SO_RCVBUF, &big, sizeof(big));
+    CHECK_EQ(getsockname(p->sock, (struct sockaddr *)&p->addr, &alen), 0);
+    return port_count++;
+}
+
+// Відправка в сегмент: усім сокетам сегмента, крім власних сокетів відправника
+static void broadcast(int from, const uint8_t *data, size_t len)
+{
+    for (int i = 0; i < port_count; i++) {
+        if (i == from || ports[i].seg != ports[from].seg ||
+            (ports[i].relay != 0 && ports[i].relay == ports[from].relay)) {
+            continue;
+        }
+        CHECK_EQ(sendto(ports[from].sock, data, len, 0, (struct sockaddr *)&ports[i].addr, sizeof(ports[i].addr)),
+                 (long)len);
+    }
+}
+
+// B: усе, крім лічильника переходів, як відправив A, і тег сходиться
+static void check_at_b(delivery_t *out, const uint8_t *rx, size_t m, const uint8_t *sent, size_t n, int last)
+{
+    pkt_header_t rh;
+    pkt_audio_desc_t rd;
+    uint8_t tag[PKT_AUDIO_MAC_SIZE];
+
+    CHECK_EQ(m, n);
+    CHECK(pkt_read_header(rx, m, &rh));
+    CHECK(pkt_read_audio_desc(rx + PKT_HEADER_SIZE, m - PKT_HEADER_SIZE, &rd));
+    CHECK(rh.hops >= 1 && rh.hops <= FORWARDER_MAX_HOPS);
+    audio_tag(&rh, &rd, rx + PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE, tag);
+    CHECK(memcmp(tag, rx + n - PKT_AUDIO_MAC_SIZE, sizeof(tag)) == 0);
+
+    int idx = (uint16_t)(rh.seq - FIRST_SEQ);
+    CHECK(idx >= 0 && idx <= last);
+    if (idx == last) {
+        CHECK(memcmp(rx, sent, PKT_HOPS_OFFSET) == 0);
+        CHECK(memcmp(rx + PKT_HOPS_OFFSET + 1, sent + PKT_HOPS_OFFSET + 1, n - PKT_HOPS_OFFSET - 1) == 0);
+    }
+    out->received += out->copies[idx]++ == 0;
+    out->hops[rh.hops]++;
+}
+
+// PACKETS аудіо пакетів від A; після кожного мережа працює, доки не затихне.
+// forget - кожне рішення ретранслятора на FORWARDER_WINDOW_MS пізніше за попереднє
+static void run(delivery_t *out, bool forget)
+{
+    uint8_t pkt[PKT_HEADER_SIZE + PKT_AUDIO_DESC_SIZE + BODY_LEN + PKT_AUDIO_MAC_SIZE];
+
+    memset(out, 0, sizeof(*out));
+    for (int r = 1; r <= RELAYS; r++) {
+        forwarder_init(&fw[r], FORWARDER_MAX_HOPS);
+    }
+
+    for (int i = 0; i < PACKETS; i++) {
+        pkt_header_t h = {.type = PKT_TYPE_AUDIO, .group = 1, .node = NODE_A, .seq = (uint16_t)(FIRST_SEQ + i),
+                          .timestamp = 1000 + i * 12};
+        pkt_audio_desc_t d = {.frames = 1, .key = PKT_AUDIO_KEY_NONE};
+        size_t n = pkt_write_header(pkt, &h);
+        n += pkt_write_audio_desc(pkt + n, &d);
+        memset(pkt + n, i & 0xFF, BODY_LEN);
+        audio_tag(&h, &d, pkt + n, pkt + n + BODY_LEN);
+        n += BODY_LEN + PKT_AUDIO_MAC_SIZE;
+        broadcast(port_a, pkt, n);
+
+        struct pollfd pfd[sizeof(ports) / sizeof(ports[0])];
+        for (int j = 0; j < port_count; j++) {
+            pfd[j].fd = ports[j].sock;
+            pfd[j].events = POLLIN;
+        }
+        while (poll(pfd, port_count, IDLE_MS) > 0) {
+            for (int j = 0; j < port_count; j++) {
+                uint8_t rx[sizeof(pkt)];
+                ssize_t m;
+                if (!(pfd[j].revents & POLLIN) || (m = recv(ports[j].sock, rx, sizeof(rx), 0)) <= 0) {
+                    continue;
+                }
+                int r = ports[j].relay;
+                if (r != 0) {
+                    // Пересилання з того самого буфера, як relay_rx_handler
+                    uint32_t now = forget ? (fake_ms += FORWARDER_WINDOW_MS + 1) : (uint32_t)(now_us() / 1000);
+                    if (forwarder_accept(&fw[r], rx, m, now)) {
+                        broadcast(relay_port[r][relay_port[r][0] == j ? 1 : 0], rx, m);
+                    }
+                } else if (j == port_b) {
+                    check_at_b(out, rx, m, pkt, n, i);
+                }
+                // Копії, що повернулися в сегмент A, нікуди не йдуть
+            }
+        }
+    }
+    CHECK_EQ(out->received, PACKETS);
+}
+
+int main(void)
+{
+    uint8_t key[16] = {0x2b, 0x7e, 0x15, 0x16};
+    static delivery_t at_b;
+
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, key, 128);
+    cmac_init(&cmac, aes_block, &aes);
+
+    if ((port_a = open_port(0, 0)) < 0 || (port_b = open_port(2, 0)) < 0) {
+        printf("forwarder: no loopback UDP, skipped\n");
+        return SKIP_RC;
+    }
+    for (int r = 1; r <= RELAYS; r++) {
+        for (int s = 0; s < 2; s++) {
+            relay_port[r][s] = open_port(relay_segs[r][s], r);
+            CHECK(relay_port[r][s] >= 0);
+        }
+    }
+
+    // З кешем: A -> R4 -> B доходить завжди, через R3 - якщо R3 спершу почув
+    // R1 або R2, а не R4. Кожен ретранслятор пересилає пакет рівно раз: R3 чує
+    // три копії (від R1, R2 і R4), дві зупиняє кеш, як і зворотні копії в R1/R2
+    run(&at_b, false);
+    for (int i = 0; i < PACKETS; i++) {
+        CHECK(at_b.copies[i] >= 1 && at_b.copies[i] <= 2);
+    }
+    CHECK_EQ(at_b.hops[1], PACKETS);
+    for (int r = 1; r <= RELAYS; r++) {
+        CHECK_EQ(fw[r].forwarded, PACKETS);
+        CHECK_EQ(fw[r].malformed, 0);
+        CHECK_EQ(fw[r].hop_limited, 0);
+        printf("forwarder: cache, R%d forwarded %u, duplicates %u\n", r, fw[r].forwarded, fw[r].duplicates);
+    }
+    CHECK_EQ(fw[3].duplicates, 2 * PACKETS);
+    CHECK(fw[1].duplicates + fw[2].duplicates >= PACKETS);
+
+    // Без кешу петля A -> R1/R2 -> R3 -> R4 -> A крутила б пакет вічно;
+    // на FORWARDER_MAX_HOPS він зупиняється, мережа затихає. Ретранслятори
+    // чують 3 копії з 0 переходів, 5 з одним і 8 з двома - пересилаються
+    // лише вони, 14 копій з трьома переходами відкидаються
+    _Static_assert(FORWARDER_MAX_HOPS == 3, "copy counts below are for three hops");
+    run(&at_b, true);
+    uint32_t forwarded = 0, limited = 0;
+    for (int r = 1; r <= RELAYS; r++) {
+        CHECK_EQ(fw[r].duplicates, 0);
+        forwarded += fw[r].forwarded;
+        limited += fw[r].hop_limited;
+    }
+    CHECK_EQ(forwarded, (3 + 5 + 8) * PACKETS);
+    CHECK_EQ(limited, 14 * PACKETS);
+    CHECK(at_b.hops[FORWARDER_MAX_HOPS] > 0);
+    printf("forwarder: no cache, %u forwarded, %u dropped at %d hops\n", forwarded, limited, FORWARDER_MAX_HOPS);
+
+    // Межа на окремому пакеті: з FORWARDER_MAX_HOPS - 1 ще пересилається,
+    // з FORWARDER_MAX_HOPS - ні, і буфер тоді не змінюється
+    uint8_t pkt[PKT_HEADER_SIZE];
+    forwarder_t lone;
+    pkt_header_t h = {.type = PKT_TYPE_AUDIO, .group = 1, .node = 7, .seq = 1, .hops = FORWARDER_MAX_HOPS - 1};
+    forwarder_init(&lone, FORWARDER_MAX_HOPS);
+    size_t n = pkt_write_header(pkt, &h);
+    CHECK(forwarder_accept(&lone, pkt, n, 0));
+    CHECK_EQ(pkt[PKT_HOPS_OFFSET], FORWARDER_MAX_HOPS);
+    h.seq = 2;
+    h.hops = FORWARDER_MAX_HOPS;
+    n = pkt_write_header(pkt, &h);
+    CHECK(!forwarder_accept(&lone, pkt, n, 0));
+    CHECK_EQ(pkt[PKT_HOPS_OFFSET], FORWARDER_MAX_HOPS);
+    CHECK_EQ(lone.hop_limited, 1);
+
+    // Той самий пакет у вікні кешу - дублікат, після вікна - знову новий
+    h.seq = 1;
+    h.hops = 0;
+    n = pkt_write_header(pkt, &h);
+    CHECK(!forwarder_accept(&lone, pkt, n, FORWARDER_WINDOW_MS));
+    CHECK(forwarder_accept(&lone, pkt, n, FORWARDER_WINDOW_MS + 1));
+
+    for (int j = 0; j < port_count; j++) {
+        close(ports[j].sock);
+    }
+    mbedtls_aes_free(&aes);
+    printf("forwarder: ok\n");
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Обмежений прийом: потік датаграм на сокет рушія не затримує таймери.
+// За одну ітерацію net_engine_poll забирає не більше NET_RX_BURST датаграм,
+// після чого спрацьовують прострочені таймери, а решта датаграм лишається
+// в сокеті до наступних ітерацій і не губиться.
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "check.h"
+#include "net_engine.h"
+
+#define FLOOD 64
+#define SKIP_RC 77
+
+static int rx_count;
+static int timer_count;
+static int rx_at_timer = -1;    // Скільки датаграм прийнято до першого спрацювання таймера
+
+static void on_rx(void *ctx, uint8_t *data, size_t len, const struct sockaddr_in *from)
+{
+    rx_count++;
+}
+
+static void on_timer(void *ctx, uint32_t now_ms)
+{
+    if (timer_count++ == 0) {
+        rx_at_timer = rx_count;
+    }
+}
+
+int main(void)
+{
+    net_engine_t ne;
+    if (net_engine_init(&ne, 0, 0) < 0) {
+        return SKIP_RC;
+    }
+    net_engine_set_rx(&ne, on_rx, NULL);
+    CHECK(net_engine_add_timer(&ne, 1, on_timer, NULL) >= 0);
+
+    struct sockaddr_in dest;
+    socklen_t dlen = sizeof(dest);
+    CHECK_EQ(getsockname(ne.sock, (struct sockaddr *)&dest, &dlen), 0);
+    dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int tx = socket(AF_INET, SOCK_DGRAM, 0);
+    CHECK(tx >= 0);
+    uint8_t buf[200];
+    memset(buf, 0xA5, sizeof(buf));
+    for (int i = 0; i < FLOOD; i++) {
+        CHECK_EQ(sendto(tx, buf, sizeof(buf), 0, (struct sockaddr *)&dest, sizeof(dest)), (ssize_t)sizeof(buf));
+    }
+    usleep(5000);               // Таймер прострочено, усі датаграми вже в сокеті
+
+    CHECK_EQ(net_engine_poll(&ne, 0), 0);
+    CHECK_EQ(rx_count, NET_RX_BURST);
+    CHECK_EQ(timer_count, 1);
+    CHECK_EQ(rx_at_timer, NET_RX_BURST);
+    CHECK_EQ(ne.rx_bursts, 1u);
+
+    // Решта потоку вибирається наступними ітераціями
+    for (int i = 0; i < FLOOD && rx_count < FLOOD; i++) {
+        CHECK_EQ(net_engine_poll(&ne, 10), 0);
+    }
+    CHECK_EQ(rx_count, FLOOD);
+    CHECK_EQ(ne.rx_packets, (uint32_t)FLOOD);
+
+    close(tx);
+    net_engine_close(&ne);
+    printf("net_engine: %d datagrams, burst %d, %d timer runs\n", FLOOD, NET_RX_BURST, timer_count);
+    return 0;
+}
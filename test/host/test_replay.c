@@ -0,0 +1,187 @@
+// Стан повторів відправників поза таблицею сусідів: вікно переживає
+// видалення сусіда, новий запуск скидає вікна лише раз, записаний маяк
+// старого запуску їх не скидає, записаний пакет не проходить після оберту
+// номера, а тег прив'язаний до запуску відправника.
+#include <string.h>
+
+#include "check.h"
+#include "packet.h"
+#include "peer_table.h"
+#include "replay.h"
+
+#define NODE 0x0A0B
+#define BOOT1 0x11111111u
+#define BOOT2 0x22222222u
+#define FRAME_MS 11             // Мітка часу аудіо пакета: номер * FRAME_MS
+
+static void test_survives_peer_expiry(void)
+{
+    replay_table_t rt;
+    peer_table_t pt;
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+
+    replay_table_init(&rt);
+    peer_table_init(&pt);
+    CHECK(replay_table_find(&rt, NODE) == NULL);
+
+    // Маяк, далі аудіо 10..20
+    CHECK_EQ(replay_table_check_boot(&rt, NODE, BOOT1), REPLAY_BOOT_NEW);
+    replay_node_t *n = replay_table_set_boot(&rt, NODE, BOOT1, 0);
+    peer_table_touch(&pt, NODE, &addr, 0);
+    for (uint16_t seq = 10; seq <= 20; seq++) {
+        CHECK_EQ(replay_check(&n->audio, seq, seq * FRAME_MS), REPLAY_OK);
+        replay_accept(&n->audio, seq, seq * FRAME_MS);
+    }
+
+    // Сусіда видалено за мовчанням - вікно лишилось, записаний пакет не пройде
+    CHECK_EQ(peer_table_expire(&pt, PEER_TIMEOUT_MS + 1, PEER_TIMEOUT_MS), 1);
+    CHECK(peer_table_find(&pt, NODE) == NULL);
+    n = replay_table_find(&rt, NODE);
+    CHECK(n != NULL);
+    CHECK_EQ(replay_check(&n->audio, 15, 15 * FRAME_MS), REPLAY_DUPLICATE);
+    CHECK_EQ(replay_check(&n->audio, 21, 21 * FRAME_MS), REPLAY_OK);
+
+    // Маяк того ж запуску вікон не чіпає
+    CHECK_EQ(replay_table_check_boot(&rt, NODE, BOOT1), REPLAY_BOOT_SAME);
+    replay_table_set_boot(&rt, NODE, BOOT1, 100);
+    CHECK_EQ(replay_check(&n->audio, 15, 15 * FRAME_MS), REPLAY_DUPLICATE);
+}
+
+// Після 40000 новіших пакетів 16-бітний номер записаного пакета знову
+// "попереду" вікна - відкидає його лише мітка часу
+static void test_seq_wrap(void)
+{
+    replay_t r;
+    uint16_t seq = 100;
+    uint32_t ts = 50000;
+    const uint16_t captured_seq = seq;
+    const uint32_t captured_ts = ts;
+
+    replay_init(&r);
+    for (int i = 0; i <= 40000; i++, seq++, ts += FRAME_MS) {
+        if (i == 40000 - 5) {
+            continue;   // Прийде із запізненням
+        }
+        CHECK_EQ(replay_check(&r, seq, ts), REPLAY_OK);
+        replay_accept(&r, seq, ts);
+    }
+    uint16_t top = seq - 1;
+    CHECK((int16_t)(captured_seq - top) > 0);
+    CHECK_EQ(replay_check(&r, captured_seq, captured_ts), REPLAY_TOO_OLD);
+    CHECK_EQ(r.too_old, 1);
+
+    // Перестановка в межах вікна і далі проходить, навіть із запізненням у часі
+    uint16_t late = top - 5;
+    CHECK_EQ(replay_check(&r, late, ts - 6 * FRAME_MS), REPLAY_OK);
+    replay_accept(&r, late, ts - 6 * FRAME_MS);
+    CHECK_EQ(replay_check(&r, late, ts - 6 * FRAME_MS), REPLAY_DUPLICATE);
+    // Пакет у вікні за номером, але старший за REPLAY_WINDOW_MS за часом
+    CHECK_EQ(replay_check(&r, top - 3, ts - REPLAY_WINDOW_MS - FRAME_MS - 1), REPLAY_TOO_OLD);
+    CHECK_EQ(replay_check(&r, seq, ts), REPLAY_OK);
+
+    // Годинник відправника обертається: нова мітка менша, але новіша
+    replay_init(&r);
+    replay_accept(&r, 1, 0xFFFFFFF0u);
+    CHECK_EQ(replay_check(&r, 2, 0x00000010u), REPLAY_OK);
+    replay_accept(&r, 2, 0x00000010u);
+    CHECK_EQ(r.newest_ts, 0x00000010u);
+    CHECK_EQ(replay_check(&r, 3, 0xFFFFFFF0u - REPLAY_WINDOW_MS), REPLAY_TOO_OLD);
+}
+
+static void test_boot_change(void)
+{
+    replay_table_t rt;
+
+    replay_table_init(&rt);
+    replay_node_t *n = replay_table_set_boot(&rt, NODE, BOOT1, 0);
+    replay_accept(&n->audio, 500, 500 * FRAME_MS);
+    replay_accept(&n->control, 7, 7000);
+    replay_accept(&n->beacon, 3, 3000);
+
+    // Новий запуск: номери почались спочатку, вікна скинуто
+    CHECK_EQ(replay_table_check_boot(&rt, NODE, BOOT2), REPLAY_BOOT_NEW);
+    CHECK(replay_table_set_boot(&rt, NODE, BOOT2, 10) == n);
+    CHECK_EQ(n->boot_id, BOOT2);
+    CHECK(!n->audio.valid && !n->control.valid && !n->beacon.valid);
+    replay_accept(&n->audio, 1, FRAME_MS);
+
+    // Записаний маяк старого запуску відкидається і вікна не скидає
+    CHECK_EQ(replay_table_check_boot(&rt, NODE, BOOT1), REPLAY_BOOT_STALE);
+    CHECK_EQ(rt.stale_boots, 1);
+    CHECK_EQ(replay_check(&n->audio, 1, FRAME_MS), REPLAY_DUPLICATE);
+
+    // Невідомий запуск не приймається зовсім
+    CHECK_EQ(replay_table_check_boot(&rt, NODE, 0), REPLAY_BOOT_STALE);
+    CHECK_EQ(replay_table_check_boot(&rt, NODE + 1, 0), REPLAY_BOOT_STALE);
+
+    // Історія обмежена REPLAY_OLD_BOOTS останніми запусками
+    for (uint32_t b = 1; b <= REPLAY_OLD_BOOTS; b++) {
+        replay_table_set_boot(&rt, NODE, BOOT2 + b, 20 + b);
+    }
+    CHECK_EQ(replay_table_check_boot(&rt, NODE, BOOT2), REPLAY_BOOT_STALE);
+    CHECK_EQ(replay_table_check_boot(&rt, NODE, BOOT1), REPLAY_BOOT_NEW);
+}
+
+static void test_eviction(void)
+{
+    replay_table_t rt;
+
+    replay_table_init(&rt);
+    for (int i = 0; i < REPLAY_NODES; i++) {
+        replay_table_set_boot(&rt, (uint16_t)(100 + i), BOOT1, (uint32_t)i);
+    }
+    CHECK_EQ(rt.evicted, 0);
+
+    // Найдавніший відправник (100) освіжився пакетом - витісняється наступний
+    replay_table_find(&rt, 100)->last_ms = 1000;
+    replay_table_set_boot(&rt, 999, BOOT1, 1001);
+    CHECK_EQ(rt.evicted, 1);
+    CHECK(replay_table_find(&rt, 100) != NULL);
+    CHECK(replay_table_find(&rt, 101) == NULL);
+    CHECK(replay_table_find(&rt, 999) != NULL);
+}
+
+static void test_prefixes(void)
+{
+    uint8_t a[PKT_MAC_PREFIX_SIZE];
+    uint8_t b[PKT_MAC_PREFIX_SIZE];
+    pkt_header_t h = { .type = PKT_TYPE_AUDIO, .group = 1, .hops = 0, .node = NODE, .seq = 9, .timestamp = 1234 };
+    pkt_audio_desc_t d = { .decim_shift = 1, .frames = 2, .fec = true, .key = PKT_AUDIO_KEY_GROUP };
+
+    // Аудіо: той самий пакет іншого запуску автентифікується інакше
+    CHECK_EQ(pkt_write_mac_prefix(a, &h, &d, BOOT1), PKT_MAC_PREFIX_SIZE);
+    CHECK_EQ(pkt_write_mac_prefix(b, &h, &d, BOOT2), PKT_MAC_PREFIX_SIZE);
+    CHECK(memcmp(a, b, PKT_MAC_PREFIX_SIZE) != 0);
+
+    // Службовий: HOPS змінюють ретранслятори, у тег він не входить, запуск - входить
+    uint8_t c[PKT_CONTROL_PREFIX_SIZE];
+    uint8_t e[PKT_CONTROL_PREFIX_SIZE];
+    h.type = PKT_TYPE_FLOOR;
+    CHECK_EQ(pkt_write_control_prefix(c, &h, BOOT1), PKT_CONTROL_PREFIX_SIZE);
+    h.hops = 3;
+    pkt_write_control_prefix(e, &h, BOOT1);
+    CHECK(memcmp(c, e, PKT_CONTROL_PREFIX_SIZE) == 0);
+    pkt_write_control_prefix(e, &h, BOOT2);
+    CHECK(memcmp(c, e, PKT_CONTROL_PREFIX_SIZE) != 0);
+
+    // Маяк переносить повний 32-бітний ідентифікатор запуску
+    pkt_beacon_t bw = { .version = PKT_BEACON_VERSION, .caps = PKT_CAP_AES, .boot_id = 0xDEADBEEF, .sample_rate = 44100 };
+    pkt_beacon_t br;
+    uint8_t buf[PKT_BEACON_SIZE];
+    CHECK_EQ(pkt_write_beacon(buf, &bw), PKT_BEACON_SIZE);
+    CHECK(pkt_read_beacon(buf, sizeof(buf), &br));
+    CHECK_EQ(br.boot_id, 0xDEADBEEF);
+    CHECK_EQ(br.sample_rate, 44100);
+    CHECK(!pkt_read_beacon(buf, sizeof(buf) - 1, &br));
+}
+
+int main(void)
+{
+    test_survives_peer_expiry();
+    test_seq_wrap();
+    test_boot_change();
+    test_eviction();
+    test_prefixes();
+    printf("replay: ok\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+// status_view на справжньому st7789.c з емулятором панелі: після кожної
+// зміни стану екран збігається піксель у піксель з перемальовкою з нуля,
+// незмінний стан не передає нічого, а зміна рядка - лише його смугу.
+#include <string.h>
+
+#include "check.h"
+#include "lcd_emu.h"
+#include "test_font.h"
+#include "status_view.h"
+
+#define WIDTH 135
+#define HEIGHT 240
+#define OFFSETX 52
+#define OFFSETY 40
+
+typedef struct {
+    const char *role, *state, *crypto, *link;
+    uint16_t state_fg, state_bg;
+} screen_t;
+
+static const screen_t steps[] = {
+    {"CLIENT  CH 1", "", "Encryption: ON", "", WHITE, BLUE},
+    {"CLIENT  CH 1", "Waiting", "Encryption: ON", "", BLACK, YELLOW},
+    {"CLIENT  CH 1", "Transmitting", "Encryption: ON", "", WHITE, RED},
+    {"CLIENT  CH 1", "Full-Duplex", "Encryption: ON", "", WHITE, PURPLE},
+    {"CLIENT  CH 1", "Receiving", "Encryption: ON", "Loss 3% RTT 12ms", WHITE, GREEN},
+    {"CLIENT  CH 1", "Receiving", "Encryption: ON (peer)", "Loss 12%", WHITE, GREEN},
+    {"CLIENT  CH 12", "", "Encryption: OFF", "Loss 0%", WHITE, BLUE},
+    {"CLIENT  CH 12", "", "Encryption: OFF", "", WHITE, BLUE},
+    {"CLIENT  CH 12", "Transmitting", "Encryption: OFF", "", WHITE, RED},
+    {"CLIENT  CH 12", "", "Encryption: OFF", "", WHITE, BLUE},
+};
+
+static TFT_t dev;
+static FontxFile fx[2];
+static uint16_t shown[LCD_EMU_SIZE][LCD_EMU_SIZE];
+
+static void apply(status_view_t *v, const screen_t *s)
+{
+    status_view_set(v, STATUS_TITLE, "Walkie-Talkie", WHITE, BLUE);
+    status_view_set(v, STATUS_ROLE, s->role, WHITE, BLUE);
+    status_view_set(v, STATUS_STATE, s->state, s->state_fg, s->state_bg);
+    status_view_set(v, STATUS_CRYPTO, s->crypto, WHITE, BLUE);
+    status_view_set(v, STATUS_LINK, s->link, WHITE, BLUE);
+}
+
+// Кількість пікселів видимої області, що відрізняються від shown
+static int diff_visible(void)
+{
+    int diff = 0;
+    for (int y = OFFSETY; y < OFFSETY + HEIGHT; y++) {
+        for (int x = OFFSETX; x < OFFSETX + WIDTH; x++) {
+            diff += lcd_emu.gram[y][x] != shown[y][x];
+        }
+    }
+    return diff;
+}
+
+int main(void)
+{
+    test_font_init();
+    InitFontxMem(fx, "ILGH16XB", "");
+    CHECK(fx[0].valid);
+
+    spi_master_init(&dev, 23, 18, -1, LCD_EMU_DC, -1, -1);
+    lcdInit(&dev, WIDTH, HEIGHT, OFFSETX, OFFSETY);
+
+    status_view_t v;
+    status_view_init(&v, &dev, fx, WIDTH, HEIGHT, BLUE);
+    lcd_emu_reset(0x5555);
+
+    uint32_t full_bytes = 0;
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        apply(&v, &steps[i]);
+        lcd_emu_reset_counters();
+        int drawn = status_view_flush(&v);
+        uint32_t bytes = lcd_emu.bytes;
+        CHECK(drawn > 0);
+        memcpy(shown, lcd_emu.gram, sizeof(shown));
+
+        // Еталон: той самий стан, намальований з нуля поверх сміття
+        lcd_emu_reset(0x3333);
+        status_view_t ref;
+        status_view_init(&ref, &dev, fx, WIDTH, HEIGHT, BLUE);
+        apply(&ref, &steps[i]);
+        status_view_flush(&ref);
+        full_bytes = lcd_emu.bytes;
+        CHECK_EQ(diff_visible(), 0);
+        memcpy(lcd_emu.gram, shown, sizeof(shown));
+
+        // Зміна стану дешевша за перемальовку всього екрана
+        if (i > 0) {
+            CHECK(bytes * 2 < full_bytes);
+        }
+        printf("step %zu: %d widgets, %u B (full %u B)\n", i, drawn, bytes, full_bytes);
+    }
+
+    // Той самий стан ще раз - нічого не передається
+    lcd_emu_reset_counters();
+    apply(&v, &steps[sizeof(steps) / sizeof(steps[0]) - 1]);
+    CHECK_EQ(status_view_flush(&v), 0);
+    CHECK_EQ(lcd_emu.bytes, 0);
+    CHECK_EQ(diff_visible(), 0);
+
+    printf("status_view: ok\n");
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Розмовна група на loopback: кілька пристроїв на одному порту (NET_OPT_REUSE)
+// у multicast групі, кожен зі своїм net_engine, таблицею сусідів і
+// статистикою на кожного відправника. Кожен чує всіх інших, власні пакети
+// (multicast loopback) відкидає, а втрати одного відправника не
+// змішуються зі статистикою інших.
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "check.h"
+#include "net_engine.h"
+#include "packet.h"
+#include "peer_table.h"
+
+#define DEVICES 4
+#define PORT 47301
+#define GROUP_ADDR "239.0.77.1"
+#define FRAME_MS 10
+#define RUN_MS 400
+#define LOSSY 3                 // Пристрій, що "губить" кожен п'ятий пакет
+#define SKIP_RC 77
+
+typedef struct {
+    net_engine_t ne;
+    uint16_t node;
+    uint16_t seq;
+    uint32_t sent;              // Номерів видано, включно з "загубленими"
+    bool sending;
+    peer_table_t peers;
+    uint32_t own_echoes;
+} device_t;
+
+static device_t dev[DEVICES];
+static struct sockaddr_in group;
+
+static void on_rx(void *ctx, uint8_t *data, size_t len, const struct sockaddr_in *from)
+{
+    device_t *d = ctx;
+    pkt_header_t h;
+    uint32_t now = net_now_ms();
+
+    if (!pkt_read_header(data, len, &h) || h.type != PKT_TYPE_AUDIO) {
+        return;
+    }
+    if (h.node == d->node) {
+        d->own_echoes++;
+        return;
+    }
+    peer_t *p = peer_table_touch(&d->peers, h.node, from, now);
+    link_stats_on_packet(&p->stats, &h, now);
+    link_stats_on_audio(&p->stats, &h, now);
+}
+
+static void on_timer(void *ctx, uint32_t now_ms)
+{
+    device_t *d = ctx;
+    uint8_t buf[PKT_HEADER_SIZE + 64];
+
+    if (!d->sending) {
+        return;
+    }
+    pkt_header_t h = {.type = PKT_TYPE_AUDIO, .group = 1, .node = d->node, .seq = d->seq++, .timestamp = now_ms};
+    d->sent++;
+    if (d == &dev[LOSSY] && h.seq % 5 == 0) {
+        return;
+    }
+    size_t n = pkt_write_header(buf, &h);
+    memset(buf + n, h.seq & 0xFF, sizeof(buf) - n);
+    CHECK(net_engine_send(&d->ne, buf, sizeof(buf), &group));
+}
+
+static void poll_all(uint32_t ms)
+{
+    uint32_t t0 = net_now_ms();
+    while ((uint32_t)(net_now_ms() - t0) < ms) {
+        for (int i = 0; i < DEVICES; i++) {
+            CHECK_EQ(net_engine_poll(&dev[i].ne, 0), 0);
+        }
+        struct timespec ts = {0, 200000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+int main(void)
+{
+    group.sin_family = AF_INET;
+    group.sin_port = htons(PORT);
+    group.sin_addr.s_addr = inet_addr(GROUP_ADDR);
+
+    for (int i = 0; i < DEVICES; i++) {
+        device_t *d = &dev[i];
+        d->node = 0x100 + i;
+        d->seq = 65500;         // Переповнення номера під час тесту
+        d->sending = true;
+        peer_table_init(&d->peers);
+        CHECK_EQ(net_engine_init(&d->ne, PORT, NET_OPT_REUSE), 0);
+        if (net_engine_join_multicast(&d->ne, group.sin_addr.s_addr) != 0) {
+            printf("talk_group: no multicast on this host, skipped\n");
+            return SKIP_RC;
+        }
+        net_engine_set_rx(&d->ne, on_rx, d);
+        CHECK(net_engine_add_timer(&d->ne, FRAME_MS, on_timer, d) >= 0);
+    }
+
+    poll_all(RUN_MS);
+    for (int i = 0; i < DEVICES; i++) {
+        dev[i].sending = false;
+    }
+    poll_all(50);
+
+    for (int i = 0; i < DEVICES; i++) {
+        device_t *d = &dev[i];
+        int known = 0;
+        CHECK(d->own_echoes > 0);
+        for (int k = 0; k < PEER_TABLE_SIZE; k++) {
+            known += d->peers.peers[k].used;
+        }
+        CHECK_EQ(known, DEVICES - 1);
+
+        for (int j = 0; j < DEVICES; j++) {
+            if (j == i) {
+                continue;
+            }
+            peer_t *p = peer_table_find(&d->peers, dev[j].node);
+            CHECK(p != NULL);
+            link_summary_t s;
+            link_stats_summary(&p->stats, &s);
+            // Loopback нічого не губить: втрати - лише пропущені номери відправника
+            uint32_t skipped = j == LOSSY ? (dev[j].sent + 4) / 5 : 0;
+            printf("node %04x <- %04x: received %u lost %u (sent %u)\n",
+                   d->node, dev[j].node, s.rx_received, s.rx_lost, dev[j].sent);
+            CHECK(s.rx_received + s.rx_lost <= dev[j].sent);
+            CHECK(s.rx_received + s.rx_lost + 1 >= dev[j].sent - 1);
+            CHECK(s.rx_lost + 1 >= skipped && s.rx_lost <= skipped);
+            CHECK(s.rx_received > RUN_MS / FRAME_MS / 2);
+        }
+    }
+
+    for (int i = 0; i < DEVICES; i++) {
+        net_engine_close(&dev[i].ne);
+    }
+    printf("talk_group: ok\n");
+    return 0;
+}